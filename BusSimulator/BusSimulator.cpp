@@ -0,0 +1,253 @@
+#include "BusSimulator.h"
+
+#include <QSettings>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRandomGenerator>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+    const QString DEVICE_GROUP_PREFIX = QStringLiteral("device_");
+    const QString REPLY_KEY_PREFIX = QStringLiteral("reply_");
+    const int READ_CHUNK_SIZE = 256;
+}
+
+struct BusSimulator::PImpl
+{
+    int masterFd = -1;
+    QString portName;
+    QSocketNotifier *notifier = nullptr;
+    QByteArray readBuffer;
+    QMap<quint8, Device> devices;
+    QString errorStr;
+
+    mutable QMutex statisticsMutex;
+    Statistics statistics;
+};
+
+BusSimulator::Device::Device() :
+    latencyMs(5),
+    dropRate(0),
+    corruptRate(0)
+{
+
+}
+
+BusSimulator::BusSimulator(QObject *parent) : QObject(parent),
+    m_pimpl(new PImpl)
+{
+
+}
+
+BusSimulator::~BusSimulator()
+{
+    close();
+}
+
+bool BusSimulator::open()
+{
+    if (m_pimpl->masterFd >= 0) {
+        return true;
+    }
+
+    const int fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0) {
+        m_pimpl->errorStr = tr("Не удалось создать псевдотерминал");
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+
+    termios attributes;
+    if (tcgetattr(fd, &attributes) == 0) {
+        cfmakeraw(&attributes);
+        tcsetattr(fd, TCSANOW, &attributes);
+    }
+
+    m_pimpl->masterFd = fd;
+    m_pimpl->portName = QString::fromLocal8Bit(ptsname(fd));
+
+    m_pimpl->notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_pimpl->notifier, &QSocketNotifier::activated, this, &BusSimulator::onReadyRead);
+
+    return true;
+}
+
+void BusSimulator::close()
+{
+    if (m_pimpl->masterFd < 0) {
+        return;
+    }
+
+    delete m_pimpl->notifier;
+    m_pimpl->notifier = nullptr;
+
+    ::close(m_pimpl->masterFd);
+    m_pimpl->masterFd = -1;
+    m_pimpl->portName.clear();
+    m_pimpl->readBuffer.clear();
+}
+
+QString BusSimulator::portName() const
+{
+    return m_pimpl->portName;
+}
+
+void BusSimulator::setDevice(quint8 address, const Device &device)
+{
+    m_pimpl->devices.insert(address, device);
+}
+
+QMap<quint8, BusSimulator::Device> BusSimulator::devices() const
+{
+    return m_pimpl->devices;
+}
+
+bool BusSimulator::loadScript(const QString &filename)
+{
+    QSettings script(filename, QSettings::IniFormat);
+    if (script.status() != QSettings::NoError) {
+        m_pimpl->errorStr = tr("Не удалось прочитать сценарий \"%1\"").arg(filename);
+        return false;
+    }
+
+    for (const auto &group : script.childGroups()) {
+        if (!group.startsWith(DEVICE_GROUP_PREFIX)) {
+            continue;
+        }
+
+        bool ok = false;
+        const auto address = group.mid(DEVICE_GROUP_PREFIX.size()).toUInt(&ok, 16);
+        if (!ok || address > 0xFF) {
+            m_pimpl->errorStr = tr("Неверный адрес устройства \"%1\"").arg(group);
+            return false;
+        }
+
+        script.beginGroup(group);
+
+        Device device;
+        device.latencyMs = script.value(QStringLiteral("latency_ms"), device.latencyMs).toUInt();
+        device.dropRate = script.value(QStringLiteral("drop_rate"), device.dropRate).toReal();
+        device.corruptRate = script.value(QStringLiteral("corrupt_rate"), device.corruptRate).toReal();
+
+        for (const auto &key : script.childKeys()) {
+            if (!key.startsWith(REPLY_KEY_PREFIX)) {
+                continue;
+            }
+
+            const auto command = key.mid(REPLY_KEY_PREFIX.size()).toUInt(&ok, 16);
+            const auto reply = QByteArray::fromHex(script.value(key).toString().remove(QLatin1Char(' ')).toLatin1());
+            if (!ok || command > 0xFF || reply.size() != NpFrame::size - 2) {
+                script.endGroup();
+                m_pimpl->errorStr = tr("Неверный ответ \"%1\" устройства \"%2\"").arg(key, group);
+                return false;
+            }
+
+            device.replies.insert(static_cast<quint8>(command),
+                                  NpFrame(static_cast<quint8>(address),
+                                          static_cast<quint8>(reply.at(0)), static_cast<quint8>(reply.at(1)),
+                                          static_cast<quint8>(reply.at(2)), static_cast<quint8>(reply.at(3))));
+        }
+
+        script.endGroup();
+        setDevice(static_cast<quint8>(address), device);
+    }
+
+    return true;
+}
+
+BusSimulator::Statistics BusSimulator::statistics() const
+{
+    QMutexLocker lock(&m_pimpl->statisticsMutex);
+    return m_pimpl->statistics;
+}
+
+QString BusSimulator::lastError() const
+{
+    return m_pimpl->errorStr;
+}
+
+void BusSimulator::onReadyRead()
+{
+    char chunk[READ_CHUNK_SIZE];
+    ssize_t bytesRead = 0;
+
+    while ((bytesRead = ::read(m_pimpl->masterFd, chunk, sizeof(chunk))) > 0) {
+        m_pimpl->readBuffer.append(chunk, static_cast<int>(bytesRead));
+    }
+
+    // Bytes are dropped one by one until buffer starts with valid frame
+    int offset = 0;
+    while (m_pimpl->readBuffer.size() - offset >= NpFrame::size) {
+        const char *data = m_pimpl->readBuffer.constData() + offset;
+        if (!NpFrame::hasValidChecksum(data)) {
+            QMutexLocker lock(&m_pimpl->statisticsMutex);
+            ++m_pimpl->statistics.garbageBytes;
+            ++offset;
+            continue;
+        }
+
+        processFrame(NpFrame::fromRawData(data));
+        offset += NpFrame::size;
+    }
+
+    m_pimpl->readBuffer.remove(0, offset);
+}
+
+void BusSimulator::processFrame(const NpFrame &request)
+{
+    if (!m_pimpl->devices.contains(request.addr())) {
+        return;
+    }
+
+    const Device &device = m_pimpl->devices[request.addr()];
+    auto *random = QRandomGenerator::global();
+
+    NpFrame reply = device.replies.value(request.cmd());
+    if (!reply.isValid() && request.cmd() == 0x1) {
+        reply = NpFrame(request.addr(), 0x2, 0xAA, 0xAA, 0xAA);
+    }
+
+    QMutexLocker lock(&m_pimpl->statisticsMutex);
+    ++m_pimpl->statistics.requests;
+
+    if (!reply.isValid()) {
+        return;
+    }
+
+    if (random->generateDouble() < device.dropRate) {
+        ++m_pimpl->statistics.dropped;
+        return;
+    }
+
+    QByteArray bytes = reply;
+    if (random->generateDouble() < device.corruptRate) {
+        ++m_pimpl->statistics.corrupted;
+        bytes[NpFrame::size - 1] = static_cast<char>(bytes.at(NpFrame::size - 1) ^ 0xFF);
+    }
+
+    ++m_pimpl->statistics.replies;
+    lock.unlock();
+
+    QTimer::singleShot(static_cast<int>(device.latencyMs), Qt::PreciseTimer, this, [this, bytes] {
+        sendReply(bytes);
+    });
+}
+
+void BusSimulator::sendReply(const QByteArray &bytes)
+{
+    if (m_pimpl->masterFd < 0) {
+        return;
+    }
+
+    if (::write(m_pimpl->masterFd, bytes.constData(), static_cast<size_t>(bytes.size())) != bytes.size()) {
+        m_pimpl->errorStr = tr("Не удалось записать ответ в псевдотерминал");
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef BUSSIMULATOR_H
+#define BUSSIMULATOR_H
+
+#include <QObject>
+#include <QMap>
+#include <QScopedPointer>
+
+#include <Device/NpFrame.h>
+
+/**
+ * RS-485 bus with scripted devices behind pseudo-terminal.
+ * Dispatcher opens portName() with software line control,
+ * so replies arriving before it switched to read mode are
+ * lost as on the real half-duplex bus
+ **/
+class BusSimulator final : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(BusSimulator)
+public:
+    struct Device
+    {
+        Device();
+        quint32 latencyMs;
+        qreal dropRate;
+        qreal corruptRate;
+        /**
+         * Reply by request command. Every device answers
+         * ping unless it is overridden here
+         **/
+        QMap<quint8, NpFrame> replies;
+    };
+
+    struct Statistics
+    {
+        quint64 requests = 0;
+        quint64 replies = 0;
+        quint64 dropped = 0;
+        quint64 corrupted = 0;
+        quint64 garbageBytes = 0;
+    };
+
+    explicit BusSimulator(QObject *parent = nullptr);
+    ~BusSimulator();
+
+    bool open();
+    void close();
+    QString portName() const;
+
+    void setDevice(quint8 address, const Device &device);
+    QMap<quint8, Device> devices() const;
+    /**
+     * Reads devices from ini file with group per address:
+     * [device_10] latency_ms, drop_rate, corrupt_rate and
+     * reply_<cmd>=<cmd reg1 reg2 reg3> in hex
+     **/
+    bool loadScript(const QString &filename);
+
+    Statistics statistics() const;
+    QString lastError() const;
+private slots:
+    void onReadyRead();
+private:
+    void processFrame(const NpFrame &request);
+    void sendReply(const QByteArray &bytes);
+
+    struct PImpl;
+    QScopedPointer<PImpl> m_pimpl;
+};
+
+#endif // BUSSIMULATOR_H
@@ -0,0 +1,22 @@
+# Simulator is built on POSIX pseudo-terminals
+requires(unix)
+
+QT       -= gui
+QT       += core serialport
+CONFIG   += console
+CONFIG   -= app_bundle
+TEMPLATE  = app
+TARGET    = BusSimulator
+
+include($$PWD/../Global.pri)
+include($$PWD/../Device/Device.pri)
+
+HEADERS += \
+    BusSimulator.h
+
+SOURCES += \
+    BusSimulator.cpp \
+    main.cpp
+
+DISTFILES += \
+    example.ini
@@ -0,0 +1,246 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+
+#include <NpToolbox/Invoker.h>
+#include <Device/Dispatcher.h>
+#include <Device/NpFrame.h>
+
+#include "BusSimulator.h"
+
+using namespace Nauchpribor;
+
+namespace {
+    struct Measurement
+    {
+        quint8 address = 0;
+        int succeeded = 0;
+        int failed = 0;
+        qint64 totalMs = 0;
+        QVector<qint64> latenciesUs;
+    };
+
+    qint64 percentile(const QVector<qint64> &sorted, int percent)
+    {
+        if (sorted.isEmpty()) {
+            return 0;
+        }
+
+        return sorted.at(qMin(sorted.size() - 1, sorted.size() * percent / 100));
+    }
+
+    Measurement measure(Dispatcher &dispatcher, quint8 address, int iterations, quint32 timeoutMs)
+    {
+        Measurement result;
+        result.address = address;
+        result.latenciesUs.reserve(iterations);
+
+        auto accessor = dispatcher.getAccessor(address);
+        const NpFrame ping(address, 0x1, 0x55, 0x55, 0x55);
+        const NpFrame pingRightResponse(address, 0x2, 0xAA, 0xAA, 0xAA);
+
+        QElapsedTimer total;
+        total.start();
+
+        for (int i = 0; i < iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+
+            const NpFrame response = accessor->writeAndRead(ping, timeoutMs);
+            const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+
+            if (response == pingRightResponse) {
+                ++result.succeeded;
+                result.latenciesUs.append(elapsedUs);
+            } else {
+                ++result.failed;
+            }
+        }
+
+        result.totalMs = total.elapsed();
+        std::sort(result.latenciesUs.begin(), result.latenciesUs.end());
+        return result;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures Dispatcher round trip over simulated RS-485 bus"));
+    parser.addHelpOption();
+
+    const QCommandLineOption scriptOption(QStringLiteral("script"), QStringLiteral("Devices script ini file."),
+                                          QStringLiteral("file"));
+    const QCommandLineOption addressesOption(QStringLiteral("addresses"), QStringLiteral("Addresses to ping, hex."),
+                                             QStringLiteral("list"), QStringLiteral("10,25"));
+    const QCommandLineOption iterationsOption(QStringLiteral("iterations"), QStringLiteral("Round trips per address."),
+                                              QStringLiteral("count"), QStringLiteral("100"));
+    const QCommandLineOption latencyOption(QStringLiteral("latency"), QStringLiteral("Reply latency of unscripted devices, ms."),
+                                           QStringLiteral("ms"), QStringLiteral("5"));
+    const QCommandLineOption timeoutOption(QStringLiteral("timeout"), QStringLiteral("Read timeout, ms."),
+                                           QStringLiteral("ms"), QStringLiteral("1000"));
+    const QCommandLineOption baudRateOption(QStringLiteral("baud-rate"), QStringLiteral("Port baud rate."),
+                                            QStringLiteral("rate"), QStringLiteral("9600"));
+    const QCommandLineOption writeDelayOption(QStringLiteral("write-delay"), QStringLiteral("Dispatcher write delay, ms."),
+                                              QStringLiteral("ms"));
+    // Pseudo-terminal has no transceiver to turn around, so pause and
+    // switch delay are short. Replies arriving before dispatcher enters
+    // read mode are dropped, so latency must exceed their sum
+    const QCommandLineOption writePauseOption(QStringLiteral("write-pause"), QStringLiteral("Dispatcher write pause, ms."),
+                                              QStringLiteral("ms"), QStringLiteral("1"));
+    const QCommandLineOption modeSwitchDelayOption(QStringLiteral("mode-switch-delay"),
+                                                   QStringLiteral("Dispatcher write mode switch delay, ms."),
+                                                   QStringLiteral("ms"), QStringLiteral("1"));
+    const QCommandLineOption frameIntervalOption(QStringLiteral("frame-interval"), QStringLiteral("Dispatcher frame interval, ms."),
+                                                 QStringLiteral("ms"));
+
+    parser.addOptions({scriptOption, addressesOption, iterationsOption, latencyOption, timeoutOption, baudRateOption,
+                       writeDelayOption, writePauseOption, modeSwitchDelayOption, frameIntervalOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QVector<quint8> addresses;
+    for (const auto &value : parser.value(addressesOption).split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const auto address = value.trimmed().toUInt(&ok, 16);
+        if (!ok || address > 0xFF) {
+            err << "Invalid address: " << value << '\n';
+            return 1;
+        }
+
+        addresses.append(static_cast<quint8>(address));
+    }
+
+    auto simulator = new BusSimulator;
+
+    BusSimulator::Device defaultDevice;
+    defaultDevice.latencyMs = parser.value(latencyOption).toUInt();
+    for (auto address : addresses) {
+        simulator->setDevice(address, defaultDevice);
+    }
+
+    if ((parser.isSet(scriptOption) && !simulator->loadScript(parser.value(scriptOption))) ||
+        !simulator->open()) {
+        err << simulator->lastError() << '\n';
+        delete simulator;
+        return 1;
+    }
+
+    // Devices are taken before simulator is moved to own thread
+    const auto devices = simulator->devices();
+
+    QThread simulatorThread;
+    simulator->moveToThread(&simulatorThread);
+    QObject::connect(&simulatorThread, &QThread::finished, simulator, &QObject::deleteLater);
+    simulatorThread.start(QThread::HighestPriority);
+
+    QThread dispatcherThread;
+    auto dispatcher = new Dispatcher;
+    dispatcher->moveToThread(&dispatcherThread);
+    QObject::connect(&dispatcherThread, &QThread::finished, dispatcher, &QObject::deleteLater);
+    dispatcherThread.start(QThread::HighestPriority);
+
+    Dispatcher::Params params;
+    params.portName = simulator->portName();
+    params.portBaudRate = parser.value(baudRateOption).toUInt();
+    params.softwareLineControl = true;
+
+    if (parser.isSet(writeDelayOption)) {
+        params.writeDelayMs = static_cast<quint16>(parser.value(writeDelayOption).toUInt());
+    }
+
+    params.writePauseMs = static_cast<quint8>(parser.value(writePauseOption).toUInt());
+    params.modeSwitchDelayMs = static_cast<quint16>(parser.value(modeSwitchDelayOption).toUInt());
+
+    for (auto it = devices.cbegin(); it != devices.cend(); ++it) {
+        if (it.value().latencyMs <= params.writePauseMs) {
+            err << "Warning: reply latency " << it.value().latencyMs << " ms of device " << QString::number(it.key(), 16)
+                << " doesn't exceed write pause " << static_cast<int>(params.writePauseMs) << " ms, replies will be lost" << '\n';
+        }
+    }
+
+    if (parser.isSet(frameIntervalOption)) {
+        params.frameIntervalMs = static_cast<quint8>(parser.value(frameIntervalOption).toUInt());
+    }
+
+    int exitCode = 0;
+
+    if (!Toolbox::Invoker::run(dispatcher, &Dispatcher::open, params).result() ||
+        !Toolbox::Invoker::run(dispatcher, &Dispatcher::reset).result()) {
+        err << dispatcher->lastError() << '\n';
+        exitCode = 1;
+    } else {
+        out << "Port: " << params.portName
+            << " baud rate: " << params.portBaudRate
+            << " write delay: " << params.writeDelayMs
+            << " write pause: " << static_cast<int>(params.writePauseMs)
+            << " mode switch delay: " << params.modeSwitchDelayMs
+            << " frame interval: " << static_cast<int>(params.frameIntervalMs) << '\n';
+
+        out << "address\tok\tfailed\tmin_us\tavg_us\tp50_us\tp99_us\tmax_us\ttrips_per_s" << '\n';
+
+        const int iterations = parser.value(iterationsOption).toInt();
+        const quint32 timeoutMs = parser.value(timeoutOption).toUInt();
+
+        for (auto address : addresses) {
+            const auto result = measure(*dispatcher, address, iterations, timeoutMs);
+
+            qint64 sumUs = 0;
+            for (auto latencyUs : result.latenciesUs) {
+                sumUs += latencyUs;
+            }
+
+            const auto &latencies = result.latenciesUs;
+            out << QString::number(address, 16) << '\t'
+                << result.succeeded << '\t'
+                << result.failed << '\t'
+                << (latencies.isEmpty() ? 0 : latencies.first()) << '\t'
+                << (latencies.isEmpty() ? 0 : sumUs / latencies.size()) << '\t'
+                << percentile(latencies, 50) << '\t'
+                << percentile(latencies, 99) << '\t'
+                << (latencies.isEmpty() ? 0 : latencies.last()) << '\t'
+                << (result.totalMs > 0 ? iterations * 1000.0 / result.totalMs : 0.0) << '\n';
+
+            if (result.failed) {
+                exitCode = 2;
+            }
+        }
+
+        const auto dispatcherStatistics = dispatcher->statistics();
+        for (auto it = dispatcherStatistics.cbegin(); it != dispatcherStatistics.cend(); ++it) {
+            out << "Accessor " << QString::number(it.key(), 16) << '\n'
+                << "  queue wait: " << it.value().queueWait.toString() << '\n'
+                << "  mode switch: " << it.value().modeSwitch.toString() << '\n'
+                << "  write delay: " << it.value().writeDelay.toString() << '\n'
+                << "  write: " << it.value().write.toString() << '\n'
+                << "  turnaround: " << it.value().turnaround.toString() << '\n'
+                << "  timeouts: " << it.value().timeouts
+                << " invalid frames: " << it.value().invalidFrames << '\n';
+        }
+
+        const auto statistics = simulator->statistics();
+        out << "Simulator requests: " << statistics.requests
+            << " replies: " << statistics.replies
+            << " dropped: " << statistics.dropped
+            << " corrupted: " << statistics.corrupted
+            << " garbage bytes: " << statistics.garbageBytes << '\n';
+    }
+
+    Toolbox::Invoker::run(dispatcher, &Dispatcher::close).waitForFinished();
+
+    dispatcherThread.quit();
+    dispatcherThread.wait();
+    simulatorThread.quit();
+    simulatorThread.wait();
+
+    return exitCode;
+}
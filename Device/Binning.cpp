@@ -0,0 +1,126 @@
+#include "Binning.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+
+#include "ParallelFor.h"
+
+namespace {
+    const int MIN_ROWS_PER_BLOCK = 16;
+    const int STACK_LINE_SIZE = 8192;
+
+    /**
+     * Sums bx blocks of line summed over block rows. Partial block
+     * is left to caller, so loop has no edge checks and compiler
+     * unrolls it for known factors
+     **/
+    template <int BX>
+    void reduceFullBlocks(const float *line, int blocks, float scale, float *dst)
+    {
+        for (int bx = 0; bx < blocks; ++bx) {
+            const float *block = line + bx * BX;
+            float value = 0;
+            for (int k = 0; k < BX; ++k) {
+                value += block[k];
+            }
+            dst[bx] = value * scale;
+        }
+    }
+
+    template <int BX>
+    void reduceFullBlocksFlipped(const float *line, int width, int blocks, float scale, float *dst)
+    {
+        for (int bx = 0; bx < blocks; ++bx) {
+            const float *block = line + width - (bx + 1) * BX;
+            float value = 0;
+            for (int k = 0; k < BX; ++k) {
+                value += block[k];
+            }
+            dst[bx] = value * scale;
+        }
+    }
+
+    void reduceFullBlocks(const float *line, int width, int binX, bool flip, float scale, float *dst)
+    {
+        const int blocks = width / binX;
+
+        switch (flip ? -binX : binX) {
+        case 1: reduceFullBlocks<1>(line, blocks, scale, dst); return;
+        case 2: reduceFullBlocks<2>(line, blocks, scale, dst); return;
+        case 3: reduceFullBlocks<3>(line, blocks, scale, dst); return;
+        case 4: reduceFullBlocks<4>(line, blocks, scale, dst); return;
+        case -1: reduceFullBlocksFlipped<1>(line, width, blocks, scale, dst); return;
+        case -2: reduceFullBlocksFlipped<2>(line, width, blocks, scale, dst); return;
+        case -3: reduceFullBlocksFlipped<3>(line, width, blocks, scale, dst); return;
+        case -4: reduceFullBlocksFlipped<4>(line, width, blocks, scale, dst); return;
+        default:
+            break;
+        }
+
+        for (int bx = 0; bx < blocks; ++bx) {
+            const float *block = line + (flip ? width - (bx + 1) * binX : bx * binX);
+            float value = 0;
+            for (int k = 0; k < binX; ++k) {
+                value += block[k];
+            }
+            dst[bx] = value * scale;
+        }
+    }
+}
+
+int Binning::binnedSize(int size, int bin)
+{
+    return (size + bin - 1) / bin;
+}
+
+void Binning::binRows(const float *src, int width, int height, int binX, int binY,
+                      bool sum, bool flip, int firstRow, int rows, float *dst)
+{
+    const int binnedWidth = binnedSize(width, binX);
+    const int fullBlocks = width / binX;
+    const int tail = width % binX;
+
+    // Rows of block are summed first, so horizontal pass
+    // reads one line whatever vertical factor is
+    QVarLengthArray<float, STACK_LINE_SIZE> accumulator(binY > 1 ? width : 0);
+
+    for (int row = firstRow; row < firstRow + rows; ++row, dst += binnedWidth) {
+        const int y = row * binY;
+        const int remainsY = qMin(height - y, binY);
+        const float *line = src + y * width;
+
+        if (remainsY > 1) {
+            float *acc = accumulator.data();
+            std::copy(line, line + width, acc);
+            for (int yy = 1; yy < remainsY; ++yy) {
+                const float *next = line + yy * width;
+                for (int x = 0; x < width; ++x) {
+                    acc[x] += next[x];
+                }
+            }
+            line = acc;
+        }
+
+        reduceFullBlocks(line, width, binX, flip, sum ? 1.f : 1.f / (binX * remainsY), dst);
+
+        if (tail) {
+            const float *block = flip ? line : line + fullBlocks * binX;
+            float value = 0;
+            for (int k = 0; k < tail; ++k) {
+                value += block[k];
+            }
+            dst[fullBlocks] = sum ? value : value / (tail * remainsY);
+        }
+    }
+}
+
+void Binning::bin(const float *src, int width, int height, int binX, int binY,
+                  bool sum, bool flip, float *dst)
+{
+    const int binnedWidth = binnedSize(width, binX);
+
+    ParallelFor::run(binnedSize(height, binY), MIN_ROWS_PER_BLOCK, [=](int, int begin, int end) {
+        binRows(src, width, height, binX, binY, sum, flip, begin, end - begin, dst + begin * binnedWidth);
+    });
+}
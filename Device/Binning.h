@@ -0,0 +1,32 @@
+#ifndef DEVICE_BINNING_H
+#define DEVICE_BINNING_H
+
+#include "DeviceGlobal.h"
+
+/**
+ * Frame binning by binX x binY blocks. Partial blocks at the
+ * right and bottom edges sum or average existing pixels only
+ **/
+class DEVICELIB_EXPORT Binning final
+{
+public:
+    static int binnedSize(int size, int bin);
+
+    /**
+     * Bins output rows [firstRow, firstRow + rows) into dst of
+     * binned width in the calling thread. Flipped source line is
+     * read backwards, so blocks are aligned to its right edge.
+     * Factors up to 4 have dedicated kernels
+     **/
+    static void binRows(const float *src, int width, int height, int binX, int binY,
+                        bool sum, bool flip, int firstRow, int rows, float *dst);
+    /**
+     * Bins the whole frame with output rows split between threads
+     **/
+    static void bin(const float *src, int width, int height, int binX, int binY,
+                    bool sum, bool flip, float *dst);
+private:
+    Binning() = delete;
+};
+
+#endif // DEVICE_BINNING_H
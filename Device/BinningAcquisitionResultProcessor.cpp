@@ -1,5 +1,7 @@
 #include "BinningAcquisitionResultProcessor.h"
 
+#include "Binning.h"
+
 BinningAcquisitionResultProcessor::BinningAcquisitionResultProcessor() :
     m_x(0),
     m_y(0),
@@ -25,37 +27,22 @@ void BinningAcquisitionResultProcessor::setSum(bool sum)
 
 void BinningAcquisitionResultProcessor::process(Scanner::AcquisitionResult &result) const
 {
-    if (result.width > 0 && m_x >= 0 && m_y >= 0 && (m_x >= 1 || m_y >= 1)) {
-        QVector<float> binningResult;
-        const QVector<float> &binningSource = result.image;
+    if (result.width > 0 && result.image.size() >= result.width &&
+        m_x >= 0 && m_y >= 0 && (m_x >= 1 || m_y >= 1)) {
         const int width = result.width;
-        const int height = binningSource.size() / width;
-        int binningHeight = 0;
-
-        for (int y = 0; y < height; y += (m_y + 1)) {
-            for (int x = 0; x < width; x += (m_x + 1)) {
-                float value = 0;
-                const int remainsY = qMin(height - y - 1, m_y) + 1;
-                const int remainsX = qMin(width - x - 1, m_x) + 1;
-                const int remains  = remainsY * remainsX;
-                for (int yy = 0; yy < remainsY; ++yy) {
-                    for (int xx = 0; xx < remainsX; ++xx) {
-                        value += binningSource.at((y + yy) * width + x + xx) / (m_sum ? 1 : remains);
-                    }
-                }
-
-                binningResult.append(value);
-            }
-
-            binningHeight++;
-        }
+        const int height = result.image.size() / width;
+        const int binningWidth = Binning::binnedSize(width, m_x + 1);
+        const int binningHeight = Binning::binnedSize(height, m_y + 1);
+
+        QVector<float> binningResult(binningWidth * binningHeight);
+        Binning::bin(result.image.constData(), width, height, m_x + 1, m_y + 1, m_sum, false, binningResult.data());
 
         QSizeF binningPixelSize = result.pixelSize;
         binningPixelSize.setWidth(binningPixelSize.width() * (m_x + 1));
         binningPixelSize.setHeight(binningPixelSize.height() * (m_y + 1));
 
         result.image = binningResult;
-        result.width = binningResult.size() / binningHeight;
+        result.width = binningWidth;
         result.pixelSize = binningPixelSize;
     }
 }
@@ -0,0 +1,132 @@
+#ifndef DEVICE_BUFFERPOOL_H
+#define DEVICE_BUFFERPOOL_H
+
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSharedPointer>
+#include <QVector>
+
+/**
+ * Pool of large vectors reused between captures. Recycling passes
+ * ownership to pool, so caller recycles only vectors it doesn't share.
+ * Vector shared anyway is never overwritten under its readers,
+ * it is copied on first write as any implicitly shared one
+ **/
+template <typename T>
+class BufferPool final
+{
+    Q_DISABLE_COPY(BufferPool)
+public:
+    explicit BufferPool(int maxBuffers = 4) : m_maxBuffers(maxBuffers) {}
+
+    /**
+     * Vector of size elements. Contents of reused
+     * vector are left from previous capture
+     **/
+    QVector<T> acquire(int size)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        int found = -1;
+        for (int i = 0; i < m_buffers.size(); ++i) {
+            const QVector<T> &buffer = m_buffers.at(i);
+            if (buffer.capacity() >= size &&
+                (found < 0 || buffer.capacity() < m_buffers.at(found).capacity())) {
+                found = i;
+            }
+        }
+
+        QVector<T> buffer;
+        if (found >= 0) {
+            buffer = m_buffers.takeAt(found);
+        } else {
+            buffer.reserve(sizeClass(size));
+        }
+
+        locker.unlock();
+
+        buffer.resize(size);
+        return buffer;
+    }
+
+    /**
+     * Buffer must not be shared with anyone
+     * who reads it after this call
+     **/
+    void recycle(QVector<T> buffer)
+    {
+        if (buffer.capacity() == 0) {
+            return;
+        }
+
+        QMutexLocker locker(&m_mutex);
+
+        for (const QVector<T> &pooled : qAsConst(m_buffers)) {
+            if (pooled.constData() == buffer.constData()) {
+                return;
+            }
+        }
+
+        // Oldest buffers are dropped first
+        if (m_buffers.size() >= m_maxBuffers) {
+            m_buffers.removeFirst();
+        }
+
+        m_buffers.append(buffer);
+    }
+
+    void clear()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_buffers.clear();
+    }
+private:
+    /** Rounds size up to a power of two step not exceeding 1/8 of it **/
+    static int sizeClass(int size)
+    {
+        int step = 1;
+        while (step * 2 <= size / 8) {
+            step *= 2;
+        }
+
+        return (size + step - 1) / step * step;
+    }
+
+    QMutex m_mutex;
+    QList<QVector<T>> m_buffers;
+    int m_maxBuffers;
+};
+
+/**
+ * Vector returned to pool when the last shared pointer to it
+ * is destroyed, so frames handed out to many holders are recycled
+ * once all of them are done. Pool is referenced weakly, buffer
+ * outliving it is freed. Buffer without pool is never recycled
+ **/
+template <typename T>
+class PooledBuffer final
+{
+    Q_DISABLE_COPY(PooledBuffer)
+public:
+    PooledBuffer(const QVector<T> &buffer, const QWeakPointer<BufferPool<T>> &pool) :
+        m_buffer(buffer),
+        m_pool(pool)
+    {
+
+    }
+
+    ~PooledBuffer()
+    {
+        if (const auto pool = m_pool.toStrongRef()) {
+            pool->recycle(std::move(m_buffer));
+        }
+    }
+
+    const QVector<T> &buffer() const { return m_buffer; }
+private:
+    QVector<T> m_buffer;
+    const QWeakPointer<BufferPool<T>> m_pool;
+};
+
+#endif // DEVICE_BUFFERPOOL_H
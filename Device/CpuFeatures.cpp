@@ -0,0 +1,83 @@
+#include "CpuFeatures.h"
+
+#if defined(DEVICE_SIMD_X86) && defined(Q_CC_MSVC)
+#  include <intrin.h>
+#endif
+
+namespace {
+    enum Feature {
+        FeatureSse41 = 0x01,
+        FeatureAvx2 = 0x02
+    };
+
+    int detectFeatures()
+    {
+        int features = 0;
+
+#if defined(DEVICE_SIMD_X86) && defined(Q_CC_MSVC)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        if (info[2] & (1 << 19)) {
+            features |= FeatureSse41;
+        }
+
+        // AVX2 also requires OS support of YMM registers saving
+        const bool osAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                           (_xgetbv(0) & 0x06) == 0x06;
+
+        if (osAvx && maxLeaf >= 7) {
+            __cpuidex(info, 7, 0);
+            if (info[1] & (1 << 5)) {
+                features |= FeatureAvx2;
+            }
+        }
+#elif defined(DEVICE_SIMD_X86) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG))
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.1")) {
+            features |= FeatureSse41;
+        }
+
+        if (__builtin_cpu_supports("avx2")) {
+            features |= FeatureAvx2;
+        }
+#endif
+
+        return features;
+    }
+
+    int featuresLimit = FeatureSse41 | FeatureAvx2;
+
+    int features()
+    {
+        static const int f = detectFeatures();
+        return f & featuresLimit;
+    }
+}
+
+bool CpuFeatures::hasSse41()
+{
+    return features() & FeatureSse41;
+}
+
+bool CpuFeatures::hasAvx2()
+{
+    return features() & FeatureAvx2;
+}
+
+void CpuFeatures::setLimit(CpuFeatures::Level level)
+{
+    switch (level) {
+    case Scalar:
+        featuresLimit = 0;
+        break;
+    case Sse41:
+        featuresLimit = FeatureSse41;
+        break;
+    case Avx2:
+        featuresLimit = FeatureSse41 | FeatureAvx2;
+        break;
+    }
+}
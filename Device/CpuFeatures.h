@@ -0,0 +1,45 @@
+#ifndef DEVICE_CPUFEATURES_H
+#define DEVICE_CPUFEATURES_H
+
+#include "DeviceGlobal.h"
+
+#if defined(Q_PROCESSOR_X86)
+#  define DEVICE_SIMD_X86
+#  include <immintrin.h>
+#endif
+
+/**
+ * GCC and Clang need target attribute for functions
+ * using intrinsics not enabled by compiler flags
+ **/
+#if defined(DEVICE_SIMD_X86) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG))
+#  define DEVICE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#  define DEVICE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#  define DEVICE_TARGET_SSE41
+#  define DEVICE_TARGET_AVX2
+#endif
+
+class DEVICELIB_EXPORT CpuFeatures final
+{
+public:
+    enum Level {
+        Scalar,
+        Sse41,
+        Avx2
+    };
+
+    static bool hasSse41();
+    static bool hasAvx2();
+
+    /**
+     * Test hook limiting instruction sets reported to kernels.
+     * Kernels are selected on first use, so it is called before
+     * any of them runs
+     **/
+    static void setLimit(Level level);
+private:
+    CpuFeatures() = delete;
+};
+
+#endif // DEVICE_CPUFEATURES_H
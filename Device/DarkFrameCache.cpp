@@ -0,0 +1,131 @@
+#include "DarkFrameCache.h"
+
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtMath>
+
+#include "DeviceLogging.h"
+
+namespace {
+    // Sites opt in, as only simulated detector reports temperature
+    const qint64 DEFAULT_MAX_AGE_MS = 0;
+    const qreal DEFAULT_MAX_TEMPERATURE_DRIFT = 0.5;
+}
+
+struct DarkFrameCache::PImpl
+{
+    struct Entry
+    {
+        Frame frame;
+        quint32 lines;
+        qreal temperature;
+        QElapsedTimer timer;
+    };
+
+    mutable QMutex mutex;
+    Policy policy;
+    QMap<QString, Entry> entries;
+
+    bool isFresh(const Entry &entry, qreal temperature) const;
+};
+
+bool DarkFrameCache::PImpl::isFresh(const Entry &entry, qreal temperature) const
+{
+    if (entry.timer.elapsed() > policy.maxAgeMs) {
+        return false;
+    }
+
+    if (qIsNaN(entry.temperature)) {
+        return true;
+    }
+
+    // Drift can't be checked once sensor stopped answering
+    return !qIsNaN(temperature) && qAbs(temperature - entry.temperature) <= policy.maxTemperatureDrift;
+}
+
+DarkFrameCache::Policy::Policy() :
+    maxAgeMs(DEFAULT_MAX_AGE_MS),
+    maxTemperatureDrift(DEFAULT_MAX_TEMPERATURE_DRIFT)
+{
+
+}
+
+DarkFrameCache::DarkFrameCache() :
+    m_pimpl(new PImpl)
+{
+
+}
+
+DarkFrameCache::~DarkFrameCache()
+{
+
+}
+
+void DarkFrameCache::setPolicy(const Policy &policy)
+{
+    QMutexLocker locker(&m_pimpl->mutex);
+    m_pimpl->policy = policy;
+
+    if (policy.maxAgeMs <= 0) {
+        m_pimpl->entries.clear();
+    }
+}
+
+DarkFrameCache::Policy DarkFrameCache::policy() const
+{
+    QMutexLocker locker(&m_pimpl->mutex);
+    return m_pimpl->policy;
+}
+
+bool DarkFrameCache::isEnabled() const
+{
+    QMutexLocker locker(&m_pimpl->mutex);
+    return m_pimpl->policy.maxAgeMs > 0;
+}
+
+void DarkFrameCache::store(const QString &scanningMode, quint32 lines, const Frame &frame, qreal temperature)
+{
+    QMutexLocker locker(&m_pimpl->mutex);
+
+    if (m_pimpl->policy.maxAgeMs <= 0 || !frame || frame->buffer().isEmpty()) {
+        return;
+    }
+
+    PImpl::Entry &entry = m_pimpl->entries[scanningMode];
+    entry.frame = frame;
+    entry.lines = lines;
+    entry.temperature = temperature;
+    entry.timer.start();
+}
+
+DarkFrameCache::Frame DarkFrameCache::find(const QString &scanningMode, quint32 lines, qreal temperature) const
+{
+    QMutexLocker locker(&m_pimpl->mutex);
+
+    const auto it = m_pimpl->entries.constFind(scanningMode);
+    if (it == m_pimpl->entries.cend() || it->lines != lines) {
+        return Frame();
+    }
+
+    if (!m_pimpl->isFresh(*it, temperature)) {
+        dbgDevice << "Dark frame of" << scanningMode << "is stale, age" << it->timer.elapsed() << "ms"
+                  << "temperature" << it->temperature << "now" << temperature;
+        return Frame();
+    }
+
+    return it->frame;
+}
+
+void DarkFrameCache::remove(const QString &scanningMode)
+{
+    QMutexLocker locker(&m_pimpl->mutex);
+    m_pimpl->entries.remove(scanningMode);
+}
+
+void DarkFrameCache::clear()
+{
+    QMutexLocker locker(&m_pimpl->mutex);
+    m_pimpl->entries.clear();
+}
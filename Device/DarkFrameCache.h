@@ -0,0 +1,52 @@
+#ifndef DEVICE_DARKFRAMECACHE_H
+#define DEVICE_DARKFRAMECACHE_H
+
+#include "BufferPool.h"
+#include "DeviceGlobal.h"
+
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QString>
+
+/**
+ * Dark frames by scanning mode. Frame is stale when it is
+ * older than max age or detector temperature has drifted
+ * since capture. Detectors without sensor are checked by
+ * age only. Frames are held as pooled buffers, so
+ * evicted one goes back to detector frame pool once
+ * results using it are released
+ **/
+class DEVICELIB_EXPORT DarkFrameCache final
+{
+    Q_DISABLE_COPY(DarkFrameCache)
+public:
+    struct DEVICELIB_EXPORT Policy
+    {
+        Policy();
+        // Zero disables cache, it's disabled by default
+        qint64 maxAgeMs;
+        qreal maxTemperatureDrift;
+    };
+
+    DarkFrameCache();
+    ~DarkFrameCache();
+
+    void setPolicy(const Policy &policy);
+    Policy policy() const;
+    bool isEnabled() const;
+
+    typedef QSharedPointer<PooledBuffer<float>> Frame;
+
+    void store(const QString &scanningMode, quint32 lines, const Frame &frame, qreal temperature);
+    /**
+     * Null frame if there is no fresh frame of such lines
+     **/
+    Frame find(const QString &scanningMode, quint32 lines, qreal temperature) const;
+    void remove(const QString &scanningMode);
+    void clear();
+private:
+    struct PImpl;
+    QScopedPointer<PImpl> m_pimpl;
+};
+
+#endif // DEVICE_DARKFRAMECACHE_H
@@ -1,17 +1,34 @@
 #include "Detector.h"
 
+#include <QElapsedTimer>
+#include <QMetaMethod>
+#include <QMutex>
 #include <QMutexLocker>
+#include <QThread>
+#include <QtMath>
 
 #include <NpToolbox/Atomic.h>
 
+#include "Trace.h"
+
 using namespace Nauchpribor;
 
 struct Detector::PImpl
 {
     quint32 linesCount;
     bool isPrepared;
+    Toolbox::Atomic<quint32> streamBlockLines;
+    Toolbox::Atomic<qreal> temperature;
+    Toolbox::Atomic<bool> xrayOn;
     Toolbox::Atomic<Properties> properties;
-    Toolbox::Atomic<Frame> lastCapturedFrame;
+    // Guarded by mutex instead of Atomic, so take is a single swap
+    mutable QMutex lastCapturedFrameMutex;
+    Frame lastCapturedFrame;
+    // Set once frame is handed out by lastCapturedFrame()
+    bool lastCapturedFrameShared = false;
+    // Shared, so frames handed out keep returning to it while detector lives
+    QSharedPointer<BufferPool<float>> framePool;
+    BufferPool<uchar> rawBufferPool;
 };
 
 Detector::Detector(QObject *parent) : Device(parent),
@@ -19,6 +36,10 @@ Detector::Detector(QObject *parent) : Device(parent),
 {
     m_pimpl->linesCount = 0;
     m_pimpl->isPrepared = false;
+    m_pimpl->streamBlockLines = 0;
+    m_pimpl->temperature = qQNaN();
+    m_pimpl->xrayOn = false;
+    m_pimpl->framePool.reset(new BufferPool<float>);
 }
 
 Detector::~Detector()
@@ -33,12 +54,69 @@ Detector::Properties Detector::properties() const
 
 Detector::Frame Detector::lastCapturedFrame() const
 {
+    QMutexLocker locker(&m_pimpl->lastCapturedFrameMutex);
+    m_pimpl->lastCapturedFrameShared = true;
     return m_pimpl->lastCapturedFrame;
 }
 
+Detector::Frame Detector::takeLastCapturedFrame(bool *owned)
+{
+    Frame frame;
+    QMutexLocker locker(&m_pimpl->lastCapturedFrameMutex);
+    frame.swap(m_pimpl->lastCapturedFrame);
+
+    if (owned) {
+        *owned = !m_pimpl->lastCapturedFrameShared;
+    }
+    m_pimpl->lastCapturedFrameShared = false;
+
+    return frame;
+}
+
+BufferPool<float> &Detector::framePool()
+{
+    return *m_pimpl->framePool;
+}
+
+QWeakPointer<BufferPool<float>> Detector::framePoolReference() const
+{
+    return m_pimpl->framePool;
+}
+
+BufferPool<uchar> &Detector::rawBufferPool()
+{
+    return m_pimpl->rawBufferPool;
+}
+
+void Detector::setStreamBlockLines(quint32 lines)
+{
+    m_pimpl->streamBlockLines = lines;
+}
+
+quint32 Detector::streamBlockLines() const
+{
+    return m_pimpl->streamBlockLines;
+}
+
+qreal Detector::temperature() const
+{
+    return m_pimpl->temperature;
+}
+
+bool Detector::isXrayOn() const
+{
+    return m_pimpl->xrayOn;
+}
+
+void Detector::setXrayOn(bool on)
+{
+    m_pimpl->xrayOn = on;
+}
+
 bool Detector::prepare(quint32 lines)
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Detector::prepare", "detector");
 
     if (!checkIsOpen()) {
         return false;
@@ -61,6 +139,7 @@ bool Detector::prepare(quint32 lines)
 bool Detector::capture()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Detector::capture", "detector");
 
     if (!checkIsOpen()) {
         return false;
@@ -74,13 +153,50 @@ bool Detector::capture()
     m_pimpl->isPrepared = false;
 
     if (doCapture()) {
-        emit captured(m_pimpl->lastCapturedFrame, QPrivateSignal());
+        // Queued receivers keep reference to frame, so it is shared
+        // only if someone listens and takeLastCapturedFrame() would copy
+        if (isSignalConnected(QMetaMethod::fromSignal(&Detector::captured))) {
+            emit captured(lastCapturedFrame(), QPrivateSignal());
+        }
         return true;
     }
 
     return false;
 }
 
+bool Detector::prepareAndCapture(quint32 lines, int delayMs)
+{
+    Q_ASSERT(checkThreadAffinity());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!prepare(lines)) {
+        return false;
+    }
+
+    const qint64 remainingMs = delayMs - timer.elapsed();
+    if (remainingMs > 0) {
+        QThread::msleep(static_cast<unsigned long>(remainingMs));
+    }
+
+    return capture();
+}
+
+bool Detector::refreshTemperature()
+{
+    Q_ASSERT(checkThreadAffinity());
+
+    qreal celsius = 0;
+    if (!isOpen() || !doReadTemperature(celsius)) {
+        m_pimpl->temperature = qQNaN();
+        return false;
+    }
+
+    m_pimpl->temperature = celsius;
+    return true;
+}
+
 quint32 Detector::currentLines() const
 {
     return m_pimpl->linesCount;
@@ -93,12 +209,26 @@ void Detector::setProperties(const Detector::Properties &properties)
 
 void Detector::setLastCapturedFrame(const Frame &frame)
 {
+    QMutexLocker locker(&m_pimpl->lastCapturedFrameMutex);
     m_pimpl->lastCapturedFrame = frame;
+    m_pimpl->lastCapturedFrameShared = false;
+}
+
+void Detector::setCapturedLines(quint32 firstLine, const Frame &lines)
+{
+    emit linesCaptured(firstLine, lines, QPrivateSignal());
+}
+
+bool Detector::doReadTemperature(qreal &celsius)
+{
+    Q_UNUSED(celsius)
+    return false;
 }
 
 void Detector::onClosed()
 {
     m_pimpl->isPrepared = false;
+    m_pimpl->temperature = qQNaN();
     Device::onClosed();
 }
 
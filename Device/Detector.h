@@ -1,6 +1,7 @@
 #ifndef DETECTOR_H
 #define DETECTOR_H
 
+#include "BufferPool.h"
 #include "Device.h"
 
 #include <QVector>
@@ -25,19 +26,80 @@ public:
     ~Detector() override;
     Properties properties() const;
     Frame lastCapturedFrame() const;
+    /**
+     * Moves last captured frame out of detector,
+     * so it can be modified in place without copying
+     * unless receivers of captured() still hold it.
+     * owned is set to false if frame was handed out by
+     * lastCapturedFrame() and must not be recycled
+     **/
+    Frame takeLastCapturedFrame(bool *owned = nullptr);
+
+    /**
+     * Buffers reused between captures. Frames which are not
+     * needed anymore should be returned to frame pool
+     **/
+    BufferPool<float> &framePool();
+    BufferPool<uchar> &rawBufferPool();
+    /**
+     * Frame pool of frames outliving capture, such as
+     * published acquisition results wrapped into PooledBuffer
+     **/
+    QWeakPointer<BufferPool<float>> framePoolReference() const;
+
+    /**
+     * Size of lines blocks emitted by linesCaptured() while
+     * capturing. Zero disables streaming. Detectors which are
+     * not able to stream never emit linesCaptured()
+     **/
+    void setStreamBlockLines(quint32 lines);
+    quint32 streamBlockLines() const;
+
+    /**
+     * Temperature read by last refreshTemperature(),
+     * NaN if detector has no sensor or reading failed
+     **/
+    qreal temperature() const;
+
+    /**
+     * X-ray state set from power supply toggles. Simulated
+     * detectors expose lines only while it is on
+     **/
+    bool isXrayOn() const;
 public slots:
     bool prepare(quint32 lines);
     bool capture();
+    /**
+     * Prepares and captures frame delayMs after call, or right after
+     * preparation if it took longer. Caller doesn't wait for detector
+     * thread between them, e.g. for dark frame after acquisition
+     **/
+    bool prepareAndCapture(quint32 lines, int delayMs);
+    bool refreshTemperature();
+    /**
+     * Thread-safe, may be called from any thread
+     **/
+    void setXrayOn(bool on);
 signals:
     void prepared(QPrivateSignal);
     void captured(Detector::Frame frame, QPrivateSignal);
+    /**
+     * Lines [firstLine, firstLine + lines.size() / width) of the frame
+     * which will be emitted by captured(). Blocks may come in any order
+     **/
+    void linesCaptured(quint32 firstLine, Detector::Frame lines, QPrivateSignal);
 protected:
     quint32 currentLines() const;
     void setProperties(const Properties &properties);
     void setLastCapturedFrame(const Frame &frame);
+    void setCapturedLines(quint32 firstLine, const Frame &lines);
 
     virtual bool doPrepare() = 0;
     virtual bool doCapture() = 0;
+    /**
+     * Detectors with temperature sensor return it in celsius
+     **/
+    virtual bool doReadTemperature(qreal &celsius);
 private:
     void onClosed() override final;
 
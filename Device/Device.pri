@@ -8,5 +8,4 @@ contains(DEFINES, DEVICE_LIBRARY) {
 
 include($$PWD/../3rd-party/NpApplication.pri)
 include($$PWD/../3rd-party/NpToolbox.pri)
-include($$PWD/../3rd-party/OpenCV.pri)
 include($$PWD/../Settings/Settings.pri)
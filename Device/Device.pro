@@ -10,8 +10,12 @@ TEMPLATE  = lib
 include($$PWD/Device.pri)
 
 HEADERS += Scanner.h \
+    Binning.h \
     BinningAcquisitionResultProcessor.h \
+    BufferPool.h \
     CancelationToken.h \
+    CpuFeatures.h \
+    DarkFrameCache.h \
     Detector.h \
     Device.h \
     DeviceConfiguration.h \
@@ -21,18 +25,30 @@ HEADERS += Scanner.h \
     DevicePluginManager.h \
     Dispatcher.h \
     FlipAcquisitionResultProcessor.h \
+    FrameGeometry.h \
+    GeometryAcquisitionResultProcessor.h \
     Hardware.h \
+    LatencyHistogram.h \
+    LineResampler.h \
     NpFrame.h \
+    ParallelFor.h \
+    PixelConversion.h \
     PowerSupply.h \
     FlatFieldCorrection.h \
     ScaleAcquisitionResultProcessor.h \
+    ScannerAcquisitionResultPipeline.h \
     ScannerAcquisitionResultProcessor.h \
     ScannerCalibrationData.h \
-    ScanningModesCollection.h
+    ScanningModesCollection.h \
+    StepGraph.h \
+    Trace.h
 
 SOURCES += Scanner.cpp \
+    Binning.cpp \
     BinningAcquisitionResultProcessor.cpp \
     CancelationToken.cpp \
+    CpuFeatures.cpp \
+    DarkFrameCache.cpp \
     Device.cpp \
     DeviceConfiguration.cpp \
     DeviceLogging.cpp \
@@ -41,11 +57,20 @@ SOURCES += Scanner.cpp \
     Detector.cpp \
     Dispatcher.cpp \
     FlipAcquisitionResultProcessor.cpp \
+    FrameGeometry.cpp \
+    GeometryAcquisitionResultProcessor.cpp \
     Hardware.cpp \
+    LatencyHistogram.cpp \
+    LineResampler.cpp \
     NpFrame.cpp \
+    ParallelFor.cpp \
+    PixelConversion.cpp \
     PowerSupply.cpp \
     FlatFieldCorrection.cpp \
     ScaleAcquisitionResultProcessor.cpp \
+    ScannerAcquisitionResultPipeline.cpp \
     ScannerAcquisitionResultProcessor.cpp \
     ScannerCalibrationData.cpp \
-    ScanningModesCollection.cpp
+    ScanningModesCollection.cpp \
+    StepGraph.cpp \
+    Trace.cpp
@@ -4,24 +4,60 @@
 #include <QTimer>
 #include <QElapsedTimer>
 #include <QThread>
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QFutureInterface>
+#include <QtMath>
+
+#include <limits>
 
 #include <NpToolbox/Invoker.h>
 
 #include "DeviceLogging.h"
+#include "NpFrame.h"
 
 using namespace Nauchpribor;
 
 struct Dispatcher::PImpl
 {
     QSerialPort *port;
+    // Written only by dispatcher thread, which reads it without lock
     Params params;
+    mutable QMutex paramsMutex;
+    bool softwareRts = false;
+    bool softwareDtr = false;
     QString errorStr;
 
     QMutex ioMutex;
 
+    struct BusWaiter
+    {
+        int priority;
+        qint64 deadline;
+        quint64 sequence;
+    };
+
+    // Accessors are queued for the bus instead of racing for ioMutex
+    QMutex busMutex;
+    QWaitCondition busCondition;
+    QList<BusWaiter> busWaiters;
+    quint64 busSequence = 0;
+    bool busAcquired = false;
+    QElapsedTimer busClock;
+
+    // Single thread keeps submitted requests in priority order
+    QThreadPool requestPool;
+    // Cancels submitted requests until dispatcher is open again
+    QAtomicInt closing;
+    // Accessors queue calls to dispatcher thread under this lock only
+    // while not closing, so close() delivers all of them itself
+    QMutex invokeMutex;
+
     QTimer *writeTimeoutTimer;
     QElapsedTimer writeDelayTimer;
     QTimer *processReadBufferTimer;
+    QTimer *statisticsLogTimer;
 
     QByteArray readBuffer;
 
@@ -36,17 +72,140 @@ struct Dispatcher::PImpl
     void startProcessReadBufferTimer();
     void stopProcessReadBufferTimer();
 
+    /**
+     * Run in dispatcher thread unless it's closing. Nothing is
+     * queued there once closing, so close() never waits for it
+     **/
+    bool invokeSetMode(Dispatcher &dispatcher, Mode mode);
+    bool invokeWrite(Dispatcher &dispatcher, const QByteArray &bytes);
+
     void clearAccessorsReadBuffer();
+    void wakeAccessors();
+    void deliverCompleteFrames();
+    bool isNextBusWaiter(quint64 sequence) const;
+};
+
+class Dispatcher::Accessor::BusLocker
+{
+    Q_DISABLE_COPY(BusLocker)
+public:
+    explicit BusLocker(Accessor &accessor) : m_accessor(accessor)
+    {
+        m_accessor.lockBus();
+    }
+
+    ~BusLocker()
+    {
+        m_accessor.unlockBus();
+    }
+private:
+    Accessor &m_accessor;
+};
+
+class Dispatcher::Accessor::RequestTask : public QRunnable
+{
+    Q_DISABLE_COPY(RequestTask)
+public:
+    RequestTask(Accessor &accessor, const Request &request, const CancelationTokenSource::Token &token) :
+        m_accessor(accessor),
+        m_request(request),
+        m_token(token)
+    {
+        m_reply.reportStarted();
+    }
+
+    /** Task removed from pool without running is finished here **/
+    ~RequestTask() override
+    {
+        finish(QByteArray());
+    }
+
+    QFuture<QByteArray> future()
+    {
+        return m_reply.future();
+    }
+
+    void run() override
+    {
+        if (isCanceled()) {
+            return;
+        }
+
+        QByteArray reply;
+        {
+            BusLocker lock(m_accessor);
+
+            if (!isCanceled() && m_accessor.doWrite(m_request.bytes) && m_request.expectsReply) {
+                reply = m_accessor.doRead(m_request.msec, m_request.replyFrames, [this] { return isCanceled(); });
+            }
+        }
+
+        finish(reply);
+    }
+private:
+    bool isCanceled() const
+    {
+        return m_token.isCanceled() || m_reply.isCanceled() || m_accessor.isDispatcherClosing();
+    }
+
+    void finish(const QByteArray &reply)
+    {
+        if (m_reply.isFinished()) {
+            return;
+        }
+
+        // Result is ignored by future canceled by QFuture::cancel(), so
+        // it is reported only before cancelation by token
+        if (!m_reply.isCanceled()) {
+            m_reply.reportResult(reply);
+        }
+
+        if (m_token.isCanceled()) {
+            m_reply.reportCanceled();
+        }
+
+        m_reply.reportFinished();
+    }
+
+    Accessor &m_accessor;
+    const Request m_request;
+    const CancelationTokenSource::Token m_token;
+    QFutureInterface<QByteArray> m_reply;
 };
 
 namespace {
+    const int CALIBRATION_ROUNDS = 5;
+    const qreal CALIBRATION_MARGIN = 1.5;
+    const quint32 CALIBRATION_READ_TIMEOUT_MS = 1000;
+    // Silent interval between frames in characters as in Modbus RTU
+    const qreal FRAME_INTERVAL_CHARS = 3.5;
+    const int BITS_PER_CHAR = 10;
+    const qint64 CANCELATION_CHECK_MS = 50;
+    // Bytes not recognized as frames are delivered after one frame
+    // interval, so burst is over after two intervals of silence
+    const int BURST_SILENCE_INTERVALS = 2;
+
+    /** Calibrated timing never exceeds configured one, zero keeps timing disabled **/
+    quint16 withMargin(qint64 ms, quint16 configured)
+    {
+        if (!configured) {
+            return 0;
+        }
+
+        return static_cast<quint16>(qBound<qint64>(1, qCeil(ms * CALIBRATION_MARGIN), configured));
+    }
+
     class DispatcherWriteWatcher : public QObject
     {
         Q_OBJECT
         Q_DISABLE_COPY(DispatcherWriteWatcher)
     public:
         explicit DispatcherWriteWatcher(Dispatcher *dispatcher, QObject *parent = nullptr);
-        bool wait();
+        /**
+         * Write success is signalled by dispatcher thread event
+         * loop, so wait is sliced to notice cancelation
+         **/
+        bool wait(const std::function<bool()> &isCanceled);
     public slots:
         void onWriteSuccess();
         void onErrorOccurred();
@@ -66,6 +225,9 @@ namespace {
 Dispatcher::Dispatcher(QObject *parent) : QObject(parent),
     m_pimpl(new PImpl)
 {
+    m_pimpl->busClock.start();
+    m_pimpl->requestPool.setMaxThreadCount(1);
+
     m_pimpl->port = new QSerialPort(this);
     m_pimpl->port->setDataBits(QSerialPort::Data8);
     m_pimpl->port->setFlowControl(QSerialPort::NoFlowControl);
@@ -82,6 +244,9 @@ Dispatcher::Dispatcher(QObject *parent) : QObject(parent),
     m_pimpl->processReadBufferTimer->setTimerType(Qt::PreciseTimer);
     connect(m_pimpl->processReadBufferTimer, &QTimer::timeout, this, &Dispatcher::processReadBuffer);
 
+    m_pimpl->statisticsLogTimer = new QTimer(this);
+    connect(m_pimpl->statisticsLogTimer, &QTimer::timeout, this, &Dispatcher::logStatistics);
+
     connect(m_pimpl->port, &QSerialPort::readyRead, this, &Dispatcher::onReadyRead);
     connect(m_pimpl->port, &QSerialPort::bytesWritten, this, &Dispatcher::onBytesWritten);
     connect(m_pimpl->port, &QSerialPort::errorOccurred, this, &Dispatcher::onErrorOccurred);
@@ -89,6 +254,7 @@ Dispatcher::Dispatcher(QObject *parent) : QObject(parent),
 
 Dispatcher::~Dispatcher()
 {
+    // Submitted requests are done when close() returns
     close();
 
     QMutexLocker lock(&m_pimpl->accessorsMutex);
@@ -103,7 +269,7 @@ Dispatcher::Accessor *Dispatcher::getAccessor(quint8 address)
 
     if (!m_pimpl->accessors.contains(address)) {
         infoDevice << "Create new accessor for address:" << QString::number(address, 16);
-        m_pimpl->accessors.insert(address, new Accessor(*this));
+        m_pimpl->accessors.insert(address, new Accessor(*this, address));
     }
 
     return m_pimpl->accessors.value(address);
@@ -111,9 +277,90 @@ Dispatcher::Accessor *Dispatcher::getAccessor(quint8 address)
 
 Dispatcher::Params Dispatcher::params() const
 {
+    QMutexLocker lock(&m_pimpl->paramsMutex);
+
     return m_pimpl->params;
 }
 
+bool Dispatcher::calibrateTimings()
+{
+    Q_ASSERT(QThread::currentThread() != thread());
+
+    infoDevice << "Calibrating dispatcher timings";
+    QMutexLocker lock(&m_pimpl->ioMutex);
+
+    QVector<quint8> addresses;
+    {
+        QMutexLocker accessorsLock(&m_pimpl->accessorsMutex);
+        for (auto it = m_pimpl->accessors.cbegin(); it != m_pimpl->accessors.cend(); ++it) {
+            addresses.append(it.key());
+        }
+    }
+
+    if (addresses.isEmpty()) {
+        errDevice << "No accessors to calibrate timings";
+        setLastError(tr("Нет устройств для калибровки диспетчера"));
+        return false;
+    }
+
+    const Params configured = params();
+    qint64 turnaroundMs = 0;
+
+    if (!probeAccessors(addresses, turnaroundMs)) {
+        errDevice << "Devices don't respond with configured timings";
+        setLastError(tr("Устройства не отвечают на пинг при текущих параметрах диспетчера"));
+        return false;
+    }
+
+    Params tuned = configured;
+
+    // Device is ready for next command after it has answered previous one
+    tuned.writeDelayMs = withMargin(turnaroundMs, configured.writeDelayMs);
+    tuned.frameIntervalMs = static_cast<quint8>(
+                withMargin(qCeil(FRAME_INTERVAL_CHARS * BITS_PER_CHAR * 1000 / configured.portBaudRate),
+                           configured.frameIntervalMs));
+    Toolbox::Invoker::run(this, &Dispatcher::applyTimings, tuned).waitForFinished();
+
+    // Line turnaround delays can't be measured, so they are lowered while replies are stable
+    const auto setWritePause = [] (Params &params, quint16 value) {
+        params.writePauseMs = static_cast<quint8>(value);
+    };
+    const auto setModeSwitchDelay = [] (Params &params, quint16 value) {
+        params.modeSwitchDelayMs = value;
+    };
+
+    findStableTiming(tuned, configured.writePauseMs, setWritePause, addresses);
+    findStableTiming(tuned, configured.modeSwitchDelayMs, setModeSwitchDelay, addresses);
+    Toolbox::Invoker::run(this, &Dispatcher::applyTimings, tuned).waitForFinished();
+
+    if (!probeAccessors(addresses, turnaroundMs)) {
+        errDevice << "Calibrated timings are unstable. Restoring configured timings";
+        Toolbox::Invoker::run(this, &Dispatcher::applyTimings, configured).waitForFinished();
+        setLastError(tr("Не удалось подобрать стабильные параметры диспетчера"));
+        return false;
+    }
+
+    infoDevice << "Dispatcher timings calibrated."
+               << "Write delay, ms:" << tuned.writeDelayMs
+               << "Write pause, ms:" << tuned.writePauseMs
+               << "Mode switch delay, ms:" << tuned.modeSwitchDelayMs
+               << "Frame interval, ms:" << tuned.frameIntervalMs;
+
+    return true;
+}
+
+QMap<quint8, Dispatcher::Accessor::Statistics> Dispatcher::statistics() const
+{
+    QMutexLocker lock(&m_pimpl->accessorsMutex);
+
+    QMap<quint8, Accessor::Statistics> statistics;
+    for (auto it = m_pimpl->accessors.cbegin(); it != m_pimpl->accessors.cend(); ++it) {
+        statistics.insert(it.key(), it.value()->statistics());
+    }
+
+    return statistics;
+}
+
 QString Dispatcher::lastError() const
 {
     return m_pimpl->errorStr;
@@ -130,13 +377,19 @@ bool Dispatcher::open(const Params &params)
         return false;
     }
 
-    m_pimpl->params = params;
+    {
+        QMutexLocker paramsLock(&m_pimpl->paramsMutex);
+        m_pimpl->params = params;
+    }
+    m_pimpl->softwareRts = false;
+    m_pimpl->softwareDtr = false;
 
     infoDevice << "Serial port:" << m_pimpl->params.portName
                << "Baud rate:" << m_pimpl->params.portBaudRate
                << "Write delay, ms:" << m_pimpl->params.writeDelayMs
                << "Write timeout, ms:" << m_pimpl->params.writeTimeoutMs
-               << "Frame interval, ms:" << m_pimpl->params.frameIntervalMs;
+               << "Frame interval, ms:" << m_pimpl->params.frameIntervalMs
+               << "Mode switch delay, ms:" << m_pimpl->params.modeSwitchDelayMs;
 
     m_pimpl->port->setPortName(m_pimpl->params.portName);
     m_pimpl->port->setBaudRate(m_pimpl->params.portBaudRate);
@@ -147,12 +400,25 @@ bool Dispatcher::open(const Params &params)
         return false;
     }
 
+    if (m_pimpl->params.statisticsLogIntervalMs > 0) {
+        m_pimpl->statisticsLogTimer->start(static_cast<int>(m_pimpl->params.statisticsLogIntervalMs));
+    }
+
+    m_pimpl->closing.storeRelaxed(0);
+
     infoDevice << "Dispatcher successfully opened";
 
     emit opened();
     return true;
 }
 
+void Dispatcher::setTimings(const Dispatcher::Params &params)
+{
+    QMutexLocker lock(&m_pimpl->ioMutex);
+
+    applyTimings(params);
+}
+
 bool Dispatcher::isOpen()
 {
     QMutexLocker lock(&m_pimpl->ioMutex);
@@ -163,6 +429,23 @@ bool Dispatcher::isOpen()
 void Dispatcher::close()
 {
     infoDevice << "Closing dispatcher";
+
+    // Queued requests are finished with empty reply and running one
+    // is canceled. It may wait for call queued to this thread before
+    // closing, so such calls are delivered here and waiting accessors
+    // are woken. No more calls are queued, so no event loop is needed
+    {
+        QMutexLocker lock(&m_pimpl->invokeMutex);
+        m_pimpl->closing.storeRelaxed(1);
+    }
+
+    m_pimpl->requestPool.clear();
+    if (thread() == QThread::currentThread()) {
+        QCoreApplication::sendPostedEvents(this);
+    }
+    m_pimpl->wakeAccessors();
+    m_pimpl->requestPool.waitForDone();
+
     QMutexLocker lock(&m_pimpl->ioMutex);
 
     if (!m_pimpl->port->isOpen()) {
@@ -175,6 +458,9 @@ void Dispatcher::close()
     m_pimpl->clearAccessorsReadBuffer();
     m_pimpl->port->close();
 
+    m_pimpl->statisticsLogTimer->stop();
+    logStatistics();
+
     infoDevice << "Dispatcher successfully closed";
     emit closed();
 }
@@ -198,7 +484,7 @@ bool Dispatcher::setMode(Dispatcher::Mode mode)
 
     switch (mode) {
     case Mode_Write:        
-        m_pimpl->setupRtsAndDtr(false, false, 50);
+        m_pimpl->setupRtsAndDtr(false, false, m_pimpl->params.modeSwitchDelayMs);
         break;
     case Mode_Read:
         m_pimpl->setupRtsAndDtr(true, true);
@@ -222,8 +508,9 @@ bool Dispatcher::setMode(Dispatcher::Mode mode)
 
 Dispatcher::Mode Dispatcher::mode() const
 {
-    const bool rts = m_pimpl->port->isRequestToSend();
-    const bool dtr = m_pimpl->port->isDataTerminalReady();
+    const bool softwareLineControl = m_pimpl->params.softwareLineControl;
+    const bool rts = softwareLineControl ? m_pimpl->softwareRts : m_pimpl->port->isRequestToSend();
+    const bool dtr = softwareLineControl ? m_pimpl->softwareDtr : m_pimpl->port->isDataTerminalReady();
 
     if (!rts && !dtr) {
         return Mode_Write;
@@ -270,6 +557,69 @@ void Dispatcher::clear()
     m_pimpl->port->clear();
 }
 
+void Dispatcher::applyTimings(const Dispatcher::Params &params)
+{
+    QMutexLocker lock(&m_pimpl->paramsMutex);
+
+    m_pimpl->params.writeDelayMs = params.writeDelayMs;
+    m_pimpl->params.writePauseMs = params.writePauseMs;
+    m_pimpl->params.frameIntervalMs = params.frameIntervalMs;
+    m_pimpl->params.modeSwitchDelayMs = params.modeSwitchDelayMs;
+}
+
+bool Dispatcher::probeAccessors(const QVector<quint8> &addresses, qint64 &turnaroundMs)
+{
+    turnaroundMs = 0;
+
+    for (int round = 0; round < CALIBRATION_ROUNDS; ++round) {
+        for (quint8 address : addresses) {
+            const NpFrame ping(address, 0x1, 0x55, 0x55, 0x55);
+            const NpFrame pingRightResponse(address, 0x2, 0xAA, 0xAA, 0xAA);
+            Accessor *accessor = getAccessor(address);
+
+            if (!accessor->doWrite(ping)) {
+                return false;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+
+            const QByteArray response = accessor->doRead(CALIBRATION_READ_TIMEOUT_MS, 1);
+            if (response.size() < NpFrame::size ||
+                NpFrame::fromRawData(response.constData()) != pingRightResponse) {
+                warnDevice << "Calibration ping failed for address:" << QString::number(address, 16)
+                           << "Response:" << response.toHex();
+                return false;
+            }
+
+            turnaroundMs = qMax(turnaroundMs, timer.elapsed());
+        }
+    }
+
+    return true;
+}
+
+void Dispatcher::findStableTiming(Dispatcher::Params &tuned, quint16 configured,
+                                  const std::function<void(Dispatcher::Params &, quint16)> &setTiming,
+                                  const QVector<quint8> &addresses)
+{
+    quint16 stable = configured;
+    qint64 turnaroundMs = 0;
+
+    while (stable > 1) {
+        setTiming(tuned, stable / 2);
+        Toolbox::Invoker::run(this, &Dispatcher::applyTimings, tuned).waitForFinished();
+
+        if (!probeAccessors(addresses, turnaroundMs)) {
+            break;
+        }
+
+        stable /= 2;
+    }
+
+    setTiming(tuned, withMargin(stable, configured));
+}
+
 void Dispatcher::onReadyRead()
 {
     dbgDevice << "Bytes available on serial port";
@@ -289,7 +639,12 @@ void Dispatcher::onReadyRead()
 
     dbgDevice << "Read buffer content after reading from serial port:" << m_pimpl->readBuffer.toHex();
 
-    m_pimpl->startProcessReadBufferTimer();
+    m_pimpl->deliverCompleteFrames();
+
+    // Frame interval timer is left only for bytes not recognized as frames
+    if (!m_pimpl->readBuffer.isEmpty()) {
+        m_pimpl->startProcessReadBufferTimer();
+    }
 }
 
 void Dispatcher::onBytesWritten(qint64 bytes)
@@ -351,12 +706,41 @@ void Dispatcher::processReadBuffer()
     dbgDevice << "First byte of read buffer:" << QString::number(address, 16);
 
     if (auto accessor = m_pimpl->accessors.value(address, nullptr)) {
-        accessor->setReadBuffer(m_pimpl->readBuffer);
+        // Leftover bytes are never whole frames with valid checksum
+        NpFrameReader reader(m_pimpl->readBuffer);
+        while (reader.hasNext()) {
+            if (!reader.next().isValid()) {
+                accessor->m_invalidFrames.fetchAndAddRelaxed(1);
+            }
+        }
+
+        accessor->appendReadBuffer(m_pimpl->readBuffer);
     }
 
     m_pimpl->readBuffer.clear();
 }
 
+void Dispatcher::logStatistics()
+{
+    const auto statistics = this->statistics();
+
+    for (auto it = statistics.cbegin(); it != statistics.cend(); ++it) {
+        const auto &accessor = it.value();
+        if (!accessor.queueWait.count) {
+            continue;
+        }
+
+        infoDevice << "Accessor" << QString::number(it.key(), 16) << "statistics."
+                   << "Queue wait:" << accessor.queueWait.toString()
+                   << "Mode switch:" << accessor.modeSwitch.toString()
+                   << "Write delay:" << accessor.writeDelay.toString()
+                   << "Write:" << accessor.write.toString()
+                   << "Turnaround:" << accessor.turnaround.toString()
+                   << "Timeouts:" << accessor.timeouts
+                   << "Invalid frames:" << accessor.invalidFrames;
+    }
+}
+
 void Dispatcher::setLastError(const QString &errorString)
 {    
     m_pimpl->errorStr = errorString;
@@ -398,35 +782,274 @@ void Dispatcher::PImpl::clearAccessorsReadBuffer()
     }
 }
 
-Dispatcher::Accessor::Accessor(Dispatcher &dispatcher) :
-    m_dispatcher(dispatcher)
+bool Dispatcher::PImpl::invokeSetMode(Dispatcher &dispatcher, Mode mode)
+{
+    Toolbox::Invoker::Outcome<bool> outcome;
+    {
+        QMutexLocker lock(&invokeMutex);
+        if (closing.loadRelaxed()) {
+            return false;
+        }
+
+        outcome = Toolbox::Invoker::run(&dispatcher, &Dispatcher::setMode, mode);
+    }
+
+    return outcome.result();
+}
+
+bool Dispatcher::PImpl::invokeWrite(Dispatcher &dispatcher, const QByteArray &bytes)
+{
+    QMutexLocker lock(&invokeMutex);
+    if (closing.loadRelaxed()) {
+        return false;
+    }
+
+    Toolbox::Invoker::run(&dispatcher, &Dispatcher::write, bytes);
+    return true;
+}
+
+void Dispatcher::PImpl::wakeAccessors()
+{
+    QMutexLocker lock(&accessorsMutex);
+
+    for (auto it = accessors.cbegin(); it != accessors.cend(); ++it) {
+        QMutexLocker readLock(&it.value()->m_readMutex);
+        it.value()->m_readWaitCondition.wakeAll();
+    }
+}
+
+void Dispatcher::PImpl::deliverCompleteFrames()
+{
+    QMutexLocker lock(&accessorsMutex);
+
+    const int completeSize = NpFrame::completeFramesSize(readBuffer, [this](quint8 addr) {
+        return accessors.contains(addr);
+    });
+
+    if (!completeSize) {
+        return;
+    }
+
+    QMap<Dispatcher::Accessor *, QByteArray> replies;
+    for (int offset = 0; offset < completeSize; offset += NpFrame::size) {
+        const char *frame = readBuffer.constData() + offset;
+        replies[accessors.value(static_cast<quint8>(frame[0]))].append(frame, NpFrame::size);
+    }
+
+    readBuffer.remove(0, completeSize);
+
+    for (auto it = replies.cbegin(); it != replies.cend(); ++it) {
+        dbgDevice << "Deliver frames:" << it.value().toHex();
+        it.key()->appendReadBuffer(it.value());
+    }
+}
+
+bool Dispatcher::PImpl::isNextBusWaiter(quint64 sequence) const
+{
+    const BusWaiter *next = nullptr;
+
+    for (const auto &waiter : busWaiters) {
+        if (!next || waiter.priority > next->priority ||
+            (waiter.priority == next->priority &&
+             (waiter.deadline < next->deadline ||
+              (waiter.deadline == next->deadline && waiter.sequence < next->sequence)))) {
+            next = &waiter;
+        }
+    }
+
+    return next && next->sequence == sequence;
+}
+
+Dispatcher::Accessor::Accessor(Dispatcher &dispatcher, quint8 address) :
+    m_dispatcher(dispatcher),
+    m_address(address),
+    m_priority(Priority_Normal),
+    m_deadlineMs(0),
+    m_worstWaitMs(0),
+    m_missedDeadlines(0),
+    m_timeouts(0),
+    m_invalidFrames(0)
 {
 
 }
 
 bool Dispatcher::Accessor::write(const QByteArray &bytes)
 {
-    QMutexLocker lock(&m_dispatcher.m_pimpl->ioMutex);
+    BusLocker lock(*this);
 
     return doWrite(bytes);
 }
 
-QByteArray Dispatcher::Accessor::writeAndRead(const QByteArray &input, quint32 msec)
+QByteArray Dispatcher::Accessor::writeAndRead(const QByteArray &input, quint32 msec, Dispatcher::ReadMode mode)
 {
-    QMutexLocker lock(&m_dispatcher.m_pimpl->ioMutex);
+    BusLocker lock(*this);
 
     if (!doWrite(input)) {
         return QByteArray();
     }
 
-    return doRead(msec);
+    return doRead(msec, mode == Read_Burst ? 0 : 1);
+}
+
+QVector<QByteArray> Dispatcher::Accessor::transaction(const QVector<Dispatcher::Request> &requests)
+{
+    BusLocker lock(*this);
+
+    QVector<QByteArray> replies(requests.size());
+    bool replyReceived = false;
+
+    for (int i = 0; i < requests.size(); ++i) {
+        const auto &request = requests.at(i);
+
+        // Request without bytes waits for reply to previous
+        // request or for frame initiated by other device
+        if (!request.bytes.isEmpty() && !doWrite(request.bytes, !replyReceived)) {
+            break;
+        }
+
+        replyReceived = false;
+
+        if (request.expectsReply) {
+            replies[i] = doRead(request.msec, request.replyFrames);
+            if (replies.at(i).isEmpty() || (request.validator && !request.validator(replies.at(i)))) {
+                break;
+            }
+
+            replyReceived = true;
+        }
+    }
+
+    return replies;
+}
+
+QByteArray Dispatcher::Accessor::read(quint32 msec, Dispatcher::ReadMode mode)
+{
+    BusLocker lock(*this);
+
+    return doRead(msec, mode == Read_Burst ? 0 : 1);
+}
+
+QFuture<QByteArray> Dispatcher::Accessor::submit(const Dispatcher::Request &request,
+                                                 CancelationTokenSource::Token token)
+{
+    auto task = new RequestTask(*this, request, token);
+    auto future = task->future();
+
+    m_dispatcher.m_pimpl->requestPool.start(task, priority());
+    return future;
+}
+
+void Dispatcher::Accessor::setPriority(Dispatcher::Priority priority)
+{
+    m_priority.storeRelaxed(priority);
+}
+
+Dispatcher::Priority Dispatcher::Accessor::priority() const
+{
+    return static_cast<Priority>(m_priority.loadRelaxed());
+}
+
+void Dispatcher::Accessor::setDeadlineMs(quint32 msec)
+{
+    m_deadlineMs.storeRelaxed(static_cast<int>(msec));
+}
+
+quint32 Dispatcher::Accessor::deadlineMs() const
+{
+    return static_cast<quint32>(m_deadlineMs.loadRelaxed());
+}
+
+int Dispatcher::Accessor::worstWaitMs() const
+{
+    return m_worstWaitMs.loadRelaxed();
+}
+
+int Dispatcher::Accessor::missedDeadlines() const
+{
+    return m_missedDeadlines.loadRelaxed();
+}
+
+Dispatcher::Accessor::Statistics Dispatcher::Accessor::statistics() const
+{
+    Statistics statistics;
+    statistics.queueWait = m_queueWaitHistogram.snapshot();
+    statistics.modeSwitch = m_modeSwitchHistogram.snapshot();
+    statistics.writeDelay = m_writeDelayHistogram.snapshot();
+    statistics.write = m_writeHistogram.snapshot();
+    statistics.turnaround = m_turnaroundHistogram.snapshot();
+    statistics.timeouts = m_timeouts.loadRelaxed();
+    statistics.invalidFrames = m_invalidFrames.loadRelaxed();
+    return statistics;
+}
+
+void Dispatcher::Accessor::resetStatistics()
+{
+    m_queueWaitHistogram.reset();
+    m_modeSwitchHistogram.reset();
+    m_writeDelayHistogram.reset();
+    m_writeHistogram.reset();
+    m_turnaroundHistogram.reset();
+    m_timeouts.storeRelaxed(0);
+    m_invalidFrames.storeRelaxed(0);
+}
+
+void Dispatcher::Accessor::lockBus()
+{
+    auto &pimpl = *m_dispatcher.m_pimpl;
+    const int deadlineMs = m_deadlineMs.loadRelaxed();
+
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+
+    {
+        QMutexLocker lock(&pimpl.busMutex);
+
+        PImpl::BusWaiter waiter;
+        waiter.priority = m_priority.loadRelaxed();
+        waiter.deadline = deadlineMs > 0 ? pimpl.busClock.elapsed() + deadlineMs
+                                         : std::numeric_limits<qint64>::max();
+        waiter.sequence = ++pimpl.busSequence;
+        pimpl.busWaiters.append(waiter);
+
+        while (pimpl.busAcquired || !pimpl.isNextBusWaiter(waiter.sequence)) {
+            pimpl.busCondition.wait(&pimpl.busMutex);
+        }
+
+        for (int i = 0; i < pimpl.busWaiters.size(); ++i) {
+            if (pimpl.busWaiters.at(i).sequence == waiter.sequence) {
+                pimpl.busWaiters.removeAt(i);
+                break;
+            }
+        }
+
+        pimpl.busAcquired = true;
+    }
+
+    pimpl.ioMutex.lock();
+
+    m_queueWaitHistogram.record(waitTimer.nsecsElapsed() / 1000);
+
+    const int waitMs = static_cast<int>(waitTimer.elapsed());
+    int worstWaitMs = m_worstWaitMs.loadRelaxed();
+    while (waitMs > worstWaitMs && !m_worstWaitMs.testAndSetRelaxed(worstWaitMs, waitMs, worstWaitMs)) {
+    }
+
+    if (deadlineMs > 0 && waitMs > deadlineMs) {
+        m_missedDeadlines.fetchAndAddRelaxed(1);
+        warnDevice << "Accessor" << QString::number(m_address, 16)
+                   << "waited for bus" << waitMs << "ms. Deadline, ms:" << deadlineMs;
+    }
 }
 
-QByteArray Dispatcher::Accessor::read(quint32 msec)
+void Dispatcher::Accessor::unlockBus()
 {
-    QMutexLocker lock(&m_dispatcher.m_pimpl->ioMutex);
+    auto &pimpl = *m_dispatcher.m_pimpl;
+
+    pimpl.ioMutex.unlock();
 
-    return doRead(msec);
+    QMutexLocker lock(&pimpl.busMutex);
+    pimpl.busAcquired = false;
+    pimpl.busCondition.wakeAll();
 }
 
 void Dispatcher::Accessor::setReadBuffer(const QByteArray &bytes)
@@ -437,77 +1060,174 @@ void Dispatcher::Accessor::setReadBuffer(const QByteArray &bytes)
     m_readWaitCondition.wakeAll();
 }
 
-bool Dispatcher::Accessor::doWrite(const QByteArray &bytes)
+void Dispatcher::Accessor::appendReadBuffer(const QByteArray &bytes)
+{
+    QMutexLocker lock(&m_readMutex);
+
+    m_readBuffer.append(bytes);
+    m_readWaitCondition.wakeAll();
+}
+
+bool Dispatcher::Accessor::doWrite(const QByteArray &bytes, bool waitWriteDelay)
 {
     Q_ASSERT(QThread::currentThread() != m_dispatcher.thread());
 
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+
     dbgDevice << "Switching dispatcher to write mode";
-    if (!Toolbox::Invoker::run(&m_dispatcher, &Dispatcher::setMode, Mode_Write).result()) {
+    if (!m_dispatcher.m_pimpl->invokeSetMode(m_dispatcher, Mode_Write)) {
         return false;
     }
 
-    if (m_dispatcher.m_pimpl->params.writeDelayMs > 0 && m_dispatcher.m_pimpl->writeDelayTimer.isValid()) {
-        auto remainingMs = m_dispatcher.m_pimpl->params.writeDelayMs - m_dispatcher.m_pimpl->writeDelayTimer.elapsed();
-        if (remainingMs > 0 && remainingMs <= m_dispatcher.m_pimpl->params.writeDelayMs) {
+    m_modeSwitchHistogram.record(stageTimer.nsecsElapsed() / 1000);
+
+    const quint16 writeDelayMs = m_dispatcher.params().writeDelayMs;
+    if (waitWriteDelay && writeDelayMs > 0 && m_dispatcher.m_pimpl->writeDelayTimer.isValid()) {
+        auto remainingMs = writeDelayMs - m_dispatcher.m_pimpl->writeDelayTimer.elapsed();
+        if (remainingMs > 0 && remainingMs <= writeDelayMs) {
             dbgDevice << "Sleep before write to dispatcher, ms:" << remainingMs;
+            stageTimer.restart();
             QThread::msleep(static_cast<ulong>(remainingMs));
+            m_writeDelayHistogram.record(stageTimer.nsecsElapsed() / 1000);
         }
     }
 
     DispatcherWriteWatcher watcher(&m_dispatcher);
 
     dbgDevice << "Write to dispatcher:" << bytes.toHex();
+    stageTimer.restart();
 
     // Don't wait outcome because if error occurred
     // Dispatcher::errorOccurred signal will be emmitted
-    Toolbox::Invoker::run(&m_dispatcher, &Dispatcher::write, bytes);
+    if (!m_dispatcher.m_pimpl->invokeWrite(m_dispatcher, bytes)) {
+        return false;
+    }
 
-    bool success = watcher.wait();
+    bool success = watcher.wait([this] { return isDispatcherClosing(); });
     m_dispatcher.m_pimpl->writeDelayTimer.restart();
+
+    // Write time includes write pause
+    if (success) {
+        m_writeHistogram.record(stageTimer.nsecsElapsed() / 1000);
+    }
+
     return success;
 }
 
-QByteArray Dispatcher::Accessor::doRead(quint32 msec)
+QByteArray Dispatcher::Accessor::doRead(quint32 msec, quint8 replyFrames, const std::function<bool()> &isCanceled)
 {
     Q_ASSERT(QThread::currentThread() != m_dispatcher.thread());
 
+    QElapsedTimer turnaroundTimer;
+    turnaroundTimer.start();
+
     dbgDevice << "Clear accessor read buffer";
     setReadBuffer(QByteArray());
 
     dbgDevice << "Switching dispatcher to read mode";
-    if (!Toolbox::Invoker::run(&m_dispatcher, &Dispatcher::setMode, Mode_Read).result()) {
+    if (!m_dispatcher.m_pimpl->invokeSetMode(m_dispatcher, Mode_Read)) {
         return QByteArray();
     }
 
+    m_modeSwitchHistogram.record(turnaroundTimer.nsecsElapsed() / 1000);
+
+    const qint64 silenceMs = BURST_SILENCE_INTERVALS * m_dispatcher.params().frameIntervalMs;
+    // Wait is sliced to notice cancelation, closing dispatcher wakes reader itself
+    const qint64 sliceMs = isCanceled ? CANCELATION_CHECK_MS : std::numeric_limits<qint64>::max();
+    const auto canceled = [this, &isCanceled] {
+        return isDispatcherClosing() || (isCanceled && isCanceled());
+    };
+
     QMutexLocker lock(&m_readMutex);
 
-    if (m_readBuffer.isEmpty()) {
+    QElapsedTimer timer;
+    timer.start();
+
+    const auto replyComplete = [this, replyFrames] {
+        return replyFrames ? m_readBuffer.size() >= replyFrames * NpFrame::size : !m_readBuffer.isEmpty();
+    };
+
+    if (!replyComplete()) {
         dbgDevice << "Accessor waiting for incoming data for" << msec << "ms";
-        m_readWaitCondition.wait(&m_readMutex, msec);
+    }
+
+    while (!replyComplete() && !canceled() && !timer.hasExpired(msec)) {
+        const qint64 remainingMs = msec - timer.elapsed();
+        m_readWaitCondition.wait(&m_readMutex, static_cast<ulong>(qMin(remainingMs, sliceMs)));
+    }
+
+    const qint64 turnaroundUs = turnaroundTimer.nsecsElapsed() / 1000;
+
+    // Frames delivered in the next read chunks are the same burst
+    if (!replyFrames && !m_readBuffer.isEmpty()) {
+        QElapsedTimer silenceTimer;
+        silenceTimer.start();
+        int size = m_readBuffer.size();
+
+        while (!silenceTimer.hasExpired(silenceMs) && !canceled()) {
+            const qint64 remainingMs = silenceMs - silenceTimer.elapsed();
+            m_readWaitCondition.wait(&m_readMutex, static_cast<ulong>(qMin(remainingMs, sliceMs)));
+
+            if (m_readBuffer.size() != size) {
+                size = m_readBuffer.size();
+                silenceTimer.restart();
+            }
+        }
     }
 
     QByteArray bytes = m_readBuffer;
     m_readBuffer.clear();
 
+    if (bytes.isEmpty()) {
+        m_timeouts.fetchAndAddRelaxed(1);
+    } else {
+        m_turnaroundHistogram.record(turnaroundUs);
+    }
+
     dbgDevice << "Accessor read buffer content:" << bytes.toHex();
     return bytes;
 }
 
+bool Dispatcher::Accessor::isDispatcherClosing() const
+{
+    return m_dispatcher.m_pimpl->closing.loadRelaxed() != 0;
+}
+
+Dispatcher::Request::Request(const QByteArray &bytes, bool expectsReply, quint32 msec, quint8 replyFrames) :
+    bytes(bytes),
+    expectsReply(expectsReply),
+    msec(msec),
+    replyFrames(replyFrames)
+{
+
+}
+
 Dispatcher::Params::Params() :
     portName(QStringLiteral("COM1")),
     portBaudRate(9600),
     writeTimeoutMs(1000),
     writeDelayMs(150),
     writePauseMs(50),
-    frameIntervalMs(10)
+    frameIntervalMs(10),
+    modeSwitchDelayMs(50),
+    softwareLineControl(false),
+    statisticsLogIntervalMs(300000)
 {
 
 }
 
 bool Dispatcher::PImpl::setupRtsAndDtr(bool rts, bool dtr, quint32 msecAfter)
 {
-    bool result = port->setRequestToSend(rts);
-    result = port->setDataTerminalReady(dtr) && result;
+    bool result = true;
+
+    if (params.softwareLineControl) {
+        softwareRts = rts;
+        softwareDtr = dtr;
+    } else {
+        result = port->setRequestToSend(rts);
+        result = port->setDataTerminalReady(dtr) && result;
+    }
 
     if (result && msecAfter) {
         QThread::msleep(msecAfter);
@@ -526,15 +1246,14 @@ DispatcherWriteWatcher::DispatcherWriteWatcher(Dispatcher *dispatcher, QObject *
             this, &DispatcherWriteWatcher::onErrorOccurred, Qt::DirectConnection);
 }
 
-bool DispatcherWriteWatcher::wait()
+bool DispatcherWriteWatcher::wait(const std::function<bool()> &isCanceled)
 {
     QMutexLocker lock(&m_mutex);
 
-    if (m_result != ResultUnknown) {
-        return m_result;
+    while (m_result == ResultUnknown && !isCanceled()) {
+        m_waitCondition.wait(&m_mutex, static_cast<ulong>(CANCELATION_CHECK_MS));
     }
 
-    m_waitCondition.wait(&m_mutex);
     return m_result == ResultSuccess;
 }
 
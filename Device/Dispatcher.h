@@ -2,12 +2,20 @@
 #define DISPATCHER_H
 
 #include "DeviceGlobal.h"
+#include "CancelationToken.h"
+#include "LatencyHistogram.h"
 
 #include <QObject>
+#include <QAtomicInt>
 #include <QByteArray>
 #include <QMutex>
 #include <QWaitCondition>
 #include <QScopedPointer>
+#include <QVector>
+#include <QMap>
+#include <QFuture>
+
+#include <functional>
 
 class DEVICELIB_EXPORT Dispatcher final : public QObject
 {
@@ -23,25 +31,151 @@ public:
         quint16 writeDelayMs;
         quint8  writePauseMs;
         quint8  frameIntervalMs;
+        quint16 modeSwitchDelayMs;
+        /**
+         * RTS and DTR are kept by dispatcher instead of the port,
+         * for ports without modem lines such as simulator pty
+         **/
+        bool softwareLineControl;
+        /**
+         * Period of accessors statistics dump to log, 0 disables it
+         **/
+        quint32 statisticsLogIntervalMs;
+    };
+
+    enum Priority {
+        Priority_Background,
+        Priority_Normal,
+        Priority_Control
+    };
+
+    /**
+     * Deadline of Priority_Control accessors. X-ray control
+     * waits at most one exchange of other device on the bus
+     **/
+    static constexpr quint32 controlDeadlineMs = 1500;
+
+    /**
+     * Read_Frame returns on first whole frame. Read_Burst waits
+     * for line silence after it, so multi-frame bursts split
+     * across reads are whole, but every reply is delayed by it
+     **/
+    enum ReadMode {
+        Read_Frame,
+        Read_Burst
+    };
+
+    struct DEVICELIB_EXPORT Request
+    {
+        typedef std::function<bool(const QByteArray &reply)> Validator;
+
+        Request(const QByteArray &bytes = QByteArray(), bool expectsReply = true, quint32 msec = 1000,
+                quint8 replyFrames = 1);
+        QByteArray bytes;
+        bool expectsReply;
+        quint32 msec;
+        /**
+         * Reply is returned as soon as this many frames arrived.
+         * 0 waits for line silence as Read_Burst
+         **/
+        quint8 replyFrames;
+        /**
+         * Reply rejected by validator stops the batch
+         * as missing one, but is still returned
+         **/
+        Validator validator;
     };
 
     class DEVICELIB_EXPORT Accessor
     {
         Q_DISABLE_COPY(Accessor)
     public:
-        Accessor(Dispatcher &dispatcher);
+        /**
+         * Durations of request stages. Mode switch holds both
+         * switches to write and to read, write includes write pause
+         **/
+        struct DEVICELIB_EXPORT Statistics
+        {
+            LatencyHistogram::Snapshot queueWait;
+            LatencyHistogram::Snapshot modeSwitch;
+            LatencyHistogram::Snapshot writeDelay;
+            LatencyHistogram::Snapshot write;
+            LatencyHistogram::Snapshot turnaround;
+            quint64 timeouts = 0;
+            quint64 invalidFrames = 0;
+        };
+
+        Accessor(Dispatcher &dispatcher, quint8 address);
 
         bool write(const QByteArray &bytes);
-        QByteArray read(quint32 msec = 1000);
-        QByteArray writeAndRead(const QByteArray &input, quint32 msec = 1000);
+        QByteArray read(quint32 msec = 1000, Dispatcher::ReadMode mode = Read_Frame);
+        QByteArray writeAndRead(const QByteArray &input, quint32 msec = 1000,
+                                Dispatcher::ReadMode mode = Read_Frame);
+
+        /**
+         * Executes requests holding the bus for the whole batch.
+         * Write delay is skipped after received reply because
+         * the device is already done. Reply is empty for requests
+         * without it and for ones not executed after first failure
+         * or rejected reply. Request with empty bytes only reads
+         **/
+        QVector<QByteArray> transaction(const QVector<Dispatcher::Request> &requests);
+        /**
+         * Queues request to dispatcher request thread and returns
+         * without blocking. Queued requests of all accessors are
+         * ordered by accessor priority. Reply is empty on failure,
+         * for requests without reply, when token is canceled and
+         * when dispatcher is closed. Future canceled by QFuture::cancel()
+         * has no result, so isCanceled() is checked before result()
+         **/
+        QFuture<QByteArray> submit(const Dispatcher::Request &request,
+                                   CancelationTokenSource::Token token = CancelationTokenSource::Token());
+
+        /**
+         * Waiting accessor with higher priority gets the bus first,
+         * ones with equal priority are served by earliest deadline
+         **/
+        void setPriority(Dispatcher::Priority priority);
+        Dispatcher::Priority priority() const;
+        /**
+         * Expected maximum wait for the bus, 0 disables deadline.
+         * Missed deadlines are logged and counted
+         **/
+        void setDeadlineMs(quint32 msec);
+        quint32 deadlineMs() const;
+        int worstWaitMs() const;
+        int missedDeadlines() const;
+
+        Statistics statistics() const;
+        void resetStatistics();
     private:
         friend class Dispatcher;
+        class BusLocker;
+        class RequestTask;
+
+        void lockBus();
+        void unlockBus();
 
         void setReadBuffer(const QByteArray &bytes);
-        bool doWrite(const QByteArray &bytes);
-        QByteArray doRead(quint32 msec);
+        void appendReadBuffer(const QByteArray &bytes);
+        bool doWrite(const QByteArray &bytes, bool waitWriteDelay = true);
+        QByteArray doRead(quint32 msec, quint8 replyFrames = 1,
+                          const std::function<bool()> &isCanceled = std::function<bool()>());
+        bool isDispatcherClosing() const;
 
         Dispatcher &m_dispatcher;
+        quint8 m_address;
+        QAtomicInt m_priority;
+        QAtomicInt m_deadlineMs;
+        QAtomicInt m_worstWaitMs;
+        QAtomicInt m_missedDeadlines;
+        LatencyHistogram m_queueWaitHistogram;
+        LatencyHistogram m_modeSwitchHistogram;
+        LatencyHistogram m_writeDelayHistogram;
+        LatencyHistogram m_writeHistogram;
+        LatencyHistogram m_turnaroundHistogram;
+        QAtomicInteger<quint64> m_timeouts;
+        QAtomicInteger<quint64> m_invalidFrames;
         QMutex m_readMutex;
         QWaitCondition m_readWaitCondition;
         QByteArray m_readBuffer;
@@ -52,11 +186,30 @@ public:
 
     Accessor *getAccessor(quint8 address);
 
+    /**
+     * Thread-safe, timings may be changed by dispatcher thread
+     **/
     Params params() const;
+    /**
+     * Snapshot of every accessor statistics by address
+     **/
+    QMap<quint8, Accessor::Statistics> statistics() const;
+
+    /**
+     * Probes every created accessor with ping frames and lowers
+     * timings to the smallest stable values with safety margin.
+     * Configured timings are kept on failure. Must be called
+     * outside dispatcher thread
+     **/
+    bool calibrateTimings();
 
     QString lastError() const;
 public slots:
     bool open(const Dispatcher::Params &params);
+    /**
+     * Applies only timings of params, port settings are ignored
+     **/
+    void setTimings(const Dispatcher::Params &params);
     bool isOpen();
     void close();
     bool reset();
@@ -71,6 +224,7 @@ private slots:
     void onWriteTimeout();
     void onErrorOccurred();
     void processReadBuffer();
+    void logStatistics();
 private:
     enum Mode {
         Mode_Write,
@@ -83,6 +237,11 @@ private:
     Mode mode() const;
     bool write(const QByteArray &bytes);
     void clear();
+    void applyTimings(const Dispatcher::Params &params);
+    bool probeAccessors(const QVector<quint8> &addresses, qint64 &turnaroundMs);
+    void findStableTiming(Dispatcher::Params &tuned, quint16 configured,
+                          const std::function<void(Dispatcher::Params &, quint16)> &setTiming,
+                          const QVector<quint8> &addresses);
 
     void setLastError(const QString &errorString);
 
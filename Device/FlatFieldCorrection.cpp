@@ -2,15 +2,157 @@
 
 #include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 #include <QTextStream>
+#include <QUuid>
+#include <QtEndian>
 #include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
+#include "CpuFeatures.h"
+#include "ParallelFor.h"
 #include "DeviceLogging.h"
 
-FlatFieldCorrection::FlatFieldCorrection(const QString &filename):
-    m_filename(filename)
+namespace {
+    // Row blocks smaller than this are not worth a thread
+    const int kMinRowsPerBlock = 256;
+
+    const char kGainsFileMagic[8] = {'N', 'P', 'G', 'A', 'I', 'N', 'S', '\0'};
+    const quint32 kGainsFileVersion = 1;
+
+    /**
+     * Binary gains file starts with this header followed by
+     * width float32 values. All fields are little-endian
+     **/
+    struct GainsFileHeader
+    {
+        char magic[8];
+        quint32 version;
+        quint32 width;
+        uchar scanningModeUuid[16];
+        qint64 timestampMs;
+        quint32 checksum;
+        quint32 reserved;
+    };
+
+    static_assert(sizeof(GainsFileHeader) == 48, "Gains file header must not be padded");
+    static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "Gains are stored as little-endian float32");
+
+    quint32 crc32(const uchar *data, qint64 size)
+    {
+        static const auto table = [] {
+            QVector<quint32> t(256);
+            for (quint32 i = 0; i < 256; ++i) {
+                quint32 c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        quint32 crc = 0xFFFFFFFFu;
+        for (qint64 i = 0; i < size; ++i) {
+            crc = table.at((crc ^ data[i]) & 0xFF) ^ (crc >> 8);
+        }
+
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    /**
+     * All row kernels do the same operations in the same order
+     * (subtract, multiply, ceil) so result is bit-identical
+     * whatever kernel is used. Returns minimum of min and row values.
+     * Vector min takes new value as first operand, so NaN from bad
+     * gain is skipped as by std::min(min, value)
+     **/
+    typedef float (*CorrectRowFunc)(float *row, const float *rates,
+                                     const float *reciprocalGains, int width, float min);
+
+    float correctRowScalar(float *row, const float *rates, const float *reciprocalGains,
+                           int width, float min)
+    {
+        for (int i = 0; i < width; ++i) {
+            const float value = std::ceil((row[i] - rates[i]) * reciprocalGains[i]);
+            row[i] = value;
+            min = std::min(min, value);
+        }
+
+        return min;
+    }
+
+#if defined(DEVICE_SIMD_X86)
+    DEVICE_TARGET_SSE41
+    float correctRowSse41(float *row, const float *rates, const float *reciprocalGains,
+                          int width, float min)
+    {
+        __m128 vmin = _mm_set1_ps(min);
+
+        int i = 0;
+        for (; i + 4 <= width; i += 4) {
+            __m128 v = _mm_sub_ps(_mm_loadu_ps(row + i), _mm_loadu_ps(rates + i));
+            v = _mm_ceil_ps(_mm_mul_ps(v, _mm_loadu_ps(reciprocalGains + i)));
+            _mm_storeu_ps(row + i, v);
+            vmin = _mm_min_ps(v, vmin);
+        }
+
+        float lanes[4];
+        _mm_storeu_ps(lanes, vmin);
+        min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+
+        return correctRowScalar(row + i, rates + i, reciprocalGains + i, width - i, min);
+    }
+
+    DEVICE_TARGET_AVX2
+    float correctRowAvx2(float *row, const float *rates, const float *reciprocalGains,
+                         int width, float min)
+    {
+        __m256 vmin = _mm256_set1_ps(min);
+
+        int i = 0;
+        for (; i + 8 <= width; i += 8) {
+            __m256 v = _mm256_sub_ps(_mm256_loadu_ps(row + i), _mm256_loadu_ps(rates + i));
+            v = _mm256_ceil_ps(_mm256_mul_ps(v, _mm256_loadu_ps(reciprocalGains + i)));
+            _mm256_storeu_ps(row + i, v);
+            vmin = _mm256_min_ps(v, vmin);
+        }
+
+        float lanes[8];
+        _mm256_storeu_ps(lanes, vmin);
+        for (int j = 0; j < 8; ++j) {
+            min = std::min(min, lanes[j]);
+        }
+
+        return correctRowScalar(row + i, rates + i, reciprocalGains + i, width - i, min);
+    }
+#endif
+
+    CorrectRowFunc selectCorrectRow()
+    {
+#if defined(DEVICE_SIMD_X86)
+        if (CpuFeatures::hasAvx2()) {
+            return correctRowAvx2;
+        }
+
+        if (CpuFeatures::hasSse41()) {
+            return correctRowSse41;
+        }
+#endif
+
+        return correctRowScalar;
+    }
+}
+
+FlatFieldCorrection::FlatFieldCorrection(const QString &filename, const QString &scanningModeUuid):
+    m_filename(filename),
+    m_scanningModeUuid(scanningModeUuid),
+    m_lastCalibrationLoaded(false),
+    m_unsavedGains(false)
 {
-    loadGains();
+
 }
 
 QDateTime FlatFieldCorrection::lastCalibrationDateTime() const
@@ -24,39 +166,205 @@ int FlatFieldCorrection::width() const
     return m_gains.size();
 }
 
-QVector<float> FlatFieldCorrection::ratesFromDarkFrame(const QVector<float> &darkFrame, int width) const
+QVector<float> FlatFieldCorrection::ratesFromDarkFrame(const QVector<float> &darkFrame, int width)
 {
-    QVector<float> rates;
-    rates.reserve(width);
-
     const int height = darkFrame.size() / width;
+    const int blocks = ParallelFor::blocksCount(height, kMinRowsPerBlock);
+
+    QVector<double> blockSums(blocks * width, 0);
+    double *blockSumsData = blockSums.data();
+    const float *pixels = darkFrame.constData();
+
+    ParallelFor::run(height, kMinRowsPerBlock, [=](int block, int begin, int end) {
+        double *sums = blockSumsData + block * width;
+        for (int j = begin; j < end; ++j) {
+            const float *line = pixels + j * width;
+            for (int i = 0; i < width; ++i) {
+                sums[i] += static_cast<double>(line[i]);
+            }
+        }
+    });
+
+    QVector<float> rates(width);
     for (int i = 0; i < width; ++i) {
         double sum = 0;
-        for (int j = 0; j < height; ++j) {
-            sum += static_cast<double>(darkFrame.at(width * j + i));
+        for (int block = 0; block < blocks; ++block) {
+            sum += blockSumsData[block * width + i];
         }
-        rates.append(static_cast<float>(sum / height));
+
+        rates[i] = static_cast<float>(sum / height);
     }
 
     return rates;
 }
 
-void FlatFieldCorrection::loadGains()
+bool FlatFieldCorrection::isLoaded() const
+{
+    return !m_gains.isEmpty();
+}
+
+bool FlatFieldCorrection::load()
+{
+    return isLoaded() || loadGains();
+}
+
+void FlatFieldCorrection::unload()
+{
+    m_gains.clear();
+    m_gains.squeeze();
+    m_reciprocalGains.clear();
+    m_reciprocalGains.squeeze();
+}
+
+void FlatFieldCorrection::loadLastCalibrationDateTime()
+{
+    if (m_lastCalibrationLoaded || isLoaded()) {
+        return;
+    }
+
+    // Don't touch file again if it is absent or broken,
+    // calibration date stays invalid until calibrate()
+    m_lastCalibrationLoaded = true;
+
+    QFile f(m_filename);
+    if (m_filename.isEmpty() || !f.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    GainsFileHeader header;
+    const qint64 headerSize = sizeof(header);
+
+    if (f.read(reinterpret_cast<char *>(&header), headerSize) == headerSize &&
+        !memcmp(header.magic, kGainsFileMagic, sizeof(kGainsFileMagic))) {
+        const qint64 payloadSize = static_cast<qint64>(qFromLittleEndian(header.width)) *
+                                   static_cast<qint64>(sizeof(float));
+
+        if (qFromLittleEndian(header.version) != kGainsFileVersion ||
+            f.size() != headerSize + payloadSize) {
+            return;
+        }
+
+        // Date of broken gains must not mark calibration as fresh.
+        // Payload is only width floats, so it is read to check it
+        const QByteArray payload = f.read(payloadSize);
+        if (payload.size() != payloadSize ||
+            crc32(reinterpret_cast<const uchar *>(payload.constData()), payloadSize) !=
+            qFromLittleEndian(header.checksum)) {
+            warnDevice << "Gains file checksum mismatch:" << m_filename;
+            return;
+        }
+
+        setLastCalibrationDateTime(QDateTime::fromMSecsSinceEpoch(qFromLittleEndian(header.timestampMs)));
+        return;
+    }
+
+    f.close();
+    loadGains();
+}
+
+bool FlatFieldCorrection::loadGains()
 {
     infoDevice << "Loading gains from:" << m_filename;
 
     if (m_filename.isEmpty()) {
         errDevice << "Gains filename is empty";
-        return;
+        return false;
     }
 
     QFile f(m_filename);
     if (!f.open(QIODevice::ReadOnly)) {
         errDevice << "Failed to open gains file with error:" << f.errorString();
-        return;
+        return false;
     }
 
     QVector<float> gains;
+    QDateTime lastCalibration;
+
+    const bool isBinary = f.peek(sizeof(kGainsFileMagic)) ==
+                          QByteArray::fromRawData(kGainsFileMagic, sizeof(kGainsFileMagic));
+
+    if (isBinary) {
+        if (!loadBinaryGains(f, gains, lastCalibration)) {
+            return false;
+        }
+    } else {
+        if (!loadLegacyGains(f, gains, lastCalibration)) {
+            return false;
+        }
+
+        f.close();
+
+        infoDevice << "Migrating legacy text gains file to binary format";
+        if (!saveGains(gains, lastCalibration)) {
+            warnDevice << "Failed to migrate gains file";
+        }
+    }
+
+    setGains(gains);
+    setLastCalibrationDateTime(lastCalibration);
+    m_lastCalibrationLoaded = true;
+
+    infoDevice << "Gains successfully loaded. Image width is" << m_gains.size();
+    return true;
+}
+
+bool FlatFieldCorrection::loadBinaryGains(QFile &f, QVector<float> &gains, QDateTime &lastCalibration) const
+{
+    // File is read, not mapped: correction uses reciprocals computed from
+    // gains, so payload is copied anyway, and mapping kept alive would
+    // lock file against rewriting by saveGains() on Windows
+    const qint64 fileSize = f.size();
+    GainsFileHeader header;
+    const qint64 headerSize = static_cast<qint64>(sizeof(header));
+
+    if (fileSize < headerSize ||
+        f.read(reinterpret_cast<char *>(&header), headerSize) != headerSize) {
+        errDevice << "Gains file is corrupted";
+        return false;
+    }
+
+    const quint32 version = qFromLittleEndian(header.version);
+    const quint32 width = qFromLittleEndian(header.width);
+    const qint64 payloadSize = static_cast<qint64>(width) * static_cast<qint64>(sizeof(float));
+
+    if (version != kGainsFileVersion) {
+        errDevice << "Unsupported gains file version:" << version;
+        return false;
+    }
+
+    if (!width || fileSize != headerSize + payloadSize) {
+        errDevice << "Gains file is corrupted";
+        return false;
+    }
+
+    const QUuid fileUuid = QUuid::fromRfc4122(QByteArray::fromRawData(
+        reinterpret_cast<const char *>(header.scanningModeUuid), sizeof(header.scanningModeUuid)));
+    const QUuid uuid(m_scanningModeUuid);
+
+    if (!fileUuid.isNull() && !uuid.isNull() && fileUuid != uuid) {
+        errDevice << "Gains file belongs to scanning mode" << fileUuid.toString();
+        return false;
+    }
+
+    QVector<float> payload(static_cast<int>(width));
+    if (f.read(reinterpret_cast<char *>(payload.data()), payloadSize) != payloadSize) {
+        errDevice << "Failed to read gains file with error:" << f.errorString();
+        return false;
+    }
+
+    if (crc32(reinterpret_cast<const uchar *>(payload.constData()), payloadSize) !=
+        qFromLittleEndian(header.checksum)) {
+        errDevice << "Gains file checksum mismatch";
+        return false;
+    }
+
+    gains = payload;
+    lastCalibration = QDateTime::fromMSecsSinceEpoch(qFromLittleEndian(header.timestampMs));
+    return true;
+}
+
+bool FlatFieldCorrection::loadLegacyGains(QFile &f, QVector<float> &gains, QDateTime &lastCalibration) const
+{
     int width = 0;
 
     QTextStream s(&f);
@@ -70,38 +378,60 @@ void FlatFieldCorrection::loadGains()
 
     if (gains.isEmpty()) {
         errDevice << "Gains is empty";
-        return;
+        return false;
     }
 
     if (gains.size() != width) {
         errDevice << "Gains file is corrupted";
-        return;
+        return false;
     }
 
-    m_gains = gains;
-
     QFileInfo fi(f);
-    setLastCalibrationDateTime(fi.lastModified());
-
-    infoDevice << "Gains successfully loaded. Image width is" << m_gains.size();
+    lastCalibration = fi.lastModified();
+    return true;
 }
 
-bool FlatFieldCorrection::saveGains(const QVector<float> &gains)
+bool FlatFieldCorrection::saveGains(const QVector<float> &gains, const QDateTime &lastCalibration)
 {
     if (m_filename.isEmpty()) {
         errDevice << "Gains filename is empty";
         return false;
     }
-    QFile f(m_filename);
-    if (!f.open(QFile::WriteOnly | QFile::Truncate)) {
+
+    QSaveFile f(m_filename);
+    if (!f.open(QIODevice::WriteOnly)) {
         errDevice << "Failed to open gains file with error:" << f.errorString();
         return false;
     }
 
-    QTextStream s(&f);
-    s << gains.size() << '\n';
-    for (int i = 0; i < gains.size(); ++i) {
-        s << gains.at(i) << '\n';
+    const auto payload = reinterpret_cast<const uchar *>(gains.constData());
+    const qint64 payloadSize = static_cast<qint64>(gains.size()) * static_cast<qint64>(sizeof(float));
+
+    GainsFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kGainsFileMagic, sizeof(header.magic));
+    header.version = qToLittleEndian(kGainsFileVersion);
+    header.width = qToLittleEndian(static_cast<quint32>(gains.size()));
+    header.timestampMs = qToLittleEndian(lastCalibration.toMSecsSinceEpoch());
+    header.checksum = qToLittleEndian(crc32(payload, payloadSize));
+
+    const QByteArray uuid = QUuid(m_scanningModeUuid).toRfc4122();
+    if (static_cast<size_t>(uuid.size()) == sizeof(header.scanningModeUuid)) {
+        memcpy(header.scanningModeUuid, uuid.constData(), sizeof(header.scanningModeUuid));
+    }
+
+    const qint64 headerSize = sizeof(header);
+
+    if (f.write(reinterpret_cast<const char *>(&header), headerSize) != headerSize ||
+        f.write(reinterpret_cast<const char *>(payload), payloadSize) != payloadSize) {
+        errDevice << "Failed to write gains file with error:" << f.errorString();
+        f.cancelWriting();
+        return false;
+    }
+
+    if (!f.commit()) {
+        errDevice << "Failed to commit gains file with error:" << f.errorString();
+        return false;
     }
 
     infoDevice << "Gains successfully saved";
@@ -111,6 +441,18 @@ bool FlatFieldCorrection::saveGains(const QVector<float> &gains)
 bool FlatFieldCorrection::calibrate(const QVector<float> &img,
                                     const QVector<float> &darkFrame,
                                     int width)
+{
+    QVector<float> gains;
+    if (!computeGains(img, darkFrame, width, gains)) {
+        return false;
+    }
+
+    return setCalibration(gains);
+}
+
+bool FlatFieldCorrection::computeGains(const QVector<float> &img,
+                                       const QVector<float> &darkFrame,
+                                       int width, QVector<float> &gains)
 {
     infoDevice << "Starting calibration";
 
@@ -125,108 +467,207 @@ bool FlatFieldCorrection::calibrate(const QVector<float> &img,
         return false;
     }
 
-    QVector<float> darkFrameRates = ratesFromDarkFrame(darkFrame, width);
+    const QVector<float> darkFrameRates = ratesFromDarkFrame(darkFrame, width);
     const int height = img.size() / width;
 
-    double avgN = 0;
-    {
-        double sum = 0;
-        quint64 count = 0;
-        for (int i = 0; i < width; ++i) {
-            for (int j = 0; j < height; ++j) {
-                if (img.at(width * j + i) >= darkFrameRates.at(i)) {
-                    sum += static_cast<double>(img.at(width * j + i) - darkFrameRates.at(i));
-                    ++count;
+    // Per-column sums and counts are accumulated by row blocks
+    // in one row-major pass and reduced afterwards
+    const int blocks = ParallelFor::blocksCount(height, kMinRowsPerBlock);
+
+    QVector<double> blockSums(blocks * width, 0);
+    QVector<quint64> blockCounts(blocks * width, 0);
+    double *blockSumsData = blockSums.data();
+    quint64 *blockCountsData = blockCounts.data();
+    const float *pixels = img.constData();
+    const float *rates = darkFrameRates.constData();
+
+    ParallelFor::run(height, kMinRowsPerBlock, [=](int block, int begin, int end) {
+        double *sums = blockSumsData + block * width;
+        quint64 *counts = blockCountsData + block * width;
+        for (int j = begin; j < end; ++j) {
+            const float *line = pixels + j * width;
+            for (int i = 0; i < width; ++i) {
+                if (line[i] >= rates[i]) {
+                    sums[i] += static_cast<double>(line[i] - rates[i]);
+                    ++counts[i];
                 }
             }
         }
+    });
 
-        if (!count) {
-            errDevice << "Bad image";
-            return false;
+    QVector<double> columnSums(width, 0);
+    QVector<quint64> columnCounts(width, 0);
+    double sum = 0;
+    quint64 count = 0;
+
+    for (int block = 0; block < blocks; ++block) {
+        for (int i = 0; i < width; ++i) {
+            columnSums[i] += blockSumsData[block * width + i];
+            columnCounts[i] += blockCountsData[block * width + i];
         }
+    }
 
-        avgN = sum / count;
+    for (int i = 0; i < width; ++i) {
+        sum += columnSums.at(i);
+        count += columnCounts.at(i);
     }
 
+    if (!count) {
+        errDevice << "Bad image";
+        return false;
+    }
+
+    const double avgN = sum / count;
+
     if (qFuzzyIsNull(avgN)) {
         errDevice << "AvgN is equal to zero";
         return false;
     }
 
-    QVector<float> gains;
-    gains.reserve(width);
+    gains.resize(width);
 
     for (int i = 0; i < width; ++i) {
-        double sum = 0;
-        quint64 count = 0;
-        for (int j = 0; j < height; ++j) {
-            if (img.at(width * j + i) >= darkFrameRates.at(i)) {
-                sum += static_cast<double>(img.at(width * j + i) - darkFrameRates.at(i));
-                ++count;
-            }
-        }
-
-        if (!count) {
+        if (!columnCounts.at(i)) {
             errDevice << "Bad image";
             return false;
         }
 
-        gains.append(static_cast<float>(sum / count / avgN));
+        gains[i] = static_cast<float>(columnSums.at(i) / columnCounts.at(i) / avgN);
     }
 
-    if (!saveGains(gains)) {
+    return true;
+}
+
+bool FlatFieldCorrection::setCalibration(const QVector<float> &gains)
+{
+    const QDateTime now = QDateTime::currentDateTime();
+
+    m_unsavedGains = !saveGains(gains, now);
+    if (m_unsavedGains) {
         warnDevice << "Failed to save gains into file";
     }
 
-    m_gains = gains;
-    setLastCalibrationDateTime(QDateTime::currentDateTime());
-    return true;
+    setGains(gains);
+    setLastCalibrationDateTime(now);
+    m_lastCalibrationLoaded = true;
+    return !m_unsavedGains;
+}
+
+bool FlatFieldCorrection::hasUnsavedGains() const
+{
+    return m_unsavedGains && isLoaded();
 }
 
 bool FlatFieldCorrection::correct(QVector<float> &img,
                                   const QVector<float> &darkFrame,
                                   int width)
+{
+    if (!load()) {
+        errDevice << "Gains are not loaded";
+        return false;
+    }
+
+    return correct(img, darkFrame, width, m_reciprocalGains);
+}
+
+QVector<float> FlatFieldCorrection::reciprocalGains() const
+{
+    return m_reciprocalGains;
+}
+
+bool FlatFieldCorrection::correct(QVector<float> &img,
+                                  const QVector<float> &darkFrame,
+                                  int width, const QVector<float> &reciprocalGains)
 {
     infoDevice << "Starting Flat Field Correction";
 
-    if (width < 1 || m_gains.size() != width) {
-        errDevice << "Bad gains or width param";
+    if (img.isEmpty() || (width > 0 && img.size() % width)) {
+        errDevice << "Bad images sizes";
         return false;
     }
 
-    if (img.isEmpty() || darkFrame.isEmpty() || img.size() % width || darkFrame.size() % width) {
-        errDevice << "Bad images sizes";
+    RowsCorrection correction;
+    if (!correction.start(darkFrame, width, reciprocalGains)) {
         return false;
     }
 
-    const QVector<float> darkFrameRates = ratesFromDarkFrame(darkFrame, width);
-    const int height = img.size() / width;
+    correction.correctRows(img.data(), img.size() / width);
+    correction.finish(img);
+    return true;
+}
 
-    int minValue = 0;
-    for (int i = 0; i < width; ++i) {
-        for (int j = 0; j < height; ++j) {
-            const int index = j * width + i;
-            int value = qCeil(static_cast<double>((img.at(index) - darkFrameRates.at(i)) / qAbs(m_gains.at(i))));
-            if (value < minValue) {
-                minValue = value;
-            }
+FlatFieldCorrection::RowsCorrection::RowsCorrection() :
+    m_width(0),
+    m_minValue(0)
+{
 
-            img[index] = value;
-        }
+}
+
+bool FlatFieldCorrection::RowsCorrection::start(const QVector<float> &darkFrame, int width,
+                                                const QVector<float> &reciprocalGains)
+{
+    if (width < 1 || reciprocalGains.size() != width) {
+        errDevice << "Bad gains or width param";
+        return false;
     }
 
-    if (minValue) {
-        for (int i = 0; i < img.size(); ++i) {
-            img[i] -= minValue;
-        }
+    if (darkFrame.isEmpty() || darkFrame.size() % width) {
+        errDevice << "Bad images sizes";
+        return false;
     }
 
+    m_rates = ratesFromDarkFrame(darkFrame, width);
+    m_reciprocalGains = reciprocalGains;
+    m_width = width;
+    m_minValue = 0;
     return true;
 }
 
+bool FlatFieldCorrection::RowsCorrection::isStarted() const
+{
+    return m_width > 0;
+}
+
+int FlatFieldCorrection::RowsCorrection::width() const
+{
+    return m_width;
+}
+
+void FlatFieldCorrection::RowsCorrection::correctRows(float *rows, int count)
+{
+    static const CorrectRowFunc correctRow = selectCorrectRow();
+
+    const float *rates = m_rates.constData();
+    const float *gains = m_reciprocalGains.constData();
+
+    for (int j = 0; j < count; ++j) {
+        m_minValue = correctRow(rows + j * m_width, rates, gains, m_width, m_minValue);
+    }
+}
+
+void FlatFieldCorrection::RowsCorrection::finish(QVector<float> &img) const
+{
+    const float minValue = m_minValue;
+
+    if (minValue < 0) {
+        std::for_each(img.begin(), img.end(), [minValue](float &value) {
+            value -= minValue;
+        });
+    }
+}
+
 void FlatFieldCorrection::setLastCalibrationDateTime(const QDateTime &lastCalibration)
 {
     QMutexLocker locker(&m_lastCalibrationMutex);
     m_lastCalibration = lastCalibration;
 }
+
+void FlatFieldCorrection::setGains(const QVector<float> &gains)
+{
+    m_gains = gains;
+
+    m_reciprocalGains.resize(gains.size());
+    for (int i = 0; i < gains.size(); ++i) {
+        m_reciprocalGains[i] = 1.f / qAbs(gains.at(i));
+    }
+}
@@ -7,12 +7,56 @@
 #include <QDateTime>
 #include <QMutex>
 
+class QFile;
+
 class DEVICELIB_EXPORT FlatFieldCorrection
 {    
     Q_DISABLE_COPY(FlatFieldCorrection)
 public:
-    explicit FlatFieldCorrection(const QString &filename);
+    /**
+     * Corrects frame by row blocks in any order, e.g. while it
+     * is still captured. Result equals correct() of whole frame
+     * once finish() subtracted minimum of all corrected rows
+     **/
+    class DEVICELIB_EXPORT RowsCorrection
+    {
+    public:
+        RowsCorrection();
+        bool start(const QVector<float> &darkFrame, int width,
+                   const QVector<float> &reciprocalGains);
+        bool isStarted() const;
+        int width() const;
+        void correctRows(float *rows, int count);
+        void finish(QVector<float> &img) const;
+    private:
+        QVector<float> m_rates;
+        QVector<float> m_reciprocalGains;
+        int m_width;
+        float m_minValue;
+    };
+
+    /**
+     * Scanning mode UUID is stored in gains file header and
+     * checked on loading if both of them are not null
+     **/
+    explicit FlatFieldCorrection(const QString &filename,
+                                 const QString &scanningModeUuid = QString());
     QDateTime lastCalibrationDateTime() const;
+    /**
+     * Gains are not loaded by constructor. They are loaded
+     * by first correction or explicit load() call
+     **/
+    bool isLoaded() const;
+    bool load();
+    /**
+     * Releases gains memory. Calibration date is kept
+     **/
+    void unload();
+    /**
+     * Reads only calibration date from gains file header once.
+     * Legacy text file is loaded completely
+     **/
+    void loadLastCalibrationDateTime();
     bool calibrate(const QVector<float> &img,
                    const QVector<float> &darkFrame,
                    int width);
@@ -20,17 +64,45 @@ public:
                  const QVector<float> &darkFrame,
                  int width);
     int width() const;
+
+    /**
+     * Empty if gains are not loaded. Returned copy stays
+     * valid after unload(), so frame can be corrected
+     * without holding owner lock
+     **/
+    QVector<float> reciprocalGains() const;
+    /**
+     * Saves gains computed by computeGains() as new calibration.
+     * Gains are applied even if saving fails, but then false
+     * is returned and they exist only until unload()
+     **/
+    bool setCalibration(const QVector<float> &gains);
+    bool hasUnsavedGains() const;
+
+    static bool computeGains(const QVector<float> &img,
+                             const QVector<float> &darkFrame,
+                             int width, QVector<float> &gains);
+    static bool correct(QVector<float> &img,
+                        const QVector<float> &darkFrame,
+                        int width, const QVector<float> &reciprocalGains);
 private:
     void setLastCalibrationDateTime(const QDateTime &lastCalibration);
+    void setGains(const QVector<float> &gains);
 
-    void loadGains();
-    bool saveGains(const QVector<float> &gains);
-    QVector<float> ratesFromDarkFrame(const QVector<float>& darkFrame, int width) const;
+    bool loadGains();
+    bool loadBinaryGains(QFile &f, QVector<float> &gains, QDateTime &lastCalibration) const;
+    bool loadLegacyGains(QFile &f, QVector<float> &gains, QDateTime &lastCalibration) const;
+    bool saveGains(const QVector<float> &gains, const QDateTime &lastCalibration);
+    static QVector<float> ratesFromDarkFrame(const QVector<float>& darkFrame, int width);
 
     QString m_filename;
+    QString m_scanningModeUuid;
     mutable QMutex m_lastCalibrationMutex;
     QDateTime m_lastCalibration;
+    bool m_lastCalibrationLoaded;
+    bool m_unsavedGains;
     QVector<float> m_gains;
+    QVector<float> m_reciprocalGains;
 };
 
 #endif // FLATFIELDCORRECTION_H
@@ -1,5 +1,7 @@
 #include "FlipAcquisitionResultProcessor.h"
 
+#include "FrameGeometry.h"
+
 FlipAcquisitionResultProcessor::FlipAcquisitionResultProcessor() :
     m_flipHorizontal(false)
 {
@@ -17,13 +19,8 @@ void FlipAcquisitionResultProcessor::process(Scanner::AcquisitionResult &result)
         return;
     }
 
-    QVector<float> &img = result.image;
-    int width = result.width;
-    int height = img.size() / width;
+    const int width = result.width;
+    const int height = result.image.size() / width;
 
-    for (int i = 0; i < height; ++i) {
-        for (int j = 0; j < width / 2; ++j) {
-            std::swap(img[i * width + j], img[i * width + width - j - 1]);
-        }
-    }
+    FrameGeometry::flip(result.image.data(), width, height, true, false);
 }
@@ -0,0 +1,276 @@
+#include "FrameGeometry.h"
+
+#include <QVarLengthArray>
+
+#include <cstring>
+
+#include "CpuFeatures.h"
+#include "ParallelFor.h"
+
+namespace {
+    const int MIN_ROWS_PER_BLOCK = 16;
+    const int STACK_LINE_SIZE = 8192;
+    // 32x32 tiles of source and destination take 8 KB
+    // together and stay in L1 cache while transposed
+    const int TRANSPOSE_TILE = 32;
+
+    typedef void (*ReverseFunc)(const float *src, float *dst, int count);
+
+    /**
+     * Both ends are read before they are written,
+     * so src and dst may be the same line
+     **/
+    void reverseScalar(const float *src, float *dst, int left, int right)
+    {
+        for (; right - left >= 2; ++left, --right) {
+            const float a = src[left];
+            const float b = src[right - 1];
+            dst[left] = b;
+            dst[right - 1] = a;
+        }
+
+        if (right > left) {
+            dst[left] = src[left];
+        }
+    }
+
+    void reverseScalar(const float *src, float *dst, int count)
+    {
+        reverseScalar(src, dst, 0, count);
+    }
+
+#if defined(DEVICE_SIMD_X86)
+    DEVICE_TARGET_SSE41
+    void reverseSse41(const float *src, float *dst, int count)
+    {
+        int left = 0;
+        int right = count;
+        for (; right - left >= 8; left += 4, right -= 4) {
+            const __m128 a = _mm_loadu_ps(src + left);
+            const __m128 b = _mm_loadu_ps(src + right - 4);
+            _mm_storeu_ps(dst + left, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 1, 2, 3)));
+            _mm_storeu_ps(dst + right - 4, _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3)));
+        }
+
+        reverseScalar(src, dst, left, right);
+    }
+
+    DEVICE_TARGET_AVX2
+    void reverseAvx2(const float *src, float *dst, int count)
+    {
+        const __m256i order = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+        int left = 0;
+        int right = count;
+        for (; right - left >= 16; left += 8, right -= 8) {
+            const __m256 a = _mm256_loadu_ps(src + left);
+            const __m256 b = _mm256_loadu_ps(src + right - 8);
+            _mm256_storeu_ps(dst + left, _mm256_permutevar8x32_ps(b, order));
+            _mm256_storeu_ps(dst + right - 8, _mm256_permutevar8x32_ps(a, order));
+        }
+
+        reverseScalar(src, dst, left, right);
+    }
+#endif
+
+    ReverseFunc selectReverse()
+    {
+#if defined(DEVICE_SIMD_X86)
+        if (CpuFeatures::hasAvx2()) {
+            return reverseAvx2;
+        }
+
+        if (CpuFeatures::hasSse41()) {
+            return reverseSse41;
+        }
+#endif
+
+        return reverseScalar;
+    }
+
+    void copyLine(const float *src, float *dst, int width, bool reversed)
+    {
+        if (reversed) {
+            FrameGeometry::reverse(src, dst, width);
+        } else if (src != dst) {
+            std::memcpy(dst, src, width * sizeof(float));
+        }
+    }
+
+    /**
+     * Vertical flip swaps line pairs through stack line,
+     * so it is done in place without frame sized buffer
+     **/
+    void mirror(const float *src, int width, int height, bool horizontal, bool vertical, float *dst)
+    {
+        if (!vertical) {
+            if (!horizontal && src == dst) {
+                return;
+            }
+
+            ParallelFor::run(height, MIN_ROWS_PER_BLOCK, [=](int, int begin, int end) {
+                for (int i = begin; i < end; ++i) {
+                    copyLine(src + i * width, dst + i * width, width, horizontal);
+                }
+            });
+            return;
+        }
+
+        ParallelFor::run((height + 1) / 2, MIN_ROWS_PER_BLOCK / 2, [=](int, int begin, int end) {
+            QVarLengthArray<float, STACK_LINE_SIZE> line(width);
+
+            for (int i = begin; i < end; ++i) {
+                const int j = height - 1 - i;
+                if (i == j) {
+                    copyLine(src + i * width, dst + i * width, width, horizontal);
+                    continue;
+                }
+
+                copyLine(src + i * width, line.data(), width, horizontal);
+                copyLine(src + j * width, dst + i * width, width, horizontal);
+                copyLine(line.constData(), dst + j * width, width, false);
+            }
+        });
+    }
+
+    /**
+     * Destination line r is source column x(r) read from
+     * top to bottom or backwards. Destination width is
+     * source height
+     **/
+    struct Transposition
+    {
+        const float *src;
+        int width;
+        int height;
+        bool reverseX;
+        bool reverseY;
+        float *dst;
+
+        int x(int r) const { return reverseX ? width - 1 - r : r; }
+        int y(int c) const { return reverseY ? height - 1 - c : c; }
+    };
+
+    typedef void (*TransposeTileFunc)(const Transposition &t, int r0, int r1, int c0, int c1);
+
+    void transposeTileScalar(const Transposition &t, int r0, int r1, int c0, int c1)
+    {
+        for (int r = r0; r < r1; ++r) {
+            const float *column = t.src + t.x(r);
+            float *line = t.dst + r * t.height;
+            for (int c = c0; c < c1; ++c) {
+                line[c] = column[t.y(c) * t.width];
+            }
+        }
+    }
+
+#if defined(DEVICE_SIMD_X86)
+    DEVICE_TARGET_SSE41
+    void transposeTileSse41(const Transposition &t, int r0, int r1, int c0, int c1)
+    {
+        const int rEnd = r0 + (r1 - r0) / 4 * 4;
+        const int cEnd = c0 + (c1 - c0) / 4 * 4;
+
+        for (int r = r0; r < rEnd; r += 4) {
+            // Leftmost of four source columns, the rightmost
+            // of them goes to line r if columns are reversed
+            const int x = t.reverseX ? t.width - 4 - r : r;
+            float *lines[4];
+            for (int j = 0; j < 4; ++j) {
+                lines[j] = t.dst + (t.reverseX ? r + 3 - j : r + j) * t.height;
+            }
+
+            for (int c = c0; c < cEnd; c += 4) {
+                __m128 a0 = _mm_loadu_ps(t.src + t.y(c) * t.width + x);
+                __m128 a1 = _mm_loadu_ps(t.src + t.y(c + 1) * t.width + x);
+                __m128 a2 = _mm_loadu_ps(t.src + t.y(c + 2) * t.width + x);
+                __m128 a3 = _mm_loadu_ps(t.src + t.y(c + 3) * t.width + x);
+                _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+                _mm_storeu_ps(lines[0] + c, a0);
+                _mm_storeu_ps(lines[1] + c, a1);
+                _mm_storeu_ps(lines[2] + c, a2);
+                _mm_storeu_ps(lines[3] + c, a3);
+            }
+        }
+
+        transposeTileScalar(t, r0, rEnd, cEnd, c1);
+        transposeTileScalar(t, rEnd, r1, c0, c1);
+    }
+#endif
+
+    TransposeTileFunc selectTransposeTile()
+    {
+#if defined(DEVICE_SIMD_X86)
+        if (CpuFeatures::hasSse41()) {
+            return transposeTileSse41;
+        }
+#endif
+
+        return transposeTileScalar;
+    }
+
+    void transpose(const Transposition &t)
+    {
+        static const TransposeTileFunc transposeTile = selectTransposeTile();
+
+        const int tiles = (t.width + TRANSPOSE_TILE - 1) / TRANSPOSE_TILE;
+        ParallelFor::run(tiles, 1, [&](int, int begin, int end) {
+            for (int r0 = begin * TRANSPOSE_TILE; r0 < qMin(end * TRANSPOSE_TILE, t.width); r0 += TRANSPOSE_TILE) {
+                const int r1 = qMin(r0 + TRANSPOSE_TILE, t.width);
+                for (int c0 = 0; c0 < t.height; c0 += TRANSPOSE_TILE) {
+                    transposeTile(t, r0, r1, c0, qMin(c0 + TRANSPOSE_TILE, t.height));
+                }
+            }
+        });
+    }
+}
+
+FrameGeometry::Rotation FrameGeometry::rotationFromDegrees(int degrees)
+{
+    switch ((degrees % 360 + 360) % 360) {
+    case 90: return Rotate90;
+    case 180: return Rotate180;
+    case 270: return Rotate270;
+    default:
+        return Rotate0;
+    }
+}
+
+bool FrameGeometry::swapsSides(Rotation rotation)
+{
+    return rotation == Rotate90 || rotation == Rotate270;
+}
+
+void FrameGeometry::reverse(const float *src, float *dst, int count)
+{
+    static const ReverseFunc reverseFunc = selectReverse();
+    reverseFunc(src, dst, count);
+}
+
+void FrameGeometry::flip(float *img, int width, int height, bool horizontal, bool vertical)
+{
+    mirror(img, width, height, horizontal, vertical, img);
+}
+
+void FrameGeometry::transform(const float *src, int width, int height, bool flipHorizontal,
+                              bool flipVertical, Rotation rotation, float *dst)
+{
+    if (width < 1 || height < 1) {
+        return;
+    }
+
+    switch (rotation) {
+    case Rotate90:
+        transpose({src, width, height, flipHorizontal, !flipVertical, dst});
+        break;
+    case Rotate180:
+        mirror(src, width, height, !flipHorizontal, !flipVertical, dst);
+        break;
+    case Rotate270:
+        transpose({src, width, height, !flipHorizontal, flipVertical, dst});
+        break;
+    default:
+        mirror(src, width, height, flipHorizontal, flipVertical, dst);
+        break;
+    }
+}
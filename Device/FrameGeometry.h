@@ -0,0 +1,47 @@
+#ifndef DEVICE_FRAMEGEOMETRY_H
+#define DEVICE_FRAMEGEOMETRY_H
+
+#include "DeviceGlobal.h"
+
+/**
+ * Flips and rotations of row-major float frames. Flips are
+ * applied first, then frame is rotated clockwise
+ **/
+class DEVICELIB_EXPORT FrameGeometry final
+{
+public:
+    enum Rotation {
+        Rotate0 = 0,
+        Rotate90 = 90,
+        Rotate180 = 180,
+        Rotate270 = 270
+    };
+
+    /**
+     * Rotation by degrees multiple of 90, Rotate0 otherwise
+     **/
+    static Rotation rotationFromDegrees(int degrees);
+    /**
+     * Rotations by 90 and 270 swap width and height
+     **/
+    static bool swapsSides(Rotation rotation);
+
+    /**
+     * Reverses count values of src into dst, which may be src
+     **/
+    static void reverse(const float *src, float *dst, int count);
+    /**
+     * Flips frame in place with rows split between threads
+     **/
+    static void flip(float *img, int width, int height, bool horizontal, bool vertical);
+    /**
+     * Writes transformed frame into dst, its width is height of src
+     * if rotation swaps sides. Dst may be src only if it doesn't
+     **/
+    static void transform(const float *src, int width, int height, bool flipHorizontal,
+                          bool flipVertical, Rotation rotation, float *dst);
+private:
+    FrameGeometry() = delete;
+};
+
+#endif // DEVICE_FRAMEGEOMETRY_H
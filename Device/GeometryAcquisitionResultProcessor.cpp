@@ -0,0 +1,49 @@
+#include "GeometryAcquisitionResultProcessor.h"
+
+GeometryAcquisitionResultProcessor::GeometryAcquisitionResultProcessor() :
+    m_flipHorizontal(false),
+    m_flipVertical(false),
+    m_rotation(FrameGeometry::Rotate0)
+{
+
+}
+
+void GeometryAcquisitionResultProcessor::setFlipHorizontal(bool flip)
+{
+    m_flipHorizontal = flip;
+}
+
+void GeometryAcquisitionResultProcessor::setFlipVertical(bool flip)
+{
+    m_flipVertical = flip;
+}
+
+void GeometryAcquisitionResultProcessor::setRotation(FrameGeometry::Rotation rotation)
+{
+    m_rotation = rotation;
+}
+
+void GeometryAcquisitionResultProcessor::process(Scanner::AcquisitionResult &result) const
+{
+    if (result.width < 1 || result.image.size() < result.width ||
+        (!m_flipHorizontal && !m_flipVertical && m_rotation == FrameGeometry::Rotate0)) {
+        return;
+    }
+
+    const int width = result.width;
+    const int height = result.image.size() / width;
+
+    if (!FrameGeometry::swapsSides(m_rotation)) {
+        float *img = result.image.data();
+        FrameGeometry::transform(img, width, height, m_flipHorizontal, m_flipVertical, m_rotation, img);
+        return;
+    }
+
+    QVector<float> rotated(width * height);
+    FrameGeometry::transform(result.image.constData(), width, height, m_flipHorizontal, m_flipVertical,
+                             m_rotation, rotated.data());
+
+    result.image.swap(rotated);
+    result.width = height;
+    result.pixelSize.transpose();
+}
@@ -0,0 +1,28 @@
+#ifndef DEVICE_GEOMETRYACQUISITIONRESULTPROCESSOR_H
+#define DEVICE_GEOMETRYACQUISITIONRESULTPROCESSOR_H
+
+#include "FrameGeometry.h"
+#include "ScannerAcquisitionResultProcessor.h"
+
+/**
+ * Compensates mirrored or rotated detector mounting. Flips and
+ * rotation by 180 are done in place, rotations by 90 and 270
+ * transpose frame into new buffer in one pass
+ **/
+class DEVICELIB_EXPORT GeometryAcquisitionResultProcessor : public ScannerAcquisitionResultProcessor
+{
+public:
+    GeometryAcquisitionResultProcessor();
+
+    void setFlipHorizontal(bool flip);
+    void setFlipVertical(bool flip);
+    void setRotation(FrameGeometry::Rotation rotation);
+
+    void process(Scanner::AcquisitionResult &result) const override;
+private:
+    bool m_flipHorizontal;
+    bool m_flipVertical;
+    FrameGeometry::Rotation m_rotation;
+};
+
+#endif // DEVICE_GEOMETRYACQUISITIONRESULTPROCESSOR_H
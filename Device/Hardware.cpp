@@ -4,6 +4,7 @@
 #include <QMutex>
 
 #include "PowerSupply.h"
+#include "Trace.h"
 
 struct Hardware::PImpl
 {
@@ -49,6 +50,7 @@ bool Hardware::openDoor(Hardware::Door door)
 bool Hardware::openDoor(Hardware::Door door, CancelationTokenSource::Token token)
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::openDoor", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -65,6 +67,7 @@ bool Hardware::closeDoor(Hardware::Door door)
 bool Hardware::closeDoor(Hardware::Door door, CancelationTokenSource::Token token)
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::closeDoor", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -101,6 +104,7 @@ bool Hardware::moveRackToBottom()
 bool Hardware::moveRackToBottom(CancelationTokenSource::Token token)
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::moveRackToBottom", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -112,6 +116,7 @@ bool Hardware::moveRackToBottom(CancelationTokenSource::Token token)
 bool Hardware::moveRackToBottomAndOpenFirstDoor()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::moveRackToBottomAndOpenFirstDoor", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -123,6 +128,7 @@ bool Hardware::moveRackToBottomAndOpenFirstDoor()
 bool Hardware::moveRackToBottomAndCloseFirstDoor()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::moveRackToBottomAndCloseFirstDoor", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -139,6 +145,7 @@ bool Hardware::moveRackToTop()
 bool Hardware::moveRackToTop(CancelationTokenSource::Token token)
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::moveRackToTop", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -183,6 +190,7 @@ bool Hardware::moveRackStop()
 bool Hardware::lockRemote()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::lockRemote", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -194,6 +202,7 @@ bool Hardware::lockRemote()
 bool Hardware::unlockRemote()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::unlockRemote", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -205,6 +214,7 @@ bool Hardware::unlockRemote()
 bool Hardware::refreshState()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::refreshState", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -225,6 +235,7 @@ bool Hardware::refreshState()
 bool Hardware::pressPrepareButton()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::pressPrepareButton", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -236,6 +247,7 @@ bool Hardware::pressPrepareButton()
 bool Hardware::startScan(PowerSupply *powerSupply)
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::startScan", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -251,6 +263,7 @@ bool Hardware::startScan(PowerSupply *powerSupply)
 bool Hardware::stopScan()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("Hardware::stopScan", "hardware");
 
     if (!checkIsOpen()) {
         return false;
@@ -0,0 +1,112 @@
+#include "LatencyHistogram.h"
+
+#include <QtAlgorithms>
+
+namespace {
+    const int FIRST_BUCKET_BITS = 4;
+}
+
+LatencyHistogram::Snapshot::Snapshot() :
+    buckets(bucketsCount, 0),
+    count(0),
+    totalUs(0),
+    maxUs(0)
+{
+
+}
+
+qint64 LatencyHistogram::Snapshot::meanUs() const
+{
+    return count ? totalUs / static_cast<qint64>(count) : 0;
+}
+
+qint64 LatencyHistogram::Snapshot::percentileUs(int percent) const
+{
+    if (!count) {
+        return 0;
+    }
+
+    const quint64 rank = (count * static_cast<quint64>(qBound(0, percent, 100)) + 99) / 100;
+    quint64 accumulated = 0;
+
+    for (int i = 0; i < buckets.size(); ++i) {
+        accumulated += buckets.at(i);
+        if (accumulated >= rank) {
+            return qMin(bucketUpperBoundUs(i), maxUs);
+        }
+    }
+
+    return maxUs;
+}
+
+QString LatencyHistogram::Snapshot::toString() const
+{
+    return QStringLiteral("n=%1 mean=%2us p50=%3us p99=%4us max=%5us")
+            .arg(count)
+            .arg(meanUs())
+            .arg(percentileUs(50))
+            .arg(percentileUs(99))
+            .arg(maxUs);
+}
+
+LatencyHistogram::LatencyHistogram() :
+    m_count(0),
+    m_totalUs(0),
+    m_maxUs(0)
+{
+    reset();
+}
+
+void LatencyHistogram::record(qint64 us)
+{
+    us = qMax<qint64>(us, 0);
+
+    m_buckets[bucketIndex(us)].fetchAndAddRelaxed(1);
+    m_count.fetchAndAddRelaxed(1);
+    m_totalUs.fetchAndAddRelaxed(us);
+
+    qint64 max = m_maxUs.loadRelaxed();
+    while (us > max && !m_maxUs.testAndSetRelaxed(max, us, max)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const
+{
+    // Counters are read one by one, so snapshot taken while
+    // recording may be off by the values recorded meanwhile
+    Snapshot snapshot;
+    for (int i = 0; i < bucketsCount; ++i) {
+        snapshot.buckets[i] = m_buckets[i].loadRelaxed();
+    }
+
+    snapshot.count = m_count.loadRelaxed();
+    snapshot.totalUs = m_totalUs.loadRelaxed();
+    snapshot.maxUs = m_maxUs.loadRelaxed();
+    return snapshot;
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : m_buckets) {
+        bucket.storeRelaxed(0);
+    }
+
+    m_count.storeRelaxed(0);
+    m_totalUs.storeRelaxed(0);
+    m_maxUs.storeRelaxed(0);
+}
+
+int LatencyHistogram::bucketIndex(qint64 us)
+{
+    if (us < (Q_INT64_C(1) << FIRST_BUCKET_BITS)) {
+        return 0;
+    }
+
+    const int bits = 64 - qCountLeadingZeroBits(static_cast<quint64>(us));
+    return qMin(bits - FIRST_BUCKET_BITS, bucketsCount - 1);
+}
+
+qint64 LatencyHistogram::bucketUpperBoundUs(int bucket)
+{
+    return Q_INT64_C(1) << (bucket + FIRST_BUCKET_BITS);
+}
@@ -0,0 +1,55 @@
+#ifndef DEVICE_LATENCYHISTOGRAM_H
+#define DEVICE_LATENCYHISTOGRAM_H
+
+#include "DeviceGlobal.h"
+
+#include <QAtomicInteger>
+#include <QString>
+#include <QVector>
+
+/**
+ * Lock-free histogram of durations in microseconds with power
+ * of two buckets. Recording is safe from any thread
+ **/
+class DEVICELIB_EXPORT LatencyHistogram final
+{
+    Q_DISABLE_COPY(LatencyHistogram)
+public:
+    static constexpr int bucketsCount = 24;
+
+    struct DEVICELIB_EXPORT Snapshot
+    {
+        Snapshot();
+        qint64 meanUs() const;
+        /**
+         * Upper bound of bucket holding percentile
+         **/
+        qint64 percentileUs(int percent) const;
+        QString toString() const;
+
+        QVector<quint32> buckets;
+        quint64 count;
+        qint64 totalUs;
+        qint64 maxUs;
+    };
+
+    LatencyHistogram();
+
+    void record(qint64 us);
+    Snapshot snapshot() const;
+    void reset();
+
+    /**
+     * Bucket 0 holds durations below 16 us, every next
+     * one holds durations below twice as much
+     **/
+    static int bucketIndex(qint64 us);
+    static qint64 bucketUpperBoundUs(int bucket);
+private:
+    QAtomicInteger<quint32> m_buckets[bucketsCount];
+    QAtomicInteger<quint64> m_count;
+    QAtomicInteger<qint64> m_totalUs;
+    QAtomicInteger<qint64> m_maxUs;
+};
+
+#endif // DEVICE_LATENCYHISTOGRAM_H
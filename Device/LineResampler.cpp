@@ -0,0 +1,196 @@
+#include "LineResampler.h"
+
+#include <cmath>
+
+#include "CpuFeatures.h"
+#include "ParallelFor.h"
+
+namespace {
+    const int MIN_ROWS_PER_BLOCK = 16;
+    const double CUBIC_A = -0.75;
+    const double LANCZOS_RADIUS = 3;
+    const double PI = 3.14159265358979323846;
+
+    typedef void (*ResampleLineFunc)(const float *line, const int *offsets, const float *weights,
+                                     int taps, int count, float *dst);
+
+    double cubic(double x)
+    {
+        x = std::fabs(x);
+        if (x < 1) {
+            return ((CUBIC_A + 2) * x - (CUBIC_A + 3)) * x * x + 1;
+        }
+
+        if (x < 2) {
+            return ((CUBIC_A * x - 5 * CUBIC_A) * x + 8 * CUBIC_A) * x - 4 * CUBIC_A;
+        }
+
+        return 0;
+    }
+
+    double lanczos(double x)
+    {
+        x = std::fabs(x);
+        if (x < 1e-9) {
+            return 1;
+        }
+
+        if (x >= LANCZOS_RADIUS) {
+            return 0;
+        }
+
+        const double px = PI * x;
+        return LANCZOS_RADIUS * std::sin(px) * std::sin(px / LANCZOS_RADIUS) / (px * px);
+    }
+
+    void resampleLineScalar(const float *line, const int *offsets, const float *weights,
+                            int taps, int count, float *dst)
+    {
+        for (int x = 0; x < count; ++x, weights += taps) {
+            const float *src = line + offsets[x];
+            float value = 0;
+            for (int k = 0; k < taps; ++k) {
+                value += src[k] * weights[k];
+            }
+            dst[x] = value;
+        }
+    }
+
+#if defined(DEVICE_SIMD_X86)
+    /**
+     * Taps count is multiple of 4. Four output columns are
+     * accumulated in separate registers and reduced together
+     * by transposition instead of horizontal adds
+     **/
+    DEVICE_TARGET_SSE41
+    void resampleLineSse41(const float *line, const int *offsets, const float *weights,
+                           int taps, int count, float *dst)
+    {
+        int x = 0;
+        for (; x + 4 <= count; x += 4) {
+            __m128 sums[4];
+            for (int j = 0; j < 4; ++j) {
+                const float *src = line + offsets[x + j];
+                const float *w = weights + (x + j) * taps;
+                __m128 acc = _mm_mul_ps(_mm_loadu_ps(src), _mm_loadu_ps(w));
+                for (int k = 4; k < taps; k += 4) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src + k), _mm_loadu_ps(w + k)));
+                }
+                sums[j] = acc;
+            }
+
+            _MM_TRANSPOSE4_PS(sums[0], sums[1], sums[2], sums[3]);
+            _mm_storeu_ps(dst + x, _mm_add_ps(_mm_add_ps(sums[0], sums[1]), _mm_add_ps(sums[2], sums[3])));
+        }
+
+        resampleLineScalar(line, offsets + x, weights + x * taps, taps, count - x, dst + x);
+    }
+#endif
+
+    ResampleLineFunc selectResampleLine(int taps)
+    {
+#if defined(DEVICE_SIMD_X86)
+        if (taps % 4 == 0 && CpuFeatures::hasSse41()) {
+            return resampleLineSse41;
+        }
+#endif
+
+        return resampleLineScalar;
+    }
+}
+
+LineResampler::LineResampler() :
+    m_srcWidth(0),
+    m_dstWidth(0),
+    m_filter(Cubic),
+    m_taps(0)
+{
+
+}
+
+void LineResampler::setGeometry(int srcWidth, int dstWidth, Filter filter)
+{
+    if (srcWidth == m_srcWidth && dstWidth == m_dstWidth && filter == m_filter) {
+        return;
+    }
+
+    m_srcWidth = srcWidth;
+    m_dstWidth = dstWidth;
+    m_filter = filter;
+    m_taps = 0;
+    m_offsets.clear();
+    m_weights.clear();
+
+    if (srcWidth < 1 || dstWidth < 1) {
+        return;
+    }
+
+    const double scale = static_cast<double>(srcWidth) / dstWidth;
+    const double stretch = filter == Lanczos3 ? qMax(1.0, scale) : 1.0;
+    const double support = (filter == Lanczos3 ? LANCZOS_RADIUS : 2.0) * stretch;
+    const int radius = static_cast<int>(std::ceil(support));
+
+    // Taps beyond support have zero weights and
+    // are added to make vectorized loop exact
+    m_taps = qMin((2 * radius + 3) / 4 * 4, srcWidth);
+    m_offsets.resize(dstWidth);
+    m_weights.resize(dstWidth * m_taps);
+
+    QVector<double> taps(m_taps);
+    for (int x = 0; x < dstWidth; ++x) {
+        // Pixel centers are aligned as in cv::resize
+        const double center = (x + 0.5) * scale - 0.5;
+        const int first = static_cast<int>(std::floor(center)) - radius + 1;
+        const int offset = qBound(0, first, srcWidth - m_taps);
+
+        taps.fill(0);
+        double sum = 0;
+        for (int k = 0; k < 2 * radius; ++k) {
+            const double distance = (first + k - center) / stretch;
+            const double weight = filter == Lanczos3 ? lanczos(distance) : cubic(distance);
+            taps[qBound(0, first + k, srcWidth - 1) - offset] += weight;
+            sum += weight;
+        }
+
+        m_offsets[x] = offset;
+        float *weights = m_weights.data() + x * m_taps;
+        for (int k = 0; k < m_taps; ++k) {
+            weights[k] = static_cast<float>(taps.at(k) / sum);
+        }
+    }
+}
+
+int LineResampler::srcWidth() const
+{
+    return m_srcWidth;
+}
+
+int LineResampler::dstWidth() const
+{
+    return m_dstWidth;
+}
+
+LineResampler::Filter LineResampler::filter() const
+{
+    return m_filter;
+}
+
+void LineResampler::resampleRows(const float *src, int rows, float *dst) const
+{
+    if (m_taps < 1) {
+        return;
+    }
+
+    const ResampleLineFunc resampleLine = selectResampleLine(m_taps);
+    for (int i = 0; i < rows; ++i) {
+        resampleLine(src + i * m_srcWidth, m_offsets.constData(), m_weights.constData(),
+                     m_taps, m_dstWidth, dst + i * m_dstWidth);
+    }
+}
+
+void LineResampler::resample(const float *src, int rows, float *dst) const
+{
+    ParallelFor::run(rows, MIN_ROWS_PER_BLOCK, [=](int, int begin, int end) {
+        resampleRows(src + begin * m_srcWidth, end - begin, dst + begin * m_dstWidth);
+    });
+}
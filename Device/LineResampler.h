@@ -0,0 +1,51 @@
+#ifndef DEVICE_LINERESAMPLER_H
+#define DEVICE_LINERESAMPLER_H
+
+#include <QVector>
+
+#include "DeviceGlobal.h"
+
+/**
+ * Changes width of frame lines keeping their count. Filter taps
+ * of every output column are computed once by setGeometry(),
+ * source lines are extended by replicating edge pixels
+ **/
+class DEVICELIB_EXPORT LineResampler final
+{
+public:
+    enum Filter {
+        /** Same kernel and taps as cv::INTER_CUBIC **/
+        Cubic,
+        /** Kernel is widened on downscale, so it doesn't alias **/
+        Lanczos3
+    };
+
+    LineResampler();
+
+    /**
+     * Does nothing if geometry and filter are not changed
+     **/
+    void setGeometry(int srcWidth, int dstWidth, Filter filter = Cubic);
+    int srcWidth() const;
+    int dstWidth() const;
+    Filter filter() const;
+
+    /**
+     * Resamples rows lines of src into dst in the calling thread
+     **/
+    void resampleRows(const float *src, int rows, float *dst) const;
+    /**
+     * Resamples rows lines with them split between threads
+     **/
+    void resample(const float *src, int rows, float *dst) const;
+private:
+    int m_srcWidth;
+    int m_dstWidth;
+    Filter m_filter;
+    int m_taps;
+    // First source pixel and taps weights of every output column
+    QVector<int> m_offsets;
+    QVector<float> m_weights;
+};
+
+#endif // DEVICE_LINERESAMPLER_H
@@ -1,115 +1,120 @@
 #include "NpFrame.h"
 
-#include "DeviceLogging.h"
+#include <cstring>
 
-NpFrame::NpFrame()
+NpFrame::NpFrame(const QByteArray &bytes) :
+    m_data{{0, 0, 0, 0, 0, 0}},
+    m_length(static_cast<quint8>(qMin(bytes.size(), size + 1)))
 {
-
+    std::memcpy(m_data.data(), bytes.constData(), static_cast<size_t>(storedLength()));
 }
 
-NpFrame::NpFrame(quint8 addr, quint8 cmd,
-                 quint8 reg1, quint8 reg2, quint8 reg3)
+NpFrame NpFrame::fromRawData(const char *data)
 {
-    m_data = QByteArray(size, 0);
-    m_data[0] = addr;
-    m_data[1] = cmd;
-    m_data[2] = reg1;
-    m_data[3] = reg2;
-    m_data[4] = reg3;
-    m_data[5] = calcChecksum();
+    NpFrame frame;
+    std::memcpy(frame.m_data.data(), data, size);
+    frame.m_length = size;
+    return frame;
 }
 
-NpFrame::NpFrame(const QByteArray& bytes):
-    m_data(bytes)
+QByteArray NpFrame::toByteArray() const
 {
-
+    return QByteArray(reinterpret_cast<const char *>(m_data.data()), storedLength());
 }
 
-quint8 NpFrame::addr() const
+QByteArray NpFrame::toHex() const
 {
-    return getByte(0);
+    return toByteArray().toHex();
 }
 
-quint8 NpFrame::cmd() const
+NpFrame::operator QByteArray() const
 {
-    return getByte(1);
+    return toByteArray();
 }
 
-quint8 NpFrame::reg1() const
+bool NpFrame::isValid() const
 {
-    return getByte(2);
+    return m_length == size && hasValidChecksum(reinterpret_cast<const char *>(m_data.data()));
 }
 
-quint8 NpFrame::reg2() const
+QVector<NpFrame> NpFrame::splitFrames(const QByteArray &bytes)
 {
-    return getByte(3);
-}
+    QVector<NpFrame> frames;
+    frames.reserve((bytes.size() + size - 1) / size);
 
-quint8 NpFrame::reg3() const
-{
-    return getByte(4);
+    NpFrameReader reader(bytes);
+    while (reader.hasNext()) {
+        frames.append(reader.next());
+    }
+
+    return frames;
 }
 
-QByteArray NpFrame::toByteArray() const
+bool NpFrame::hasValidChecksum(const char *data)
 {
-    return m_data;
+    return checksum(static_cast<quint8>(data[0]), static_cast<quint8>(data[1]),
+                    static_cast<quint8>(data[2]), static_cast<quint8>(data[3]),
+                    static_cast<quint8>(data[4])) == static_cast<quint8>(data[size - 1]);
 }
 
-QByteArray NpFrame::toHex() const
+int NpFrame::completeFramesSize(const QByteArray &bytes,
+                                const std::function<bool(quint8 addr)> &isKnownAddress)
 {
-    return m_data.toHex();
+    int offset = 0;
+
+    // Stops on the first bytes which are not a frame for known address
+    while (bytes.size() - offset >= size) {
+        const char *frame = bytes.constData() + offset;
+        if (!isKnownAddress(static_cast<quint8>(frame[0])) || !hasValidChecksum(frame)) {
+            break;
+        }
+
+        offset += size;
+    }
+
+    return offset;
 }
 
-NpFrame::operator QByteArray() const
+int NpFrame::storedLength() const
 {
-    return m_data;
+    return m_length < size ? m_length : size;
 }
 
-bool NpFrame::isValid() const
+NpFrameReader::NpFrameReader(const QByteArray &bytes) :
+    m_bytes(bytes),
+    m_offset(0)
 {
-    const auto length = m_data.length();
-    if (length != size) {
-        errDevice << "Frame:" << m_data.toHex()
-                  << "Length:" << length
-                  << "Expected length:" << size;
-        return false;
-    }
 
-    auto receivedChecksum = static_cast<quint8>(m_data.at(5));
-    auto expectedChecksum = calcChecksum();
-
-    if (receivedChecksum != expectedChecksum) {
-        errDevice << "Frame:" << m_data.toHex()
-                  << "Checksum:" << QString::number(receivedChecksum, 16)
-                  << "Expected checksum:" << QString::number(expectedChecksum, 16);
-        return false;
-    }
+}
 
-    return true;
+bool NpFrameReader::hasNext() const
+{
+    return m_offset < m_bytes.size();
 }
 
-QVector<NpFrame> NpFrame::splitFrames(const QByteArray &bytes)
+NpFrame NpFrameReader::next()
 {
-    QVector<NpFrame> frames;
+    const int remaining = m_bytes.size() - m_offset;
+    const char *data = m_bytes.constData() + m_offset;
+    m_offset += NpFrame::size;
 
-    for (int i = 0; i < bytes.length(); i += size) {
-        frames.append(bytes.mid(i, size));
+    if (remaining >= NpFrame::size) {
+        return NpFrame::fromRawData(data);
     }
 
-    return frames;
+    return remaining > 0 ? NpFrame(QByteArray::fromRawData(data, remaining)) : NpFrame();
 }
 
-quint8 NpFrame::calcChecksum() const
+NpFrame NpFrameReader::last() const
 {
-    quint8 sum = m_data.at(0);
-    for (int i = 1; i < m_data.length() - 1; ++i) {
-        sum ^= m_data.at(i);
+    if (m_bytes.isEmpty()) {
+        return NpFrame();
     }
 
-    return sum;
-}
+    const int offset = (m_bytes.size() - 1) / NpFrame::size * NpFrame::size;
+    const int remaining = m_bytes.size() - offset;
+    const char *data = m_bytes.constData() + offset;
 
-quint8 NpFrame::getByte(int index) const
-{
-    return m_data.size() > index ? m_data.at(index) : 0;
+    return remaining == NpFrame::size ? NpFrame::fromRawData(data)
+                                      : NpFrame(QByteArray::fromRawData(data, remaining));
 }
@@ -4,31 +4,114 @@
 #include <QByteArray>
 #include <QVector>
 
+#include <array>
+#include <functional>
+
 #include "DeviceGlobal.h"
 
+/**
+ * Fixed size frame stored by value, so building,
+ * copying and validating it does no heap work
+ **/
 class DEVICELIB_EXPORT NpFrame final
 {
 public:
-    NpFrame();
-    NpFrame(quint8 addr, quint8 cmd, quint8 reg1 = 0, quint8 reg2 = 0, quint8 reg3 = 0);
+    static constexpr int size = 6;
+
+    constexpr NpFrame() :
+        m_data{{0, 0, 0, 0, 0, 0}},
+        m_length(0)
+    {
+
+    }
+
+    constexpr NpFrame(quint8 addr, quint8 cmd, quint8 reg1 = 0, quint8 reg2 = 0, quint8 reg3 = 0) :
+        m_data{{addr, cmd, reg1, reg2, reg3, checksum(addr, cmd, reg1, reg2, reg3)}},
+        m_length(size)
+    {
+
+    }
+
+    /**
+     * Bytes beyond frame size are dropped, but frame
+     * made of them is invalid and differs from exact one
+     **/
     NpFrame(const QByteArray &bytes);
 
-    quint8 addr() const;
-    quint8 cmd() const;
-    quint8 reg1() const;
-    quint8 reg2() const;
-    quint8 reg3() const;
+    /**
+     * Copies size bytes at data without validation
+     **/
+    static NpFrame fromRawData(const char *data);
+
+    quint8 addr() const { return m_data[0]; }
+    quint8 cmd() const { return m_data[1]; }
+    quint8 reg1() const { return m_data[2]; }
+    quint8 reg2() const { return m_data[3]; }
+    quint8 reg3() const { return m_data[4]; }
 
     QByteArray toByteArray() const;
     QByteArray toHex() const;
     operator QByteArray() const;
+    /**
+     * Doesn't log, callers report invalid frames with toHex()
+     **/
     bool isValid() const;
     static QVector<NpFrame> splitFrames(const QByteArray&);
-    static constexpr int size = 6;
+    /**
+     * Checks checksum of size bytes at data without logging
+     **/
+    static bool hasValidChecksum(const char *data);
+    /**
+     * Size of leading frames with valid checksum and accepted
+     * address. They are complete replies that don't need to wait
+     **/
+    static int completeFramesSize(const QByteArray &bytes,
+                                  const std::function<bool(quint8 addr)> &isKnownAddress);
+
+    static constexpr quint8 checksum(quint8 addr, quint8 cmd, quint8 reg1, quint8 reg2, quint8 reg3)
+    {
+        return static_cast<quint8>(addr ^ cmd ^ reg1 ^ reg2 ^ reg3);
+    }
+
+    friend bool operator==(const NpFrame &lhs, const NpFrame &rhs)
+    {
+        return lhs.m_length == rhs.m_length && lhs.m_data == rhs.m_data;
+    }
+private:
+    int storedLength() const;
+
+    std::array<quint8, size> m_data;
+    // size + 1 marks bytes longer than frame
+    quint8 m_length;
+};
+
+Q_DECLARE_TYPEINFO(NpFrame, Q_PRIMITIVE_TYPE);
+
+inline bool operator!=(const NpFrame &lhs, const NpFrame &rhs) { return !(lhs == rhs); }
+inline bool operator==(const NpFrame &lhs, const QByteArray &rhs) { return lhs == NpFrame(rhs); }
+inline bool operator!=(const NpFrame &lhs, const QByteArray &rhs) { return !(lhs == NpFrame(rhs)); }
+inline bool operator==(const QByteArray &lhs, const NpFrame &rhs) { return NpFrame(lhs) == rhs; }
+inline bool operator!=(const QByteArray &lhs, const NpFrame &rhs) { return !(NpFrame(lhs) == rhs); }
+
+/**
+ * Walks frames of buffer in place. Trailing bytes
+ * shorter than frame are returned as invalid frame
+ **/
+class DEVICELIB_EXPORT NpFrameReader final
+{
+public:
+    explicit NpFrameReader(const QByteArray &bytes);
+
+    bool hasNext() const;
+    NpFrame next();
+    /**
+     * Frame at the end of buffer, invalid if buffer is empty
+     **/
+    NpFrame last() const;
 private:
-    quint8 calcChecksum() const;
-    quint8 getByte(int index) const;
-    QByteArray m_data;
+    // Shares data with buffer instead of copying it
+    const QByteArray m_bytes;
+    int m_offset;
 };
 
 #endif // NPFRAME_H
@@ -0,0 +1,80 @@
+#include "ParallelFor.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+
+namespace {
+    class BlockRunnable : public QRunnable
+    {
+    public:
+        BlockRunnable(const ParallelFor::BlockFunc &func, int block,
+                      int begin, int end, QSemaphore &done) :
+            m_func(func),
+            m_block(block),
+            m_begin(begin),
+            m_end(end),
+            m_done(done)
+        {
+
+        }
+
+        void run() override
+        {
+            m_func(m_block, m_begin, m_end);
+            m_done.release();
+        }
+    private:
+        const ParallelFor::BlockFunc &m_func;
+        int m_block;
+        int m_begin;
+        int m_end;
+        QSemaphore &m_done;
+    };
+}
+
+int ParallelFor::blocksCount(int count, int minBlockSize)
+{
+    if (count < 1) {
+        return 0;
+    }
+
+    const int maxBlocks = qMax(1, QThread::idealThreadCount());
+    return qBound(1, count / qMax(1, minBlockSize), maxBlocks);
+}
+
+void ParallelFor::run(int count, int minBlockSize, const BlockFunc &func)
+{
+    const int blocks = blocksCount(count, minBlockSize);
+    if (!blocks) {
+        return;
+    }
+
+    const int blockSize = count / blocks;
+    const int remainder = count % blocks;
+
+    QSemaphore done;
+    int started = 0;
+
+    auto pool = QThreadPool::globalInstance();
+
+    // First blocks are one item longer to spread remainder
+    for (int block = 1, begin = blockSize + (remainder > 0 ? 1 : 0); block < blocks; ++block) {
+        const int end = begin + blockSize + (block < remainder ? 1 : 0);
+        auto runnable = new BlockRunnable(func, block, begin, end, done);
+
+        if (pool->tryStart(runnable)) {
+            ++started;
+        } else {
+            runnable->run();
+            delete runnable;
+            done.acquire();
+        }
+
+        begin = end;
+    }
+
+    func(0, 0, blockSize + (remainder > 0 ? 1 : 0));
+    done.acquire(started);
+}
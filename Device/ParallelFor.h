@@ -0,0 +1,29 @@
+#ifndef DEVICE_PARALLELFOR_H
+#define DEVICE_PARALLELFOR_H
+
+#include "DeviceGlobal.h"
+
+#include <functional>
+
+class DEVICELIB_EXPORT ParallelFor final
+{
+public:
+    typedef std::function<void(int block, int begin, int end)> BlockFunc;
+
+    /**
+     * Count of blocks [0, count) is split into. Each block
+     * has at least minBlockSize items except the last one
+     **/
+    static int blocksCount(int count, int minBlockSize);
+
+    /**
+     * Calls func for every block in global thread pool and waits
+     * for all of them. Caller thread runs blocks too, so it is safe
+     * to call from pool threads when pool is saturated
+     **/
+    static void run(int count, int minBlockSize, const BlockFunc &func);
+private:
+    ParallelFor() = delete;
+};
+
+#endif // DEVICE_PARALLELFOR_H
@@ -0,0 +1,63 @@
+#include "PixelConversion.h"
+
+#include "CpuFeatures.h"
+
+namespace {
+    typedef void (*ToFloatFunc)(const quint16 *src, float *dst, int count);
+
+    void toFloatScalar(const quint16 *src, float *dst, int count)
+    {
+        for (int i = 0; i < count; ++i) {
+            dst[i] = src[i];
+        }
+    }
+
+#if defined(DEVICE_SIMD_X86)
+    DEVICE_TARGET_SSE41
+    void toFloatSse41(const quint16 *src, float *dst, int count)
+    {
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(v)));
+            _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_srli_si128(v, 8))));
+        }
+
+        toFloatScalar(src + i, dst + i, count - i);
+    }
+
+    DEVICE_TARGET_AVX2
+    void toFloatAvx2(const quint16 *src, float *dst, int count)
+    {
+        int i = 0;
+        for (; i + 16 <= count; i += 16) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(v))));
+            _mm256_storeu_ps(dst + i + 8, _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(v, 1))));
+        }
+
+        toFloatScalar(src + i, dst + i, count - i);
+    }
+#endif
+
+    ToFloatFunc selectToFloat()
+    {
+#if defined(DEVICE_SIMD_X86)
+        if (CpuFeatures::hasAvx2()) {
+            return toFloatAvx2;
+        }
+
+        if (CpuFeatures::hasSse41()) {
+            return toFloatSse41;
+        }
+#endif
+
+        return toFloatScalar;
+    }
+}
+
+void PixelConversion::toFloat(const quint16 *src, float *dst, int count)
+{
+    static const ToFloatFunc convert = selectToFloat();
+    convert(src, dst, count);
+}
@@ -0,0 +1,18 @@
+#ifndef DEVICE_PIXELCONVERSION_H
+#define DEVICE_PIXELCONVERSION_H
+
+#include "DeviceGlobal.h"
+
+class DEVICELIB_EXPORT PixelConversion final
+{
+public:
+    /**
+     * Converts count unsigned 16-bit pixels to float.
+     * Ranges must not overlap
+     **/
+    static void toFloat(const quint16 *src, float *dst, int count);
+private:
+    PixelConversion() = delete;
+};
+
+#endif // DEVICE_PIXELCONVERSION_H
@@ -5,6 +5,8 @@
 #include <QElapsedTimer>
 #include <QThread>
 
+#include "Trace.h"
+
 struct PowerSupply::PImpl
 {
     bool isOn;
@@ -50,6 +52,7 @@ void PowerSupply::buttonsReleased()
 bool PowerSupply::prepare(const PowerSupply::Params &params)
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("PowerSupply::prepare", "power_supply");
 
     if (!checkIsOpen()) {
         return false;
@@ -86,6 +89,7 @@ bool PowerSupply::prepare(const PowerSupply::Params &params)
 bool PowerSupply::launch()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("PowerSupply::launch", "power_supply");
 
     if (!checkIsOpen()) {
         return false;
@@ -117,7 +121,11 @@ bool PowerSupply::launch()
 
     emit toggled(true, QPrivateSignal());
 
-    const bool errorOccured = doWaitForError();
+    bool errorOccured = false;
+    {
+        Trace::Span exposureSpan("PowerSupply::exposure", "power_supply");
+        errorOccured = doWaitForError();
+    }
 
     if (!doOff()) {
         return false;
@@ -133,6 +141,7 @@ bool PowerSupply::launch()
 bool PowerSupply::getResults()
 {
     Q_ASSERT(checkThreadAffinity());
+    Trace::Span span("PowerSupply::getResults", "power_supply");
 
     if (!checkIsOpen()) {
         return false;
@@ -1,9 +1,8 @@
 #include "ScaleAcquisitionResultProcessor.h"
 
-#include <opencv2/imgproc.hpp>
-
 ScaleAcquisitionResultProcessor::ScaleAcquisitionResultProcessor() :
-    m_width(0)
+    m_width(0),
+    m_filter(LineResampler::Cubic)
 {
 
 }
@@ -13,22 +12,28 @@ void ScaleAcquisitionResultProcessor::setWidth(int width)
     m_width = width;
 }
 
+void ScaleAcquisitionResultProcessor::setFilter(LineResampler::Filter filter)
+{
+    m_filter = filter;
+}
+
 void ScaleAcquisitionResultProcessor::process(Scanner::AcquisitionResult &result) const
 {
-    if (m_width < 1 || result.width < 1) {
+    if (m_width < 1 || result.width < 1 || m_width == result.width) {
         return;
     }
 
-    QVector<float> &srcImg = result.image;
-    int width = result.width;
-    int height = srcImg.size() / width;
+    const int width = result.width;
+    const int height = result.image.size() / width;
 
-    QVector<float> dstImg(height * m_width);
+    // Only width is changed, so lines are resampled
+    // independently without vertical pass
+    LineResampler resampler;
+    resampler.setGeometry(width, m_width, m_filter);
 
-    cv::Mat src(height, width, CV_32FC1, srcImg.data());
-    cv::Mat dst(height, m_width, CV_32FC1, dstImg.data());
-    cv::resize(src, dst, dst.size(), 0, 0, cv::INTER_CUBIC);
+    QVector<float> dstImg(height * m_width);
+    resampler.resample(result.image.constData(), height, dstImg.data());
 
     result.width = m_width;
-    result.image = dstImg;
+    result.image.swap(dstImg);
 }
@@ -1,6 +1,7 @@
 #ifndef DEVICE_SCALEACQUISITIONRESULTPROCESSOR_H
 #define DEVICE_SCALEACQUISITIONRESULTPROCESSOR_H
 
+#include "LineResampler.h"
 #include "ScannerAcquisitionResultProcessor.h"
 
 class DEVICELIB_EXPORT ScaleAcquisitionResultProcessor : public ScannerAcquisitionResultProcessor
@@ -9,10 +10,12 @@ public:
     ScaleAcquisitionResultProcessor();
 
     void setWidth(int width);
+    void setFilter(LineResampler::Filter filter);
     
     void process(Scanner::AcquisitionResult &result) const override;
 private:
     int m_width;
+    LineResampler::Filter m_filter;
 };
 
 #endif // DEVICE_SCALEACQUISITIONRESULTPROCESSOR_H
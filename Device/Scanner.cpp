@@ -1,15 +1,22 @@
 #include "Scanner.h"
 
+#include <QDateTime>
+#include <QDir>
 #include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QtMath>
 #include <QSettings>
 #include <QTimer>
 #include <QDataStream>
 
+#include <algorithm>
+
 #include <NpApplication/Application.h>
 #include <NpToolbox/Invoker.h>
 #include <Settings/LocalSettings.h>
 
+#include "DarkFrameCache.h"
 #include "Dispatcher.h"
 #include "Detector.h"
 #include "Hardware.h"
@@ -17,6 +24,9 @@
 #include "DeviceConfiguration.h"
 #include "DevicePluginManager.h"
 #include "ScannerCalibrationData.h"
+#include "ScannerAcquisitionResultPipeline.h"
+#include "StepGraph.h"
+#include "Trace.h"
 #include "DeviceLogging.h"
 
 using namespace Nauchpribor;
@@ -34,8 +44,22 @@ namespace {
     const uint OMRON_DELAY_MS = 500;
     const quint16 DARK_FRAME_HEIGHT_MM = 200;
     const quint16 CALIBRATION_HEIGHT_MM = 400;
+    const quint32 DETECTOR_STREAM_BLOCK_LINES = 64;
+    const int PREPARE_STEP_TIMEOUT_MS = 30000;
+    // Lets scintillator afterglow decay before dark frame refresh
+    const int DARK_FRAME_SETTLE_DELAY_MS = 300;
 
     const QString kCooldownTimeParam = QStringLiteral("main/cooldown");
+    const QString kAutoDispatcherTimingsParam = QStringLiteral("dispatcher/auto_timings");
+    const QString kDispatcherTimingsGroup = QStringLiteral("dispatcher_timings_%1");
+    const QString kTraceEnabledParam = QStringLiteral("trace/enabled");
+    const QString kTraceDirectoryParam = QStringLiteral("trace/directory");
+    // Binning, scaling, flips and rotation of scanning mode are applied
+    // by scanner only if enabled, consumers used to apply them themselves
+    const QString kGeometryProcessingParam = QStringLiteral("processing/geometry_enabled");
+    const QString kDarkCacheMaxAgeParam = QStringLiteral("dark_cache/max_age_ms");
+    const QString kDarkCacheMaxTemperatureDriftParam = QStringLiteral("dark_cache/max_temperature_drift");
+    const QString kCalibrationMaxResidentModesParam = QStringLiteral("calibration/max_resident_modes");
 
     quint32 calculateDetectorLines(quint16 heightMm, float pixelHeightMm)
     {
@@ -54,24 +78,61 @@ namespace {
     }
 }
 
+struct Scanner::StreamedCorrection
+{
+    QMutex mutex;
+    FlatFieldCorrection::RowsCorrection correction;
+    // Taken from detector frame pool, owned by scanner
+    QVector<float> image;
+    QVector<bool> correctedRows;
+    bool streamed = false;
+
+    void reset(Detector *detector)
+    {
+        if (detector && !image.isEmpty()) {
+            detector->framePool().recycle(std::move(image));
+        }
+
+        image = QVector<float>();
+        correctedRows.clear();
+        correction = FlatFieldCorrection::RowsCorrection();
+        streamed = false;
+    }
+};
+
 Scanner *Scanner::m_lastCreatedScanner = nullptr;
 
 Scanner::Scanner(QObject *parent) : QObject(parent),
     m_state(State::Unknown),
     m_isXrayOn(false),
+    m_currentImageOwned(false),
+    m_streamedCorrection(new StreamedCorrection),
     m_dispatcher(nullptr),
     m_detector(nullptr),
     m_powerSupply(nullptr),
     m_hardware(nullptr),
+    m_darkFrameCache(new DarkFrameCache),
     m_overheatTimer(new QTimer(this))
 {
     m_lastCreatedScanner = this;
 
+    // Thread names are shown in acquisition traces
+    m_dispatcherThread.setObjectName(QStringLiteral("Dispatcher"));
+    m_detectorThread.setObjectName(QStringLiteral("Detector"));
+    m_hardwareThread.setObjectName(QStringLiteral("Hardware"));
+    m_powerSupplyThread.setObjectName(QStringLiteral("PowerSupply"));
+
     m_run = new QSettings(npApp->permanentDataFilename(QStringLiteral("scanner.run")),
                                                        QSettings::IniFormat, this);
 
     m_cooldownDateTime = m_run->value(kCooldownTimeParam).toDateTime();
 
+    DarkFrameCache::Policy darkFramePolicy;
+    darkFramePolicy.maxAgeMs = m_run->value(kDarkCacheMaxAgeParam, darkFramePolicy.maxAgeMs).toLongLong();
+    darkFramePolicy.maxTemperatureDrift = m_run->value(kDarkCacheMaxTemperatureDriftParam,
+                                                       darkFramePolicy.maxTemperatureDrift).toReal();
+    m_darkFrameCache->setPolicy(darkFramePolicy);
+
     connect(m_overheatTimer, &QTimer::timeout, this, [this] {
         if (state() == State::Overheat) {
             setState(State::Idle);
@@ -115,8 +176,15 @@ bool Scanner::configureDetector()
     m_detectorThread.start(QThread::HighPriority);
 
     m_detector->setDispatcher(m_dispatcher);
+    m_detector->setStreamBlockLines(DETECTOR_STREAM_BLOCK_LINES);
     m_detector->moveToThread(&m_detectorThread);
     connect(&m_detectorThread, &QThread::finished, m_detector, &QObject::deleteLater);
+    connect(m_detector, &Detector::linesCaptured, this, [this](quint32 firstLine, Detector::Frame lines) {
+        if (m_state == State::Acquisition) {
+            emit acquisitionLinesCaptured(firstLine, lines, m_detector->properties().width);
+            correctStreamedLines(firstLine, lines);
+        }
+    }, Qt::DirectConnection);
 
     return true;
 }
@@ -142,7 +210,14 @@ bool Scanner::configurePowerSupply()
 
     m_powerSupply->setDispatcher(m_dispatcher);
     m_powerSupply->moveToThread(&m_powerSupplyThread);
-    connect(m_powerSupply, &PowerSupply::toggled, this, &Scanner::xrayToggled, Qt::DirectConnection);
+    connect(m_powerSupply, &PowerSupply::toggled, this, [this](bool value) {
+        m_isXrayOn = value;
+        emit xrayToggled(value);
+    }, Qt::DirectConnection);
+
+    if (m_detector) {
+        connect(m_powerSupply, &PowerSupply::toggled, m_detector, &Detector::setXrayOn, Qt::DirectConnection);
+    }
     connect(&m_powerSupplyThread, &QThread::finished, m_powerSupply, &QObject::deleteLater);    
 
     return true;
@@ -198,26 +273,51 @@ void Scanner::dismissHardware()
     m_hardware = nullptr;
 }
 
-bool Scanner::pingDevices()
+QVector<int> Scanner::addPingSteps(StepGraph &graph)
 {
-    QMap<Device *, Toolbox::Invoker::Outcome<bool>> outcomes;
+    QVector<int> steps;
 
     for (auto &device : devices()) {
         if (device) {
-            outcomes.insert(device, Toolbox::Invoker::run(device, &Device::testConnection));
+            steps.append(graph.addStep(QStringLiteral("ping %1").arg(device->metaObject()->className()),
+                                       [device] {
+                return Toolbox::Invoker::run(device, &Device::testConnection).result();
+            }, [this, device] {
+                return deviceLastError(device);
+            }, {}, PREPARE_STEP_TIMEOUT_MS));
         }
     }
 
-    bool success = true;
+    return steps;
+}
 
-    for (auto it = outcomes.cbegin(); it != outcomes.cend(); ++it) {
-        if (!it.value().result() && success) {
-            setLastError(deviceLastError(it.key()));
-            success = false;
-        }
+bool Scanner::captureDarkFrame(const QString &scanningMode, quint32 lines, QSharedPointer<PooledBuffer<float>> &frame)
+{
+    Toolbox::Invoker::run(m_detector, &Detector::refreshTemperature).waitForFinished();
+
+    frame = m_darkFrameCache->find(scanningMode, lines, m_detector->temperature());
+    if (frame) {
+        dbgDevice << "Using cached dark frame of" << scanningMode;
+        return true;
     }
 
-    return success;
+    Toolbox::Invoker::run(m_detector, &Detector::prepare, lines).waitForFinished();
+    if (!Toolbox::Invoker::run(m_detector, &Detector::capture).result()) {
+        return false;
+    }
+
+    frame = takePooledFrame();
+    m_darkFrameCache->store(scanningMode, lines, frame, m_detector->temperature());
+    return true;
+}
+
+QSharedPointer<PooledBuffer<float>> Scanner::takePooledFrame()
+{
+    bool owned = false;
+    const Detector::Frame frame = m_detector->takeLastCapturedFrame(&owned);
+
+    return QSharedPointer<PooledBuffer<float>>::create(frame, owned ? m_detector->framePoolReference()
+                                                                    : QWeakPointer<BufferPool<float>>());
 }
 
 void Scanner::setLastError(const QString &error)
@@ -265,6 +365,10 @@ bool Scanner::open()
         return false;
     }
 
+    auto &calibrationData = ScannerCalibrationData::instance();
+    calibrationData.setMaxResidentModes(m_run->value(kCalibrationMaxResidentModesParam,
+                                                     calibrationData.maxResidentModes()).toInt());
+
     emit opened();
     setState(State::Idle);
     return true;
@@ -273,6 +377,7 @@ bool Scanner::open()
 void Scanner::close()
 {
     closeDevices();
+    m_darkFrameCache->clear();
 
     dismissHardware();
     dismissPowerSupply();
@@ -287,7 +392,23 @@ void Scanner::close()
 
 bool Scanner::makeAcquisition(const AcquisitionParams &params)
 {
-    m_currentAcquisitionResult = AcquisitionResult();
+    const QSharedPointer<Trace> trace = startTrace(QStringLiteral("acquisition"));
+    const bool success = doMakeAcquisition(params);
+    finishTrace(trace);
+    return success;
+}
+
+bool Scanner::makeCalibration()
+{
+    const QSharedPointer<Trace> trace = startTrace(QStringLiteral("calibration"));
+    const bool success = doMakeCalibration();
+    finishTrace(trace);
+    return success;
+}
+
+bool Scanner::doMakeAcquisition(const AcquisitionParams &params)
+{
+    resetAcquisitionResult();
 
     auto &settings = LocalSettings::instance();
 
@@ -296,8 +417,11 @@ bool Scanner::makeAcquisition(const AcquisitionParams &params)
         return false;
     }
 
-    if (!switchDevicesConfigurations(params.scanningMode)) {
-        return false;
+    {
+        Trace::Span span("switchConfigurations", "scanner");
+        if (!switchDevicesConfigurations(params.scanningMode)) {
+            return false;
+        }
     }
 
     const quint8 doorsCount = settings.scannerDoorsCount();
@@ -317,93 +441,100 @@ bool Scanner::makeAcquisition(const AcquisitionParams &params)
     m_currentAcquisitionResult.pixelSize = detectorProperties.pixelSizeMm;
 
     qint64 rollbackTimeMs = 0;
+    QElapsedTimer xrayOffTimer;
 
     {
+        Trace::Span span("prepare", "scanner");
         setState(State::Prepare);
 
-        if (!pingDevices()) {
-            setState(State::Error);
-            return false;
-        }
+        StepGraph preparation;
 
-        if (!Toolbox::Invoker::run(m_hardware, &Hardware::refreshState).result()) {
-            setLastError(tr("Не удалось получить статус механики. %1").arg(m_hardware->lastError()));
-            setState(State::Error);
-            return false;
-        }
+        const auto pingSteps = addPingSteps(preparation);
 
-        if (m_hardware->rackState() == Hardware::RackStateTop) {
-            setLastError(tr("Механика находится в крайнем верхнем положении"));
-            setState(State::Error);
-            return false;
-        }
+        const int refreshStep = preparation.addStep(QStringLiteral("refreshState"), [this] {
+            return Toolbox::Invoker::run(m_hardware, &Hardware::refreshState).result();
+        }, [this] {
+            return tr("Не удалось получить статус механики. %1").arg(m_hardware->lastError());
+        }, {}, PREPARE_STEP_TIMEOUT_MS);
 
-        if (!Toolbox::Invoker::run(m_hardware, &Hardware::lockRemote).result()) {
-            setLastError(tr("Не удалось разблокировать пульт. %1").arg(m_hardware->lastError()));
-            setState(State::Error);
-            return false;
-        }
+        const int rackStep = preparation.addStep(QStringLiteral("checkRack"), [this] {
+            return m_hardware->rackState() != Hardware::RackStateTop;
+        }, [this] {
+            return tr("Механика находится в крайнем верхнем положении");
+        }, {refreshStep});
+
+        // Remote is locked only when all devices answer
+        const int lockStep = preparation.addStep(QStringLiteral("lockRemote"), [this] {
+            return Toolbox::Invoker::run(m_hardware, &Hardware::lockRemote).result();
+        }, [this] {
+            return tr("Не удалось разблокировать пульт. %1").arg(m_hardware->lastError());
+        }, QVector<int>(pingSteps) << rackStep, PREPARE_STEP_TIMEOUT_MS);
+
+        QVector<int> preparedSteps{lockStep};
 
-        Toolbox::Invoker::Outcome<bool> hardwareOutcome;
         if (params.useDoor && doorsCount >= 1) {
-            hardwareOutcome = Toolbox::Invoker::run(m_hardware, &Hardware::closeFirstDoor);
-        } else {
-            hardwareOutcome.setResult(true);
+            preparedSteps << preparation.addStep(QStringLiteral("closeFirstDoor"), [this] {
+                return Toolbox::Invoker::run(m_hardware, &Hardware::closeFirstDoor).result();
+            }, [this] {
+                return tr("Не удалось выполнить подготовку механики. %1").arg(m_hardware->lastError());
+            }, {lockStep}, PREPARE_STEP_TIMEOUT_MS);
         }
 
-        Toolbox::Invoker::Outcome<bool> powerSupplyOutcome;
-
         {
             PowerSupply::Params powerSupplyParams;
             powerSupplyParams.voltageKV = params.voltageKv;
             powerSupplyParams.amperageMA = params.amperageMa;
             powerSupplyParams.exposureMs = exposureTimeMs;
 
-            powerSupplyOutcome = Toolbox::Invoker::run(m_powerSupply, &PowerSupply::prepare, powerSupplyParams);
-        }
-
-        Toolbox::Invoker::run(m_detector, &Detector::prepare, darkLinesCount).waitForFinished();
-        auto detectorOutcome = Toolbox::Invoker::run(m_detector, &Detector::capture);
-
-        if (detectorOutcome.result()) {
-            detectorOutcome = Toolbox::Invoker::run(m_detector, &Detector::prepare, linesCount);
-        }
-
-        detectorOutcome.waitForFinished();
-        hardwareOutcome.waitForFinished();
-        powerSupplyOutcome.waitForFinished();
-
-        if (!detectorOutcome.result()) {
-            setLastError(tr("Не удалось выполнить подготовку детектора. %1").arg(m_detector->lastError()));
-            setState(State::Error);
-            return false;
-        }
-
-        if (!hardwareOutcome.result()) {
-            setLastError(tr("Не удалось выполнить подготовку механики. %1").arg(m_hardware->lastError()));
-            setState(State::Error);
-            return false;
-        }
-
-        if (!powerSupplyOutcome.result()) {
-            setLastError(tr("Не удалось выполнить подготовку РПУ. %1").arg(m_powerSupply->lastError()));
-            setState(State::Error);
-            return false;
+            // Generator is armed only after remote is locked
+            preparedSteps << preparation.addStep(QStringLiteral("preparePowerSupply"), [this, powerSupplyParams] {
+                return Toolbox::Invoker::run(m_powerSupply, &PowerSupply::prepare, powerSupplyParams).result();
+            }, [this] {
+                return tr("Не удалось выполнить подготовку РПУ. %1").arg(m_powerSupply->lastError());
+            }, {lockStep}, PREPARE_STEP_TIMEOUT_MS);
         }
 
-        if (!Toolbox::Invoker::run(m_hardware, &Hardware::pressPrepareButton).result()) {
-            setLastError(tr("Не удалось нажать кнопку подготовки. %1").arg(m_hardware->lastError()));
+        // Step has no timeout, so it is always waited for and may use locals
+        QSharedPointer<PooledBuffer<float>> dark;
+        const int darkStep = preparation.addStep(QStringLiteral("captureDark"), [this, &params, darkLinesCount, &dark] {
+            return captureDarkFrame(params.scanningMode.uuid(), darkLinesCount, dark);
+        }, [this] {
+            return tr("Не удалось выполнить подготовку детектора. %1").arg(m_detector->lastError());
+        }, pingSteps);
+
+        preparedSteps << preparation.addStep(QStringLiteral("prepareDetector"), [this, linesCount] {
+            return Toolbox::Invoker::run(m_detector, &Detector::prepare, linesCount).result();
+        }, [this] {
+            return tr("Не удалось выполнить подготовку детектора. %1").arg(m_detector->lastError());
+        }, {darkStep}, PREPARE_STEP_TIMEOUT_MS);
+
+        preparation.addStep(QStringLiteral("pressPrepareButton"), [this] {
+            return Toolbox::Invoker::run(m_hardware, &Hardware::pressPrepareButton).result();
+        }, [this] {
+            return tr("Не удалось нажать кнопку подготовки. %1").arg(m_hardware->lastError());
+        }, preparedSteps, PREPARE_STEP_TIMEOUT_MS);
+
+        if (!preparation.run()) {
+            setLastError(preparation.lastError());
             setState(State::Error);
             return false;
         }
 
-        m_currentAcquisitionResult.dark = m_detector->lastCapturedFrame();
+        m_currentAcquisitionResult.dark = dark->buffer();
+        m_currentAcquisitionResult.darkBuffer = dark;
     }
 
+    startStreamedCorrection(params.scanningMode.uuid(), linesCount);
+
     {
-        QThread::msleep(settings.scannerDelayBeforeScanMs());
+        {
+            Trace::Span span("delayBeforeScan", "scanner");
+            QThread::msleep(settings.scannerDelayBeforeScanMs());
+        }
 
+        Trace::Span span("acquisition", "scanner");
         bool fatalErrorOccurred = false;
+        bool flatFieldCorrected = false;
 
         QElapsedTimer movingTimer;
 
@@ -424,7 +555,8 @@ bool Scanner::makeAcquisition(const AcquisitionParams &params)
             setLastError(tr("Не удалось получить изображение с детектора. %1").arg(m_detector->lastError()));
             fatalErrorOccurred = true;
         } else {
-            m_currentAcquisitionResult.image = m_detector->lastCapturedFrame();
+            m_currentAcquisitionResult.image = m_detector->takeLastCapturedFrame(&m_currentImageOwned);
+            flatFieldCorrected = finishStreamedCorrection();
         }
 
         if (!Toolbox::Invoker::run(m_hardware, &Hardware::stopScan).result()) {
@@ -439,7 +571,10 @@ bool Scanner::makeAcquisition(const AcquisitionParams &params)
 
         rollbackTimeMs *= params.scanningMode.rollbackBeta;
 
-        if (!powerSupplyOutcome.result()) {
+        const bool powerSupplyLaunched = powerSupplyOutcome.result();
+        xrayOffTimer.start();
+
+        if (!powerSupplyLaunched) {
             setLastError(tr("Ошибка включения-выключения РПУ. %1").arg(m_powerSupply->lastError()));
             fatalErrorOccurred = true;
         }
@@ -462,7 +597,7 @@ bool Scanner::makeAcquisition(const AcquisitionParams &params)
                                     m_currentAcquisitionResult.exposureMs);
         }
 
-        processAcqusitionResult(params.scanningMode);
+        processAcqusitionResult(params.scanningMode, flatFieldCorrected);
 
         if (fatalErrorOccurred) {
             setState(State::Error);
@@ -471,10 +606,41 @@ bool Scanner::makeAcquisition(const AcquisitionParams &params)
     }
 
     {
+        Trace::Span span("finalization", "scanner");
         setState(State::Finalization);
 
+        // Dark frame of the next acquisition is captured
+        // while door opens and rack rolls back
+        const QString scanningMode = params.scanningMode.uuid();
+        const bool refreshDark = m_darkFrameCache->isEnabled();
+        Toolbox::Invoker::Outcome<bool> darkOutcome;
+
+        // Settle delay counts from X-ray off, so prepare is a part of it.
+        // Detector thread does both, door and rack start right away
+        if (refreshDark) {
+            const int settleMs = qMax(0, DARK_FRAME_SETTLE_DELAY_MS - static_cast<int>(xrayOffTimer.elapsed()));
+            darkOutcome = Toolbox::Invoker::run(m_detector, &Detector::prepareAndCapture, darkLinesCount, settleMs);
+        }
+
+        const auto finishDarkRefresh = [&] {
+            if (!refreshDark) {
+                return;
+            }
+
+            Trace::Span span("refreshDark", "scanner");
+            if (darkOutcome.result()) {
+                Toolbox::Invoker::run(m_detector, &Detector::refreshTemperature).waitForFinished();
+                m_darkFrameCache->store(scanningMode, darkLinesCount, takePooledFrame(),
+                                        m_detector->temperature());
+            } else {
+                warnDevice << "Failed to refresh dark frame" << m_detector->lastError();
+                m_darkFrameCache->remove(scanningMode);
+            }
+        };
+
         if (params.useDoor && doorsCount >= 1) {
             if (!Toolbox::Invoker::run(m_hardware, &Hardware::openFirstDoor).result()) {
+                finishDarkRefresh();
                 setLastError(tr("Не удалось открыть дверь"));
                 setState(State::Error);
                 return false;
@@ -485,10 +651,13 @@ bool Scanner::makeAcquisition(const AcquisitionParams &params)
 
         if (!Toolbox::Invoker::run(m_hardware, &Hardware::moveRackDown).result() ||
             !Toolbox::Invoker::runDelayed(rollbackTimeMs, m_hardware, &Hardware::moveRackStop).result()) {
+            finishDarkRefresh();
             setLastError(tr("Не удалось откатить механику"));
             setState(State::Error);
             return false;
         }
+
+        finishDarkRefresh();
     }
 
     if (!Toolbox::Invoker::run(m_hardware, &Hardware::unlockRemote).result()) {
@@ -501,7 +670,7 @@ bool Scanner::makeAcquisition(const AcquisitionParams &params)
     return true;
 }
 
-bool Scanner::makeCalibration()
+bool Scanner::doMakeCalibration()
 {
     auto &settings = LocalSettings::instance();
 
@@ -537,11 +706,14 @@ bool Scanner::makeCalibration()
     int currentScanningMode = 0;
 
     for (auto &scanningMode : scanningModes) {
-        m_currentAcquisitionResult = AcquisitionResult();
+        resetAcquisitionResult();
 
-        if (!switchDevicesConfigurations(scanningMode)) {
-            setState(State::Error);
-            return false;
+        {
+            Trace::Span span("switchConfigurations", "scanner");
+            if (!switchDevicesConfigurations(scanningMode)) {
+                setState(State::Error);
+                return false;
+            }
         }
 
         auto detectorProperties = m_detector->properties();
@@ -554,14 +726,18 @@ bool Scanner::makeCalibration()
         const auto exposureTimeMs = calculateExposureTime(linesCount, detectorProperties.chargeTimeMsec);
 
         {
-            if (!pingDevices()) {
-                setState(State::Error);
-                return false;
-            }
+            Trace::Span span("prepare", "scanner");
+            StepGraph preparation;
 
-            auto hardwareOutcome = Toolbox::Invoker::run(m_hardware, &Hardware::moveRackToBottom);
+            // Devices are used only when all of them answer
+            const auto pingSteps = addPingSteps(preparation);
+            QVector<int> preparedSteps = pingSteps;
 
-            Toolbox::Invoker::Outcome<bool> powerSupplyOutcome;
+            preparedSteps << preparation.addStep(QStringLiteral("moveRackToBottom"), [this] {
+                return Toolbox::Invoker::run(m_hardware, &Hardware::moveRackToBottom).result();
+            }, [this] {
+                return tr("Не удалось подготовить механику. %1").arg(m_hardware->lastError());
+            }, pingSteps);
 
             {
                 PowerSupply::Params powerSupplyParams;
@@ -569,48 +745,44 @@ bool Scanner::makeCalibration()
                 powerSupplyParams.amperageMA = scanningMode.calibrationAmperageMa;
                 powerSupplyParams.exposureMs = exposureTimeMs;
 
-                powerSupplyOutcome = Toolbox::Invoker::run(m_powerSupply, &PowerSupply::prepare, powerSupplyParams);
-            }
-
-            Toolbox::Invoker::run(m_detector, &Detector::prepare, darkLinesCount).waitForFinished();
-            auto detectorOutcome = Toolbox::Invoker::run(m_detector, &Detector::capture);
-
-            if (detectorOutcome.result()) {
-                detectorOutcome = Toolbox::Invoker::run(m_detector, &Detector::prepare, linesCount);
-            }
-
-            detectorOutcome.waitForFinished();
-            hardwareOutcome.waitForFinished();
-            powerSupplyOutcome.waitForFinished();
-
-            if (!detectorOutcome.result()) {
-                setLastError(tr("Не удалось подготовить детектор. %1").arg(m_detector->lastError()));
-                setState(State::Error);
-                return false;
-            }
-
-            if (!hardwareOutcome.result()) {
-                setLastError(tr("Не удалось подготовить механику. %1").arg(m_hardware->lastError()));
-                setState(State::Error);
-                return false;
+                preparedSteps << preparation.addStep(QStringLiteral("preparePowerSupply"), [this, powerSupplyParams] {
+                    return Toolbox::Invoker::run(m_powerSupply, &PowerSupply::prepare, powerSupplyParams).result();
+                }, [this] {
+                    return tr("Не удалось подготовить РПУ. %1").arg(m_powerSupply->lastError());
+                }, pingSteps, PREPARE_STEP_TIMEOUT_MS);
             }
 
-            if (!powerSupplyOutcome.result()) {
-                setLastError(tr("Не удалось подготовить РПУ. %1").arg(m_powerSupply->lastError()));
+            const int darkStep = preparation.addStep(QStringLiteral("captureDark"), [this, darkLinesCount] {
+                Toolbox::Invoker::run(m_detector, &Detector::prepare, darkLinesCount).waitForFinished();
+                return Toolbox::Invoker::run(m_detector, &Detector::capture).result();
+            }, [this] {
+                return tr("Не удалось подготовить детектор. %1").arg(m_detector->lastError());
+            }, pingSteps);
+
+            preparedSteps << preparation.addStep(QStringLiteral("prepareDetector"), [this, linesCount] {
+                return Toolbox::Invoker::run(m_detector, &Detector::prepare, linesCount).result();
+            }, [this] {
+                return tr("Не удалось подготовить детектор. %1").arg(m_detector->lastError());
+            }, {darkStep}, PREPARE_STEP_TIMEOUT_MS);
+
+            preparation.addStep(QStringLiteral("pressPrepareButton"), [this] {
+                return Toolbox::Invoker::run(m_hardware, &Hardware::pressPrepareButton).result();
+            }, [this] {
+                return tr("Не удалось нажать кнопку подготовки. %1").arg(m_hardware->lastError());
+            }, preparedSteps, PREPARE_STEP_TIMEOUT_MS);
+
+            if (!preparation.run()) {
+                setLastError(preparation.lastError());
                 setState(State::Error);
                 return false;
             }
 
-            if (!Toolbox::Invoker::run(m_hardware, &Hardware::pressPrepareButton).result()) {
-                setLastError(tr("Не удалось нажать кнопку подготовки. %1").arg(m_hardware->lastError()));
-                setState(State::Error);
-                return false;
-            }
-
-            m_currentAcquisitionResult.dark = m_detector->lastCapturedFrame();
+            m_currentAcquisitionResult.darkBuffer = takePooledFrame();
+            m_currentAcquisitionResult.dark = m_currentAcquisitionResult.darkBuffer->buffer();
         }
 
         {
+            Trace::Span span("acquisition", "scanner");
             bool fatalErrorOccurred = false;
 
             if (!Toolbox::Invoker::run(m_hardware, &Hardware::startScan, m_powerSupply).result()) {
@@ -626,7 +798,7 @@ bool Scanner::makeCalibration()
                 setLastError(tr("Не удалось получить изображение с детектора. %1").arg(m_detector->lastError()));
                 fatalErrorOccurred = true;
             } else {
-                m_currentAcquisitionResult.image = m_detector->lastCapturedFrame();
+                m_currentAcquisitionResult.image = m_detector->takeLastCapturedFrame(&m_currentImageOwned);
             }
 
             if (!Toolbox::Invoker::run(m_hardware, &Hardware::stopScan).result()) {
@@ -665,6 +837,7 @@ bool Scanner::makeCalibration()
             }
 
             {
+                Trace::Span span("updateCalibrationData", "scanner");
                 const int width = m_currentAcquisitionResult.width;
                 const QVector<float> &image = m_currentAcquisitionResult.image;
                 const QVector<float> &dark = m_currentAcquisitionResult.dark;
@@ -788,24 +961,152 @@ Scanner::State Scanner::state() const
     return m_state;
 }
 
-void Scanner::processAcqusitionResult(const ScanningModesCollection::Item &scanningMode)
+void Scanner::processAcqusitionResult(const ScanningModesCollection::Item &scanningMode,
+                                      bool flatFieldCorrected)
 {
+    Trace::Span span("processAcqusitionResult", "scanner");
     const int width = m_currentAcquisitionResult.width;
-    QVector<float> &imageFrame = m_currentAcquisitionResult.image;
-    const QVector<float> &darkFrame = m_currentAcquisitionResult.dark;
+    const QVector<float> &imageFrame = m_currentAcquisitionResult.image;
 
     if (imageFrame.isEmpty() || imageFrame.size() % width) {
         return;
     }
 
-    if (LocalSettings::instance().scannerFlatFieldCorrectionEnabled()) {
-        if (!ScannerCalibrationData::instance().apply(scanningMode.uuid(), imageFrame, darkFrame, width)) {
-            setLastError(tr("Возникла ошибка при выполнении нормировки"));
-        }
+    ScannerAcquisitionResultPipeline pipeline(scanningMode);
+    pipeline.setFlatFieldCorrection(LocalSettings::instance().scannerFlatFieldCorrectionEnabled() &&
+                                    !flatFieldCorrected);
+
+    if (!m_run->value(kGeometryProcessingParam, false).toBool()) {
+        pipeline.setBinning(0, 0, false);
+        pipeline.setWidth(0);
+        pipeline.setFlipHorizontal(false);
+        pipeline.setFlipVertical(false);
+        pipeline.setRotation(FrameGeometry::Rotate0);
+    }
+
+    if (m_detector) {
+        pipeline.setFramePool(&m_detector->framePool(), m_currentImageOwned);
+    }
+
+    const float *input = m_currentAcquisitionResult.image.constData();
+
+    if (!pipeline.apply(m_currentAcquisitionResult)) {
+        setLastError(tr("Возникла ошибка при выполнении нормировки"));
+    }
+
+    // Image replaced by pipeline is taken from pool and held only by scanner
+    if (m_currentAcquisitionResult.image.constData() != input) {
+        m_currentImageOwned = true;
+    }
+
+    // Published image goes back to pool when consumers release the result
+    if (m_detector && m_currentImageOwned) {
+        m_currentAcquisitionResult.imageBuffer = QSharedPointer<PooledBuffer<float>>::create(
+                    m_currentAcquisitionResult.image, m_detector->framePoolReference());
     }
 
     m_lastAcquisitionResult = m_currentAcquisitionResult;
-    emit acquisitionResultReady(m_lastAcquisitionResult);
+    m_currentImageOwned = false;
+    emit acquisitionResultReady(m_lastAcquisitionResult.load());
+}
+
+void Scanner::resetAcquisitionResult()
+{
+    // Published image and dark are recycled by their pooled buffers,
+    // so only image that was not published goes back to pool here
+    if (m_detector && m_currentImageOwned) {
+        m_detector->framePool().recycle(std::move(m_currentAcquisitionResult.image));
+    }
+
+    m_currentAcquisitionResult = AcquisitionResult();
+    m_currentImageOwned = false;
+
+    QMutexLocker locker(&m_streamedCorrection->mutex);
+    m_streamedCorrection->reset(m_detector);
+}
+
+void Scanner::startStreamedCorrection(const QString &scanningMode, quint32 lines)
+{
+    QMutexLocker locker(&m_streamedCorrection->mutex);
+    m_streamedCorrection->reset(m_detector);
+
+    const int width = m_currentAcquisitionResult.width;
+    if (!LocalSettings::instance().scannerFlatFieldCorrectionEnabled() ||
+        !m_detector->streamBlockLines() || width < 1 || !lines) {
+        return;
+    }
+
+    // Failure is reported by correction of whole frame after capture
+    if (!ScannerCalibrationData::instance().startRowsCorrection(scanningMode, m_currentAcquisitionResult.dark,
+                                                                width, m_streamedCorrection->correction)) {
+        return;
+    }
+
+    m_streamedCorrection->image = m_detector->framePool().acquire(width * static_cast<int>(lines));
+    m_streamedCorrection->correctedRows.fill(false, static_cast<int>(lines));
+}
+
+void Scanner::correctStreamedLines(quint32 firstLine, const QVector<float> &lines)
+{
+    QMutexLocker locker(&m_streamedCorrection->mutex);
+    auto &streamed = *m_streamedCorrection;
+
+    const int width = streamed.correction.width();
+    if (!streamed.correction.isStarted() || lines.isEmpty() || lines.size() % width) {
+        return;
+    }
+
+    const int first = static_cast<int>(firstLine);
+    const int count = lines.size() / width;
+    if (first + count > streamed.correctedRows.size()) {
+        return;
+    }
+
+    float *rows = streamed.image.data() + first * width;
+    std::copy(lines.cbegin(), lines.cend(), rows);
+    streamed.correction.correctRows(rows, count);
+
+    std::fill(streamed.correctedRows.begin() + first, streamed.correctedRows.begin() + first + count, true);
+    streamed.streamed = true;
+}
+
+bool Scanner::finishStreamedCorrection()
+{
+    Trace::Span span("finishStreamedCorrection", "scanner");
+    QMutexLocker locker(&m_streamedCorrection->mutex);
+    auto &streamed = *m_streamedCorrection;
+
+    QVector<float> &captured = m_currentAcquisitionResult.image;
+
+    // Frame of detector which didn't stream is corrected in place later
+    if (!streamed.streamed || captured.size() != streamed.image.size()) {
+        streamed.reset(m_detector);
+        return false;
+    }
+
+    const int width = streamed.correction.width();
+    const float *source = captured.constData();
+    float *target = streamed.image.data();
+
+    // Rows missed by streaming, such as frame tail, are corrected now
+    for (int row = 0; row < streamed.correctedRows.size(); ++row) {
+        if (!streamed.correctedRows.at(row)) {
+            std::copy(source + row * width, source + (row + 1) * width, target + row * width);
+            streamed.correction.correctRows(target + row * width, 1);
+        }
+    }
+
+    streamed.correction.finish(streamed.image);
+
+    // Captured frame is replaced by corrected one taken from pool
+    captured.swap(streamed.image);
+    if (!m_currentImageOwned) {
+        streamed.image = QVector<float>();
+    }
+
+    m_currentImageOwned = true;
+    streamed.reset(m_detector);
+    return true;
 }
 
 bool Scanner::openDevices()
@@ -818,6 +1119,8 @@ bool Scanner::openDevices()
 
     const auto &defaultScanningMode = availableScanningModes.first();
 
+    bool dispatcherOpened = false;
+
     if (!Toolbox::Invoker::run(m_dispatcher, &Dispatcher::isOpen).result()) {
         auto &settings = LocalSettings::instance();
 
@@ -832,6 +1135,8 @@ bool Scanner::openDevices()
             setLastError(tr("Ошибка диспетчера. %1").arg(m_dispatcher->lastError()));
             return false;
         }
+
+        dispatcherOpened = true;
     }
 
     if (!Toolbox::Invoker::run(m_dispatcher, &Dispatcher::reset).result()) {
@@ -857,9 +1162,55 @@ bool Scanner::openDevices()
         }
     }
 
+    // Accessors are created by devices on open, so timings are tuned after it
+    if (success && dispatcherOpened) {
+        tuneDispatcherTimings();
+    }
+
     return success;
 }
 
+void Scanner::tuneDispatcherTimings()
+{
+    if (!m_run->value(kAutoDispatcherTimingsParam, false).toBool()) {
+        return;
+    }
+
+    auto params = m_dispatcher->params();
+
+    QString port = params.portName;
+    port.replace(QLatin1Char('/'), QLatin1Char('_')).replace(QLatin1Char('\\'), QLatin1Char('_'));
+
+    m_run->beginGroup(kDispatcherTimingsGroup.arg(port));
+
+    if (m_run->value(QStringLiteral("baud_rate")).toUInt() == params.portBaudRate) {
+        params.writeDelayMs = static_cast<quint16>(m_run->value(QStringLiteral("write_delay_ms"), params.writeDelayMs).toUInt());
+        params.writePauseMs = static_cast<quint8>(m_run->value(QStringLiteral("write_pause_ms"), params.writePauseMs).toUInt());
+        params.frameIntervalMs = static_cast<quint8>(m_run->value(QStringLiteral("frame_interval_ms"), params.frameIntervalMs).toUInt());
+        params.modeSwitchDelayMs = static_cast<quint16>(m_run->value(QStringLiteral("mode_switch_delay_ms"), params.modeSwitchDelayMs).toUInt());
+        m_run->endGroup();
+
+        infoDevice << "Apply stored dispatcher timings for port" << params.portName;
+        Toolbox::Invoker::run(m_dispatcher, &Dispatcher::setTimings, params).waitForFinished();
+        return;
+    }
+
+    if (!m_dispatcher->calibrateTimings()) {
+        m_run->endGroup();
+        warnDevice << "Dispatcher timings calibration failed:" << m_dispatcher->lastError();
+        return;
+    }
+
+    params = m_dispatcher->params();
+    m_run->setValue(QStringLiteral("baud_rate"), params.portBaudRate);
+    m_run->setValue(QStringLiteral("write_delay_ms"), params.writeDelayMs);
+    m_run->setValue(QStringLiteral("write_pause_ms"), params.writePauseMs);
+    m_run->setValue(QStringLiteral("frame_interval_ms"), params.frameIntervalMs);
+    m_run->setValue(QStringLiteral("mode_switch_delay_ms"), params.modeSwitchDelayMs);
+    m_run->endGroup();
+    m_run->sync();
+}
+
 bool Scanner::resetDevices()
 {
     QMap<Device *, Toolbox::Invoker::Outcome<bool>> outcomes;
@@ -915,6 +1266,15 @@ bool Scanner::switchDevicesConfigurations(const ScanningModesCollection::Item &s
         return false;
     }
 
+    // Dark frames depend on detector configuration,
+    // which may be edited within the same scanning mode
+    const auto detectorConfiguration = scanningMode.devicesConfigurations.value(m_detector->name());
+    if (!m_darkFrameDetectorConfigurations.contains(scanningMode.uuid()) ||
+        !(m_darkFrameDetectorConfigurations.value(scanningMode.uuid()) == detectorConfiguration)) {
+        m_darkFrameCache->remove(scanningMode.uuid());
+        m_darkFrameDetectorConfigurations.insert(scanningMode.uuid(), detectorConfiguration);
+    }
+
     QMap<Device *, Toolbox::Invoker::Outcome<bool>> outcomes;
 
     for (auto &device : devices()) {
@@ -950,6 +1310,40 @@ void Scanner::accumulateReleasedPower(double kV, double mA, ushort exposureMs)
     m_run->setValue(kCooldownTimeParam, m_cooldownDateTime);
 }
 
+QSharedPointer<Trace> Scanner::startTrace(const QString &name)
+{
+    if (!m_run->value(kTraceEnabledParam, false).toBool()) {
+        return QSharedPointer<Trace>();
+    }
+
+    QSharedPointer<Trace> trace(new Trace(name));
+    Trace::setCurrent(trace);
+    return trace;
+}
+
+void Scanner::finishTrace(const QSharedPointer<Trace> &trace)
+{
+    if (!trace) {
+        return;
+    }
+
+    Trace::setCurrent(QSharedPointer<Trace>());
+
+    const QString directory = m_run->value(kTraceDirectoryParam,
+                                           npApp->permanentDataFilename(QStringLiteral("traces"))).toString();
+    if (!QDir().mkpath(directory)) {
+        warnDevice << "Failed to create trace directory" << directory;
+        return;
+    }
+
+    const QString filename = QDir(directory).filePath(QStringLiteral("%1-%2.json")
+                                                      .arg(trace->name(), QDateTime::currentDateTime()
+                                                           .toString(QStringLiteral("yyyyMMdd-hhmmss-zzz"))));
+    if (trace->save(filename)) {
+        infoDevice << "Trace saved to" << filename;
+    }
+}
+
 QVector<Device *> Scanner::devices() const
 {
     QVector<Device *> devices = {
@@ -6,6 +6,7 @@
 #include <QObject>
 #include <QMap>
 #include <QScopedPointer>
+#include <QSharedPointer>
 #include <QSizeF>
 #include <QVector>
 #include <QDateTime>
@@ -13,14 +14,18 @@
 
 #include <NpToolbox/Atomic.h>
 
+#include "BufferPool.h"
 #include "ScanningModesCollection.h"
 #include "CancelationToken.h"
 
+class DarkFrameCache;
 class Device;
 class Detector;
 class Hardware;
 class PowerSupply;
 class Dispatcher;
+class StepGraph;
+class Trace;
 class QSettings;
 class QTimer;
 
@@ -57,6 +62,10 @@ public:
         QVector<float> image;
         QVector<float> dark;
         QSizeF pixelSize;
+        // Return image and dark to detector frame pool once
+        // the last copy of result is released, not streamed
+        QSharedPointer<PooledBuffer<float>> imageBuffer;
+        QSharedPointer<PooledBuffer<float>> darkBuffer;
     };
 
     struct AcquisitionParams
@@ -101,6 +110,11 @@ signals:
 
     void xrayToggled(bool value);
     void acquisitionResultReady(Scanner::AcquisitionResult result);
+    /**
+     * Raw detector lines streamed while X-ray image is captured.
+     * Emitted from detector thread
+     **/
+    void acquisitionLinesCaptured(quint32 firstLine, QVector<float> lines, int width);
     void calibrationProgress(int current, int total);
 private:
     bool configureDispatcher();
@@ -114,16 +128,55 @@ private:
     void dismissHardware();
 
     bool openDevices();
+    /**
+     * Applies dispatcher timings stored for the port or calibrates
+     * them if auto timings are enabled in run settings
+     **/
+    void tuneDispatcherTimings();
     bool resetDevices();
     void closeDevices();
-    bool pingDevices();
+    QVector<int> addPingSteps(StepGraph &graph);
+    /**
+     * Takes fresh cached dark frame of scanning mode
+     * or captures new one and caches it
+     **/
+    bool captureDarkFrame(const QString &scanningMode, quint32 lines, QSharedPointer<PooledBuffer<float>> &frame);
+    /**
+     * Takes last captured frame held by pooled buffer, which
+     * returns it to frame pool only if scanner owned it
+     **/
+    QSharedPointer<PooledBuffer<float>> takePooledFrame();
 
     bool checkIsOpen();
     void setLastError(const QString &error);
     void setState(Scanner::State state);
-    void processAcqusitionResult(const ScanningModesCollection::Item &scanningMode);
+    /**
+     * Flat field correction is skipped if image is already corrected
+     **/
+    void processAcqusitionResult(const ScanningModesCollection::Item &scanningMode,
+                                 bool flatFieldCorrected = false);
+    void resetAcquisitionResult();
+
+    /**
+     * Lines streamed while X-ray image is captured are flat field
+     * corrected into pooled image as they come. Finish corrects rows
+     * which were not streamed, subtracts frame minimum and replaces
+     * captured image. It returns false if nothing was streamed
+     **/
+    void startStreamedCorrection(const QString &scanningMode, quint32 lines);
+    void correctStreamedLines(quint32 firstLine, const QVector<float> &lines);
+    bool finishStreamedCorrection();
 
     bool switchDevicesConfigurations(const ScanningModesCollection::Item &scanningMode);
+    bool doMakeAcquisition(const Scanner::AcquisitionParams &params);
+    bool doMakeCalibration();
+    /**
+     * Trace of one acquisition or calibration if tracing is
+     * enabled in run settings, saved as Chrome trace JSON.
+     * Spans still open on other threads keep it alive
+     **/
+    QSharedPointer<Trace> startTrace(const QString &name);
+    void finishTrace(const QSharedPointer<Trace> &trace);
     void accumulateReleasedPower(double kV, double mA, ushort exposureMs);
 
     static Scanner *m_lastCreatedScanner;
@@ -138,6 +191,13 @@ private:
     Nauchpribor::Toolbox::Atomic<QString> m_lastError;
     Nauchpribor::Toolbox::Atomic<AcquisitionResult> m_lastAcquisitionResult;
     AcquisitionResult m_currentAcquisitionResult;
+    // Image of current result is not held by anyone else and may be recycled
+    bool m_currentImageOwned;
+    struct StreamedCorrection;
+    QScopedPointer<StreamedCorrection> m_streamedCorrection;
+    QScopedPointer<DarkFrameCache> m_darkFrameCache;
+    // Detector configuration of cached dark frame by scanning mode
+    DeviceConfigurationMap m_darkFrameDetectorConfigurations;
 
     Dispatcher *m_dispatcher;
     Detector *m_detector;
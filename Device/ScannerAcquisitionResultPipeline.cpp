@@ -0,0 +1,213 @@
+#include "ScannerAcquisitionResultPipeline.h"
+
+#include "Binning.h"
+#include "FrameGeometry.h"
+#include "ParallelFor.h"
+#include "ScannerCalibrationData.h"
+
+namespace {
+    // 32 output lines of 4608 px detector take 576 KB
+    // and still stay in L2 cache with the source lines
+    const int kDefaultTileHeight = 32;
+}
+
+ScannerAcquisitionResultPipeline::ScannerAcquisitionResultPipeline() :
+    m_flatFieldCorrection(false),
+    m_flipHorizontal(false),
+    m_flipVertical(false),
+    m_rotation(FrameGeometry::Rotate0),
+    m_binningX(0),
+    m_binningY(0),
+    m_binningSum(false),
+    m_width(0),
+    m_scalingFilter(LineResampler::Cubic),
+    m_tileHeight(kDefaultTileHeight),
+    m_framePool(nullptr),
+    m_recycleInput(false)
+{
+
+}
+
+ScannerAcquisitionResultPipeline::ScannerAcquisitionResultPipeline(const ScanningModesCollection::Item &scanningMode) :
+    ScannerAcquisitionResultPipeline()
+{
+    m_scanningModeUuid = scanningMode.uuid();
+    m_flipHorizontal = scanningMode.flipHorizontal;
+    m_flipVertical = scanningMode.flipVertical;
+    m_rotation = scanningMode.rotation;
+    m_binningX = scanningMode.binningHorizontal;
+    m_binningY = scanningMode.binningVertical;
+    m_binningSum = scanningMode.binningSum;
+    m_width = scanningMode.snapshotWidth;
+    m_scalingFilter = scanningMode.snapshotFilter;
+}
+
+void ScannerAcquisitionResultPipeline::setFlatFieldCorrection(bool enabled)
+{
+    m_flatFieldCorrection = enabled;
+}
+
+void ScannerAcquisitionResultPipeline::setFlipHorizontal(bool flip)
+{
+    m_flipHorizontal = flip;
+}
+
+void ScannerAcquisitionResultPipeline::setFlipVertical(bool flip)
+{
+    m_flipVertical = flip;
+}
+
+void ScannerAcquisitionResultPipeline::setRotation(FrameGeometry::Rotation rotation)
+{
+    m_rotation = rotation;
+}
+
+void ScannerAcquisitionResultPipeline::setBinning(int x, int y, bool sum)
+{
+    m_binningX = qMax(0, x);
+    m_binningY = qMax(0, y);
+    m_binningSum = sum;
+}
+
+void ScannerAcquisitionResultPipeline::setWidth(int width)
+{
+    m_width = width;
+}
+
+void ScannerAcquisitionResultPipeline::setScalingFilter(LineResampler::Filter filter)
+{
+    m_scalingFilter = filter;
+}
+
+void ScannerAcquisitionResultPipeline::setTileHeight(int lines)
+{
+    m_tileHeight = qMax(1, lines);
+}
+
+void ScannerAcquisitionResultPipeline::setFramePool(BufferPool<float> *pool, bool recycleInput)
+{
+    m_framePool = pool;
+    m_recycleInput = recycleInput;
+}
+
+void ScannerAcquisitionResultPipeline::process(Scanner::AcquisitionResult &result) const
+{
+    apply(result);
+}
+
+bool ScannerAcquisitionResultPipeline::apply(Scanner::AcquisitionResult &result) const
+{
+    if (result.width < 1 || result.image.isEmpty() || result.image.size() % result.width) {
+        return true;
+    }
+
+    bool success = true;
+
+    if (m_flatFieldCorrection) {
+        success = ScannerCalibrationData::instance().apply(m_scanningModeUuid, result.image,
+                                                           result.dark, result.width);
+    }
+
+    const int width = result.width;
+    const int height = result.image.size() / width;
+    const int binX = m_binningX + 1;
+    const int binY = m_binningY + 1;
+    const bool binning = binX > 1 || binY > 1;
+    const int binnedWidth = (width + binX - 1) / binX;
+    const int binnedHeight = (height + binY - 1) / binY;
+    const bool scaling = m_width > 0 && m_width != binnedWidth;
+
+    if (!binning && !scaling) {
+        transform(result, m_flipHorizontal, m_recycleInput);
+        return success;
+    }
+
+    const int outputWidth = scaling ? m_width : binnedWidth;
+    const bool passThrough = !binning && !m_flipHorizontal;
+    const float *src = result.image.constData();
+
+    QVector<float> output = m_framePool ? m_framePool->acquire(binnedHeight * outputWidth)
+                                        : QVector<float>(binnedHeight * outputWidth);
+    float *out = output.data();
+
+    LineResampler resampler;
+    if (scaling) {
+        resampler.setGeometry(binnedWidth, outputWidth, m_scalingFilter);
+    }
+
+    // Tiles are independent, so threads take runs of them with own tile buffer
+    const int tiles = (binnedHeight + m_tileHeight - 1) / m_tileHeight;
+    ParallelFor::run(tiles, 1, [&](int, int begin, int end) {
+        QVector<float> tile;
+        if (scaling && !passThrough) {
+            tile.resize(m_tileHeight * binnedWidth);
+        }
+
+        for (int row = begin * m_tileHeight; row < qMin(end * m_tileHeight, binnedHeight); row += m_tileHeight) {
+            const int rows = qMin(m_tileHeight, binnedHeight - row);
+
+            const float *binned = nullptr;
+            if (passThrough) {
+                binned = src + row * width;
+            } else {
+                float *dst = scaling ? tile.data() : out + row * binnedWidth;
+                Binning::binRows(src, width, height, binX, binY, m_binningSum, m_flipHorizontal, row, rows, dst);
+                binned = dst;
+            }
+
+            if (scaling) {
+                // Rows count is not changed so filter works
+                // only along the line and tiles are independent
+                resampler.resampleRows(binned, rows, out + row * outputWidth);
+            }
+        }
+    });
+
+    result.image.swap(output);
+    result.width = outputWidth;
+
+    // Input not owned by caller may still be held by
+    // receivers of captured frame, so it is just dropped
+    if (m_framePool && m_recycleInput) {
+        m_framePool->recycle(std::move(output));
+    }
+
+    result.pixelSize.setWidth(result.pixelSize.width() * binX);
+    result.pixelSize.setHeight(result.pixelSize.height() * binY);
+
+    // Horizontal flip is already done by binning pass,
+    // its output is taken from pool and owned here
+    transform(result, false, true);
+
+    return success;
+}
+
+void ScannerAcquisitionResultPipeline::transform(Scanner::AcquisitionResult &result, bool flipHorizontal,
+                                                 bool inputOwned) const
+{
+    if (!flipHorizontal && !m_flipVertical && m_rotation == FrameGeometry::Rotate0) {
+        return;
+    }
+
+    const int width = result.width;
+    const int height = result.image.size() / width;
+
+    if (!FrameGeometry::swapsSides(m_rotation)) {
+        float *img = result.image.data();
+        FrameGeometry::transform(img, width, height, flipHorizontal, m_flipVertical, m_rotation, img);
+        return;
+    }
+
+    QVector<float> rotated = m_framePool ? m_framePool->acquire(width * height)
+                                         : QVector<float>(width * height);
+    FrameGeometry::transform(result.image.constData(), width, height, flipHorizontal, m_flipVertical,
+                             m_rotation, rotated.data());
+
+    result.image.swap(rotated);
+    result.width = height;
+    result.pixelSize.transpose();
+
+    if (m_framePool && inputOwned) {
+        m_framePool->recycle(std::move(rotated));
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef DEVICE_SCANNERACQUISITIONRESULTPIPELINE_H
+#define DEVICE_SCANNERACQUISITIONRESULTPIPELINE_H
+
+#include "BufferPool.h"
+#include "FrameGeometry.h"
+#include "LineResampler.h"
+#include "ScannerAcquisitionResultProcessor.h"
+
+/**
+ * Post-processing of acquisition result configured by scanning mode.
+ * Flat field correction is done in place, then flip, binning and
+ * scaling are fused into one row-tiled pass writing into the single
+ * output buffer. Vertical flip and rotation are applied to that output
+ **/
+class DEVICELIB_EXPORT ScannerAcquisitionResultPipeline : public ScannerAcquisitionResultProcessor
+{
+public:
+    ScannerAcquisitionResultPipeline();
+    explicit ScannerAcquisitionResultPipeline(const ScanningModesCollection::Item &scanningMode);
+
+    void setFlatFieldCorrection(bool enabled);
+    void setFlipHorizontal(bool flip);
+    void setFlipVertical(bool flip);
+    void setRotation(FrameGeometry::Rotation rotation);
+    void setBinning(int x, int y, bool sum);
+    void setWidth(int width);
+    void setScalingFilter(LineResampler::Filter filter);
+    void setTileHeight(int lines);
+    /**
+     * Output frame is taken from pool. Replaced input frame
+     * is returned to it only if recycleInput is set, i.e. caller
+     * owns input and nobody else holds it
+     **/
+    void setFramePool(BufferPool<float> *pool, bool recycleInput = false);
+
+    /**
+     * Returns false if flat field correction failed. Other
+     * stages are applied in any case
+     **/
+    bool apply(Scanner::AcquisitionResult &result) const;
+
+    void process(Scanner::AcquisitionResult &result) const override;
+private:
+    void transform(Scanner::AcquisitionResult &result, bool flipHorizontal, bool inputOwned) const;
+
+    QString m_scanningModeUuid;
+    bool m_flatFieldCorrection;
+    bool m_flipHorizontal;
+    bool m_flipVertical;
+    FrameGeometry::Rotation m_rotation;
+    int m_binningX;
+    int m_binningY;
+    bool m_binningSum;
+    int m_width;
+    LineResampler::Filter m_scalingFilter;
+    int m_tileHeight;
+    BufferPool<float> *m_framePool;
+    bool m_recycleInput;
+};
+
+#endif // DEVICE_SCANNERACQUISITIONRESULTPIPELINE_H
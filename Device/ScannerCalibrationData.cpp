@@ -5,10 +5,12 @@
 
 #include "ScanningModesCollection.h"
 #include "FlatFieldCorrection.h"
+#include "DeviceLogging.h"
 
 using namespace Nauchpribor;
 
 const float kRecommendedRatio = 0.9f;
+const int kDefaultMaxResidentModes = 4;
 
 ScannerCalibrationData::~ScannerCalibrationData()
 {
@@ -37,6 +39,8 @@ bool ScannerCalibrationData::updateIsRequired() const
 
 bool ScannerCalibrationData::isExpired(int sec) const
 {
+    QMutexLocker locker(&m_mutex);
+
     if (m_ffc.isEmpty()) {
         return false;
     }
@@ -44,6 +48,7 @@ bool ScannerCalibrationData::isExpired(int sec) const
     QDateTime lastCalibration;
     
     for (const auto &ffc : qAsConst(m_ffc)) {
+        ffc->loadLastCalibrationDateTime();
         QDateTime calibration = ffc->lastCalibrationDateTime();
         if (!calibration.isValid()) {
             lastCalibration = QDateTime();
@@ -55,6 +60,9 @@ bool ScannerCalibrationData::isExpired(int sec) const
         }
     }
 
+    // Legacy gains files are loaded completely to get calibration date
+    evict();
+
     return !lastCalibration.isValid() ||
             (sec > 0 && lastCalibration.addSecs(sec) < QDateTime::currentDateTime());
 }
@@ -65,8 +73,19 @@ bool ScannerCalibrationData::update(const QString &scanningModeUuid, const Image
     const int pos = width * qRound(height * 0.25);
     const int len = width * qRound(height * 0.5);
 
-    FlatFieldCorrection *ffc = m_ffc.value(scanningModeUuid);
-    return ffc && ffc->calibrate(image.mid(pos, len), dark, width);
+    // Gains are computed without lock, so calibration
+    // doesn't block isExpired() calls of other threads
+    QVector<float> gains;
+    if (!m_ffc.contains(scanningModeUuid) ||
+        !FlatFieldCorrection::computeGains(image.mid(pos, len), dark, width, gains)) {
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+
+    const bool saved = m_ffc.value(scanningModeUuid)->setCalibration(gains);
+    touch(scanningModeUuid);
+    return saved;
 }
 
 bool ScannerCalibrationData::apply(const QString &scanningModeUuid, Image &image, const Image &dark, int width)
@@ -75,16 +94,97 @@ bool ScannerCalibrationData::apply(const QString &scanningModeUuid, Image &image
         return false;
     }
 
-    FlatFieldCorrection *ffc = m_ffc.value(scanningModeUuid);
-    return ffc && ffc->correct(image, dark, width);
+    QVector<float> reciprocalGains;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        FlatFieldCorrection *ffc = m_ffc.value(scanningModeUuid);
+        if (!ffc || !ffc->load()) {
+            return false;
+        }
+
+        touch(scanningModeUuid);
+        reciprocalGains = ffc->reciprocalGains();
+    }
+
+    // Copy of gains stays valid if mode is evicted meanwhile
+    return FlatFieldCorrection::correct(image, dark, width, reciprocalGains);
+}
+
+bool ScannerCalibrationData::startRowsCorrection(const QString &scanningModeUuid, const Image &dark, int width,
+                                                 FlatFieldCorrection::RowsCorrection &correction)
+{
+    QVector<float> reciprocalGains;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        FlatFieldCorrection *ffc = m_ffc.value(scanningModeUuid);
+        if (!ffc || !ffc->load()) {
+            return false;
+        }
+
+        touch(scanningModeUuid);
+        reciprocalGains = ffc->reciprocalGains();
+    }
+
+    return correction.start(dark, width, reciprocalGains);
+}
+
+void ScannerCalibrationData::setMaxResidentModes(int count)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_maxResidentModes = qMax(1, count);
+    evict();
+}
+
+int ScannerCalibrationData::maxResidentModes() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_maxResidentModes;
+}
+
+void ScannerCalibrationData::touch(const QString &scanningModeUuid) const
+{
+    m_residentModes.removeOne(scanningModeUuid);
+    m_residentModes.prepend(scanningModeUuid);
+    evict();
+}
+
+void ScannerCalibrationData::evict() const
+{
+    for (auto it = m_ffc.cbegin(); it != m_ffc.cend(); ++it) {
+        if (it.value()->isLoaded() && !m_residentModes.contains(it.key())) {
+            m_residentModes.append(it.key());
+        }
+    }
+
+    for (int i = m_residentModes.size() - 1; i >= 0 && m_residentModes.size() > m_maxResidentModes; --i) {
+        FlatFieldCorrection *ffc = m_ffc.value(m_residentModes.at(i));
+
+        // Gains failed to save would be replaced by stale file on load
+        if (ffc && ffc->hasUnsavedGains()) {
+            continue;
+        }
+
+        const QString uuid = m_residentModes.takeAt(i);
+        if (ffc) {
+            infoDevice << "Unloading gains of scanning mode" << uuid;
+            ffc->unload();
+        }
+    }
 }
 
-ScannerCalibrationData::ScannerCalibrationData()
+ScannerCalibrationData::ScannerCalibrationData() :
+    m_maxResidentModes(kDefaultMaxResidentModes)
 {
     const ScanningModesCollection::ItemsList modes = ScanningModesCollection::instance().list();
     for (const auto &mode : modes) {
         const QString uuid = mode.uuid();
         QString filename = npApp->permanentDataFilename(QStringLiteral("%1.gains").arg(uuid));
-        m_ffc.insert(uuid, new FlatFieldCorrection(filename));
+        m_ffc.insert(uuid, new FlatFieldCorrection(filename, uuid));
     }
 }
@@ -2,12 +2,13 @@
 #define DEVICE_SCANNERCALIBRATIONDATA_H
 
 #include "DeviceGlobal.h"
+#include "FlatFieldCorrection.h"
 
 #include <QMap>
+#include <QMutex>
+#include <QStringList>
 #include <QVector>
 
-class FlatFieldCorrection;
-
 class DEVICELIB_EXPORT ScannerCalibrationData final
 {
 public:
@@ -25,11 +26,32 @@ public:
 
     bool apply(const QString &scanningModeUuid, Image &image,
                const Image &dark, int width);
+    /**
+     * Starts correction of image rows arriving while it is captured
+     **/
+    bool startRowsCorrection(const QString &scanningModeUuid, const Image &dark, int width,
+                             FlatFieldCorrection::RowsCorrection &correction);
+
+    /**
+     * Gains of scanning modes are loaded on first use. Only
+     * this count of recently used modes stays in memory,
+     * besides modes whose gains failed to save
+     **/
+    void setMaxResidentModes(int count);
+    int maxResidentModes() const;
 private:
     ScannerCalibrationData();
     bool isExpired(int sec) const;
+    /**
+     * Marks loaded gains of scanning mode as recently used
+     **/
+    void touch(const QString &scanningModeUuid) const;
+    void evict() const;
 
     QMap<QString, FlatFieldCorrection *> m_ffc;
+    mutable QMutex m_mutex;
+    mutable QStringList m_residentModes;
+    int m_maxResidentModes;
 };
 
 #endif // DEVICE_SCANNERCALIBRATIONDATA_H
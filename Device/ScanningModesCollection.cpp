@@ -37,11 +37,35 @@ namespace {
     const QString kMinVoltageKvParam = QStringLiteral("main/min_voltage_kv");
     const QString kMaxVoltageKvParam = QStringLiteral("main/max_voltage_kv");
     const QString kSnapshotWidthParam = QStringLiteral("main/snapshot_width_px");
+    const QString kSnapshotFilterParam = QStringLiteral("main/snapshot_filter");
+    const QString kFlipHorizontalParam = QStringLiteral("main/flip_horizontal");
+    const QString kFlipVerticalParam = QStringLiteral("main/flip_vertical");
+    const QString kRotationParam = QStringLiteral("main/rotation");
     const QString kRollbackAlphaParam = QStringLiteral("main/rollback_alpha");
     const QString kRollbackBetaParam = QStringLiteral("main/rollback_beta");
     const QString kBinningSumParam = QStringLiteral("binning/sum");
     const QString kBinningHorizontalParam = QStringLiteral("binning/horizontal");
     const QString kBinningVerticalParam = QStringLiteral("binning/vertical");
+    const QString kCubicFilterName = QStringLiteral("cubic");
+    const QString kLanczos3FilterName = QStringLiteral("lanczos3");
+
+    QString filterName(LineResampler::Filter filter)
+    {
+        return filter == LineResampler::Lanczos3 ? kLanczos3FilterName : kCubicFilterName;
+    }
+
+    LineResampler::Filter filterFromName(const QString &name, LineResampler::Filter defaultFilter)
+    {
+        if (name == kCubicFilterName) {
+            return LineResampler::Cubic;
+        }
+
+        if (name == kLanczos3FilterName) {
+            return LineResampler::Lanczos3;
+        }
+
+        return defaultFilter;
+    }
 }
 
 static const int qmtScanningModesCollectionItem = qRegisterMetaType<ScanningModesCollection::Item>();
@@ -145,6 +169,10 @@ bool ScanningModesCollection::store(const ScanningModesCollection::ItemsList &li
             config.setValue(kBinningHorizontalParam, item.binningHorizontal);
             config.setValue(kBinningVerticalParam, item.binningVertical);
             config.setValue(kSnapshotWidthParam, item.snapshotWidth);
+            config.setValue(kSnapshotFilterParam, filterName(item.snapshotFilter));
+            config.setValue(kFlipHorizontalParam, item.flipHorizontal);
+            config.setValue(kFlipVerticalParam, item.flipVertical);
+            config.setValue(kRotationParam, static_cast<int>(item.rotation));
             config.setValue(kRollbackAlphaParam, item.rollbackAlpha);
             config.setValue(kRollbackBetaParam, item.rollbackBeta);
 
@@ -237,6 +265,10 @@ void ScanningModesCollection::load()
             scanningMode.binningHorizontal = config.value(kBinningHorizontalParam, scanningMode.binningHorizontal).value<quint16>();
             scanningMode.binningVertical = config.value(kBinningVerticalParam, scanningMode.binningVertical).value<quint16>();
             scanningMode.snapshotWidth = config.value(kSnapshotWidthParam, scanningMode.snapshotWidth).value<quint16>();
+            scanningMode.snapshotFilter = filterFromName(config.value(kSnapshotFilterParam).toString(), scanningMode.snapshotFilter);
+            scanningMode.flipHorizontal = config.value(kFlipHorizontalParam, scanningMode.flipHorizontal).toBool();
+            scanningMode.flipVertical = config.value(kFlipVerticalParam, scanningMode.flipVertical).toBool();
+            scanningMode.rotation = FrameGeometry::rotationFromDegrees(config.value(kRotationParam, static_cast<int>(scanningMode.rotation)).toInt());
             scanningMode.rollbackAlpha = config.value(kRollbackAlphaParam, scanningMode.rollbackAlpha).value<quint16>();
             scanningMode.rollbackBeta = config.value(kRollbackBetaParam, scanningMode.rollbackBeta).toReal();
         }
@@ -275,6 +307,10 @@ ScanningModesCollection::Item::Item() :
     binningHorizontal(0),
     binningVertical(0),
     snapshotWidth(0),
+    snapshotFilter(LineResampler::Cubic),
+    flipHorizontal(false),
+    flipVertical(false),
+    rotation(FrameGeometry::Rotate0),
     rollbackAlpha(0),
     rollbackBeta(1)
 {
@@ -309,6 +345,10 @@ bool ScanningModesCollection::Item::operator==(const ScanningModesCollection::It
            binningHorizontal == other.binningHorizontal &&
            binningVertical == other.binningVertical &&
            snapshotWidth == other.snapshotWidth &&
+           snapshotFilter == other.snapshotFilter &&
+           flipHorizontal == other.flipHorizontal &&
+           flipVertical == other.flipVertical &&
+           rotation == other.rotation &&
            rollbackAlpha == other.rollbackAlpha &&
            qFuzzyCompare(rollbackBeta, rollbackBeta) &&
            devicesConfigurations == other.devicesConfigurations;
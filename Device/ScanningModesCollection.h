@@ -7,6 +7,8 @@
 #include <QMap>
 
 #include "DeviceConfiguration.h"
+#include "FrameGeometry.h"
+#include "LineResampler.h"
 
 class DEVICELIB_EXPORT ScanningModesCollection final
 {
@@ -30,6 +32,10 @@ public:
         quint16 binningHorizontal;
         quint16 binningVertical;
         quint16 snapshotWidth;
+        LineResampler::Filter snapshotFilter;
+        bool flipHorizontal;
+        bool flipVertical;
+        FrameGeometry::Rotation rotation;
         quint16 rollbackAlpha;
         qreal rollbackBeta;
         DeviceConfigurationMap devicesConfigurations;
@@ -0,0 +1,265 @@
+#include "StepGraph.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "DeviceLogging.h"
+#include "Trace.h"
+
+namespace {
+    enum StepState {
+        StepPending,
+        StepRunning,
+        StepSucceeded,
+        StepFailed,
+        StepTimedOut,
+        StepSkipped
+    };
+
+    // Steps abandoned after deadline keep their threads until device
+    // calls return, so they don't run in pool of run() waiting for them
+    Q_GLOBAL_STATIC(QThreadPool, stepPool)
+}
+
+struct StepGraph::PImpl
+{
+    struct Step
+    {
+        QString name;
+        Action action;
+        ErrorFunc error;
+        QVector<int> dependencies;
+        int timeoutMs;
+        QElapsedTimer timer;
+    };
+
+    /**
+     * States are shared with runnables, so step finishing
+     * after run() has given up on it touches only them
+     **/
+    struct States
+    {
+        QMutex mutex;
+        QWaitCondition stepFinished;
+        QVector<StepState> states;
+    };
+
+    class StepRunnable : public QRunnable
+    {
+    public:
+        StepRunnable(const QSharedPointer<States> &states, int step, const QString &name, const Action &action) :
+            m_states(states),
+            m_step(step),
+            m_name(name),
+            m_action(action)
+        {
+
+        }
+
+        void run() override
+        {
+            QElapsedTimer timer;
+            timer.start();
+
+            bool success = false;
+            {
+                Trace::Span span(m_name, "prepare");
+                success = m_action();
+            }
+
+            dbgDevice << "Step" << m_name << (success ? "succeeded" : "failed")
+                      << "in" << timer.elapsed() << "ms";
+
+            QMutexLocker locker(&m_states->mutex);
+            StepState &state = m_states->states[m_step];
+            if (state == StepRunning) {
+                state = success ? StepSucceeded : StepFailed;
+            }
+            m_states->stepFinished.wakeAll();
+        }
+    private:
+        const QSharedPointer<States> m_states;
+        const int m_step;
+        const QString m_name;
+        const Action m_action;
+    };
+
+    QVector<Step> steps;
+    QSharedPointer<States> states;
+    QString lastError;
+
+    bool startReadySteps();
+    qint64 checkTimeouts();
+};
+
+bool StepGraph::PImpl::startReadySteps()
+{
+    bool hasRunning = false;
+
+    for (int i = 0; i < steps.size(); ++i) {
+        StepState &state = states->states[i];
+        if (state == StepRunning) {
+            hasRunning = true;
+            continue;
+        }
+
+        if (state != StepPending) {
+            continue;
+        }
+
+        Step &step = steps[i];
+
+        bool ready = true;
+        for (int dependency : qAsConst(step.dependencies)) {
+            if (states->states.at(dependency) != StepSucceeded) {
+                ready = false;
+                break;
+            }
+        }
+
+        if (ready) {
+            state = StepRunning;
+            step.timer.start();
+            stepPool()->start(new StepRunnable(states, i, step.name, step.action));
+            hasRunning = true;
+        }
+    }
+
+    return hasRunning;
+}
+
+qint64 StepGraph::PImpl::checkTimeouts()
+{
+    qint64 nearest = -1;
+
+    for (int i = 0; i < steps.size(); ++i) {
+        const Step &step = steps.at(i);
+        StepState &state = states->states[i];
+        if (state != StepRunning || step.timeoutMs <= 0) {
+            continue;
+        }
+
+        const qint64 remains = step.timeoutMs - step.timer.elapsed();
+        if (remains <= 0) {
+            warnDevice << "Step" << step.name << "timed out after" << step.timeoutMs << "ms";
+            state = StepTimedOut;
+        } else if (nearest < 0 || remains < nearest) {
+            nearest = remains;
+        }
+    }
+
+    return nearest;
+}
+
+StepGraph::StepGraph() :
+    m_pimpl(new PImpl)
+{
+
+}
+
+StepGraph::~StepGraph()
+{
+
+}
+
+int StepGraph::addStep(const QString &name, const Action &action, const ErrorFunc &error,
+                       const QVector<int> &dependencies, int timeoutMs)
+{
+    for (int dependency : dependencies) {
+        Q_ASSERT(dependency >= 0 && dependency < m_pimpl->steps.size());
+        Q_UNUSED(dependency)
+    }
+
+    PImpl::Step step;
+    step.name = name;
+    step.action = action;
+    step.error = error;
+    step.dependencies = dependencies;
+    step.timeoutMs = timeoutMs;
+
+    m_pimpl->steps.append(step);
+    return m_pimpl->steps.size() - 1;
+}
+
+bool StepGraph::run()
+{
+    m_pimpl->lastError.clear();
+    m_pimpl->states.reset(new PImpl::States);
+    m_pimpl->states->states.fill(StepPending, m_pimpl->steps.size());
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Steps mostly wait for devices threads so each one gets own thread,
+    // threads of abandoned steps are still busy
+    stepPool()->setMaxThreadCount(qMax(stepPool()->maxThreadCount(),
+                                       stepPool()->activeThreadCount() + m_pimpl->steps.size()));
+
+    const QSharedPointer<PImpl::States> states = m_pimpl->states;
+    QMutexLocker locker(&states->mutex);
+
+    bool failed = false;
+    for (;;) {
+        const qint64 timeout = m_pimpl->checkTimeouts();
+
+        for (const auto state : qAsConst(states->states)) {
+            if (state == StepFailed || state == StepTimedOut) {
+                failed = true;
+            }
+        }
+
+        bool hasRunning = false;
+        if (failed) {
+            for (auto &state : states->states) {
+                if (state == StepPending) {
+                    state = StepSkipped;
+                } else if (state == StepRunning) {
+                    hasRunning = true;
+                }
+            }
+        } else {
+            hasRunning = m_pimpl->startReadySteps();
+        }
+
+        if (!hasRunning) {
+            break;
+        }
+
+        if (timeout < 0) {
+            states->stepFinished.wait(&states->mutex);
+        } else if (timeout > 0) {
+            states->stepFinished.wait(&states->mutex, static_cast<unsigned long>(timeout));
+        }
+    }
+
+    dbgDevice << "Steps finished in" << timer.elapsed() << "ms";
+
+    for (int i = 0; i < m_pimpl->steps.size(); ++i) {
+        const auto &step = m_pimpl->steps.at(i);
+        const StepState state = states->states.at(i);
+
+        if (state == StepTimedOut) {
+            m_pimpl->lastError = QCoreApplication::translate("StepGraph", "Превышено время ожидания (%1). %2")
+                                 .arg(step.name, step.error ? step.error() : QString());
+            return false;
+        }
+
+        if (state == StepFailed) {
+            m_pimpl->lastError = step.error ? step.error() : step.name;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QString StepGraph::lastError() const
+{
+    return m_pimpl->lastError;
+}
@@ -0,0 +1,50 @@
+#ifndef DEVICE_STEPGRAPH_H
+#define DEVICE_STEPGRAPH_H
+
+#include "DeviceGlobal.h"
+
+#include <QScopedPointer>
+#include <QString>
+#include <QVector>
+
+#include <functional>
+
+/**
+ * Steps with dependencies executed in parallel. Every step is
+ * started as soon as all its dependencies have succeeded
+ **/
+class DEVICELIB_EXPORT StepGraph final
+{
+    Q_DISABLE_COPY(StepGraph)
+public:
+    typedef std::function<bool()> Action;
+    typedef std::function<QString()> ErrorFunc;
+
+    StepGraph();
+    ~StepGraph();
+
+    /**
+     * Returns step id for dependencies of next steps. Error
+     * function is called on failure from thread calling run().
+     * Step running longer than timeout fails, zero disables it.
+     * Action of such step keeps running until it returns, so it
+     * must not capture anything run() caller owns by reference
+     **/
+    int addStep(const QString &name, const Action &action, const ErrorFunc &error,
+                const QVector<int> &dependencies = QVector<int>(), int timeoutMs = 0);
+
+    /**
+     * No new steps are started after failure or timeout. Running
+     * steps are waited for until their timeouts, so run() returns
+     * even if a device call hangs. Error of the first failed step
+     * in order of adding is reported
+     **/
+    bool run();
+
+    QString lastError() const;
+private:
+    struct PImpl;
+    QScopedPointer<PImpl> m_pimpl;
+};
+
+#endif // DEVICE_STEPGRAPH_H
@@ -0,0 +1,164 @@
+#include "Trace.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QThread>
+
+#include "DeviceLogging.h"
+
+namespace {
+    QMutex currentTraceMutex;
+    QSharedPointer<Trace> currentTrace;
+}
+
+Trace::Span::Span(const char *name, const char *category) :
+    m_trace(Trace::current()),
+    m_name(name),
+    m_category(category),
+    m_startUs(m_trace ? m_trace->elapsedUs() : 0)
+{
+
+}
+
+Trace::Span::Span(const QString &name, const char *category) :
+    m_trace(Trace::current()),
+    m_name(nullptr),
+    m_category(category),
+    m_startUs(0)
+{
+    if (m_trace) {
+        m_ownedName = name.toUtf8();
+        m_startUs = m_trace->elapsedUs();
+    }
+}
+
+Trace::Span::~Span()
+{
+    if (m_trace) {
+        m_trace->addSpan(m_name ? QByteArray(m_name) : m_ownedName, m_category, m_startUs, m_trace->elapsedUs());
+    }
+}
+
+Trace::Trace(const QString &name) :
+    m_name(name)
+{
+    m_clock.start();
+}
+
+Trace::~Trace()
+{
+
+}
+
+void Trace::setCurrent(const QSharedPointer<Trace> &trace)
+{
+    QMutexLocker lock(&currentTraceMutex);
+    currentTrace = trace;
+}
+
+QSharedPointer<Trace> Trace::current()
+{
+    QMutexLocker lock(&currentTraceMutex);
+    return currentTrace;
+}
+
+QString Trace::name() const
+{
+    return m_name;
+}
+
+qint64 Trace::elapsedUs() const
+{
+    return m_clock.nsecsElapsed() / 1000;
+}
+
+void Trace::addSpan(const QByteArray &name, const char *category, qint64 startUs, qint64 endUs)
+{
+    QMutexLocker lock(&m_mutex);
+
+    Event event;
+    event.name = name;
+    event.category = category;
+    event.startUs = startUs;
+    event.durationUs = qMax<qint64>(endUs - startUs, 0);
+    event.thread = threadIndex(QThread::currentThread());
+    m_events.append(event);
+}
+
+QByteArray Trace::toChromeJson() const
+{
+    QMutexLocker lock(&m_mutex);
+
+    QJsonArray events;
+
+    // Metadata events name process and threads in trace viewer
+    QJsonObject processName;
+    processName.insert(QStringLiteral("name"), QStringLiteral("process_name"));
+    processName.insert(QStringLiteral("ph"), QStringLiteral("M"));
+    processName.insert(QStringLiteral("pid"), 1);
+    processName.insert(QStringLiteral("tid"), 0);
+    processName.insert(QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), m_name}});
+    events.append(processName);
+
+    for (int i = 0; i < m_threadNames.size(); ++i) {
+        QJsonObject threadName;
+        threadName.insert(QStringLiteral("name"), QStringLiteral("thread_name"));
+        threadName.insert(QStringLiteral("ph"), QStringLiteral("M"));
+        threadName.insert(QStringLiteral("pid"), 1);
+        threadName.insert(QStringLiteral("tid"), i + 1);
+        threadName.insert(QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), m_threadNames.at(i)}});
+        events.append(threadName);
+    }
+
+    for (const auto &event : m_events) {
+        QJsonObject object;
+        object.insert(QStringLiteral("name"), QString::fromUtf8(event.name));
+        object.insert(QStringLiteral("cat"), QString::fromLatin1(event.category));
+        object.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        object.insert(QStringLiteral("ts"), static_cast<double>(event.startUs));
+        object.insert(QStringLiteral("dur"), static_cast<double>(event.durationUs));
+        object.insert(QStringLiteral("pid"), 1);
+        object.insert(QStringLiteral("tid"), event.thread + 1);
+        events.append(object);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("traceEvents"), events);
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool Trace::save(const QString &filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        errDevice << "Failed to open trace file" << filename << file.errorString();
+        return false;
+    }
+
+    const QByteArray json = toChromeJson();
+    if (file.write(json) != json.size()) {
+        errDevice << "Failed to write trace file" << filename << file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+int Trace::threadIndex(QThread *thread)
+{
+    const int index = m_threads.indexOf(thread);
+    if (index >= 0) {
+        return index;
+    }
+
+    m_threads.append(thread);
+    m_threadNames.append(thread && !thread->objectName().isEmpty()
+                         ? thread->objectName()
+                         : QStringLiteral("Thread %1").arg(m_threads.size()));
+    return m_threads.size() - 1;
+}
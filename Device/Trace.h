@@ -0,0 +1,78 @@
+#ifndef DEVICE_TRACE_H
+#define DEVICE_TRACE_H
+
+#include "DeviceGlobal.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+class QThread;
+
+/**
+ * Spans of one operation on monotonic clock, exported as
+ * Chrome trace event JSON. Recording is thread safe
+ **/
+class DEVICELIB_EXPORT Trace final
+{
+    Q_DISABLE_COPY(Trace)
+public:
+    /**
+     * Records enclosing scope into current trace. Does
+     * nothing when no trace is current. Span shares trace,
+     * so it stays alive until spans of other threads end
+     **/
+    class DEVICELIB_EXPORT Span final
+    {
+        Q_DISABLE_COPY(Span)
+    public:
+        explicit Span(const char *name, const char *category = "device");
+        explicit Span(const QString &name, const char *category = "device");
+        ~Span();
+    private:
+        QSharedPointer<Trace> m_trace;
+        const char *m_name;
+        QByteArray m_ownedName;
+        const char *m_category;
+        qint64 m_startUs;
+    };
+
+    explicit Trace(const QString &name);
+    ~Trace();
+
+    /**
+     * Spans of all threads are recorded into current trace
+     **/
+    static void setCurrent(const QSharedPointer<Trace> &trace);
+    static QSharedPointer<Trace> current();
+
+    QString name() const;
+    qint64 elapsedUs() const;
+    void addSpan(const QByteArray &name, const char *category, qint64 startUs, qint64 endUs);
+
+    QByteArray toChromeJson() const;
+    bool save(const QString &filename) const;
+private:
+    struct Event
+    {
+        QByteArray name;
+        const char *category;
+        qint64 startUs;
+        qint64 durationUs;
+        int thread;
+    };
+
+    int threadIndex(QThread *thread);
+
+    QString m_name;
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;
+    QVector<Event> m_events;
+    QVector<QThread *> m_threads;
+    QVector<QString> m_threadNames;
+};
+
+#endif // DEVICE_TRACE_H
@@ -0,0 +1,28 @@
+QT       -= gui
+QT       += core
+CONFIG   += console
+CONFIG   -= app_bundle
+TEMPLATE  = app
+TARGET    = DeviceBenchmarks
+
+include($$PWD/../Global.pri)
+include($$PWD/../Device/Device.pri)
+
+win32: LIBS += -lpsapi
+
+# Detector kernels are built in, so vendor SDKs are not needed
+SIBEL_PATH = $$PWD/../DevicePlugins/SibelGenericDetector
+SSL_PATH = $$PWD/../DevicePlugins/SslDetector
+
+INCLUDEPATH += \
+    $$SIBEL_PATH \
+    $$SSL_PATH
+
+HEADERS += \
+    $$SIBEL_PATH/SibelLineDecoder.h \
+    $$SSL_PATH/SslLineConverter.h
+
+SOURCES += \
+    $$SIBEL_PATH/SibelLineDecoder.cpp \
+    $$SSL_PATH/SslLineConverter.cpp \
+    main.cpp
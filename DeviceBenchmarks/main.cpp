@@ -0,0 +1,427 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+
+#include <algorithm>
+#include <functional>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+#include <Device/BinningAcquisitionResultProcessor.h>
+#include <Device/FlatFieldCorrection.h>
+#include <Device/FlipAcquisitionResultProcessor.h>
+#include <Device/GeometryAcquisitionResultProcessor.h>
+#include <Device/ScaleAcquisitionResultProcessor.h>
+#include <Device/ScannerAcquisitionResultPipeline.h>
+
+#include "SibelLineDecoder.h"
+#include "SslLineConverter.h"
+
+namespace {
+    const float DARK_LEVEL = 1000.f;
+    const float BRIGHT_LEVEL = 30000.f;
+    const int SSL_PIXELS_PER_MATRIX = 256;
+
+    struct Result
+    {
+        QString name;
+        int width = 0;
+        int lines = 0;
+        int iterations = 0;
+        qint64 minNs = 0;
+        qint64 medianNs = 0;
+        double mpixPerSec = 0;
+        qint64 baselineRssKb = -1;
+        qint64 peakRssKb = -1;
+    };
+
+    qint64 readProcStatusKb(const QByteArray &key)
+    {
+#if defined(Q_OS_LINUX)
+        QFile status(QStringLiteral("/proc/self/status"));
+        if (status.open(QIODevice::ReadOnly)) {
+            for (const auto &line : status.readAll().split('\n')) {
+                if (line.startsWith(key)) {
+                    return line.mid(key.size()).trimmed().split(' ').value(0).toLongLong();
+                }
+            }
+        }
+#else
+        Q_UNUSED(key)
+#endif
+        return -1;
+    }
+
+    void resetPeakRss()
+    {
+#if defined(Q_OS_LINUX)
+        QFile clearRefs(QStringLiteral("/proc/self/clear_refs"));
+        if (clearRefs.open(QIODevice::WriteOnly)) {
+            clearRefs.write("5");
+        }
+#endif
+    }
+
+    qint64 currentRssKb()
+    {
+#if defined(Q_OS_WIN)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return static_cast<qint64>(counters.WorkingSetSize / 1024);
+        }
+        return -1;
+#else
+        return readProcStatusKb("VmRSS:");
+#endif
+    }
+
+    /**
+     * Peak resident memory since last reset, -1 if unknown.
+     * Only Linux is able to reset peak
+     **/
+    qint64 peakRssKb()
+    {
+#if defined(Q_OS_WIN)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+        }
+        return -1;
+#else
+        return readProcStatusKb("VmHWM:");
+#endif
+    }
+
+    /**
+     * Deterministic noisy frame, so runs are comparable
+     **/
+    template <typename T>
+    QVector<T> makeFrame(int width, int lines, float level, quint32 seed)
+    {
+        QVector<T> frame(width * lines);
+        quint32 state = seed;
+        for (auto &pixel : frame) {
+            state = state * 1664525u + 1013904223u;
+            pixel = static_cast<T>(level * (0.9f + 0.2f * (state >> 8) / 16777216.f));
+        }
+        return frame;
+    }
+
+    Result measure(const QString &name, int width, int lines, int iterations,
+                   const std::function<void()> &prepare, const std::function<void()> &run)
+    {
+        Result result;
+        result.name = name;
+        result.width = width;
+        result.lines = lines;
+        result.iterations = iterations;
+
+        QVector<qint64> times;
+        times.reserve(iterations);
+
+        prepare();
+        result.baselineRssKb = currentRssKb();
+        resetPeakRss();
+
+        for (int i = 0; i < iterations; ++i) {
+            if (i) {
+                prepare();
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            run();
+            times.append(timer.nsecsElapsed());
+        }
+
+        result.peakRssKb = peakRssKb();
+
+        std::sort(times.begin(), times.end());
+        result.minNs = times.first();
+        result.medianNs = times.at(times.size() / 2);
+        result.mpixPerSec = result.medianNs > 0 ? 1e3 * width * lines / result.medianNs : 0;
+        return result;
+    }
+
+    QVector<int> parseList(const QString &value)
+    {
+        QVector<int> list;
+        for (const auto &item : value.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+            const int number = item.trimmed().toInt();
+            if (number > 0) {
+                list.append(number);
+            }
+        }
+        return list;
+    }
+
+    int sibelBatches(int width)
+    {
+        return width % 3 == 0 ? 3 : 4;
+    }
+
+    QVector<Result> runGeometry(int width, int lines, int iterations, const QString &filter,
+                                const QTemporaryDir &directory)
+    {
+        QVector<Result> results;
+        const auto selected = [&filter](const QString &name) {
+            return filter.isEmpty() || name.contains(filter);
+        };
+
+        const QVector<float> dark = makeFrame<float>(width, lines, DARK_LEVEL, 1);
+        const QVector<float> image = makeFrame<float>(width, lines, BRIGHT_LEVEL, 2);
+
+        Scanner::AcquisitionResult acquisition;
+        const auto resetAcquisition = [&] {
+            acquisition.width = width;
+            acquisition.image = image;
+            acquisition.image.detach();
+            acquisition.dark = dark;
+            acquisition.pixelSize = QSizeF(0.1, 0.1);
+        };
+
+        {
+            FlatFieldCorrection correction(directory.filePath(QStringLiteral("gains_%1_%2.bin").arg(width).arg(lines)));
+
+            if (selected(QStringLiteral("ffc_calibrate"))) {
+                results << measure(QStringLiteral("ffc_calibrate"), width, lines, iterations, [] {}, [&] {
+                    correction.calibrate(image, dark, width);
+                });
+            } else {
+                correction.calibrate(image, dark, width);
+            }
+
+            QVector<float> corrected;
+            if (selected(QStringLiteral("ffc_correct"))) {
+                results << measure(QStringLiteral("ffc_correct"), width, lines, iterations, [&] {
+                    corrected = image;
+                    corrected.detach();
+                }, [&] {
+                    correction.correct(corrected, dark, width);
+                });
+            }
+        }
+
+        if (selected(QStringLiteral("binning_2x2"))) {
+            BinningAcquisitionResultProcessor binning;
+            binning.setHorizontal(2);
+            binning.setVertical(2);
+            binning.setSum(false);
+            results << measure(QStringLiteral("binning_2x2"), width, lines, iterations, resetAcquisition, [&] {
+                binning.process(acquisition);
+            });
+        }
+
+        if (selected(QStringLiteral("flip_horizontal"))) {
+            FlipAcquisitionResultProcessor flip;
+            flip.setFlipHorizontal(true);
+            results << measure(QStringLiteral("flip_horizontal"), width, lines, iterations, resetAcquisition, [&] {
+                flip.process(acquisition);
+            });
+        }
+
+        if (selected(QStringLiteral("rotate_90"))) {
+            GeometryAcquisitionResultProcessor rotate;
+            rotate.setRotation(FrameGeometry::Rotate90);
+            results << measure(QStringLiteral("rotate_90"), width, lines, iterations, resetAcquisition, [&] {
+                rotate.process(acquisition);
+            });
+        }
+
+        if (selected(QStringLiteral("scale_half"))) {
+            ScaleAcquisitionResultProcessor scale;
+            scale.setWidth(width / 2);
+            results << measure(QStringLiteral("scale_half"), width, lines, iterations, resetAcquisition, [&] {
+                scale.process(acquisition);
+            });
+        }
+
+        if (selected(QStringLiteral("scale_half_lanczos"))) {
+            ScaleAcquisitionResultProcessor scale;
+            scale.setWidth(width / 2);
+            scale.setFilter(LineResampler::Lanczos3);
+            results << measure(QStringLiteral("scale_half_lanczos"), width, lines, iterations, resetAcquisition, [&] {
+                scale.process(acquisition);
+            });
+        }
+
+        if (selected(QStringLiteral("pipeline"))) {
+            // Scanning mode with every fused stage: 2x2 binning,
+            // scaling of binned lines and horizontal flip
+            ScanningModesCollection::Item mode;
+            mode.binningHorizontal = 1;
+            mode.binningVertical = 1;
+            mode.snapshotWidth = static_cast<quint16>(width / 3);
+            mode.flipHorizontal = true;
+
+            BufferPool<float> pool;
+            ScannerAcquisitionResultPipeline pipeline(mode);
+            // Input is detached by resetAcquisition, so it can be recycled
+            pipeline.setFramePool(&pool, true);
+            results << measure(QStringLiteral("pipeline"), width, lines, iterations, resetAcquisition, [&] {
+                pipeline.apply(acquisition);
+            });
+        }
+
+        acquisition = Scanner::AcquisitionResult();
+
+        const QVector<quint16> raw = makeFrame<quint16>(width, lines, BRIGHT_LEVEL, 3);
+        QVector<float> frame;
+
+        if (selected(QStringLiteral("sibel_decode")) && width % sibelBatches(width) == 0) {
+            SibelLineDecoder decoder;
+            decoder.setGeometry(width, sibelBatches(width));
+            results << measure(QStringLiteral("sibel_decode"), width, lines, iterations, [&] {
+                frame.resize(width * lines);
+            }, [&] {
+                decoder.decode(reinterpret_cast<const uchar *>(raw.constData()), lines, 0, lines, frame.data());
+            });
+        }
+
+        if (selected(QStringLiteral("ssl_convert")) && width % SSL_PIXELS_PER_MATRIX == 0) {
+            SslLineConverter converter;
+            converter.hardwareWidth = static_cast<ushort>(width);
+            converter.pixelsPerMatrix = SSL_PIXELS_PER_MATRIX;
+            converter.matrixCount = width / SSL_PIXELS_PER_MATRIX;
+            converter.fixesMatrixJoint = true;
+            results << measure(QStringLiteral("ssl_convert"), width, lines, iterations, [&] {
+                frame.resize(converter.calcResultFrameWidth() * lines);
+            }, [&] {
+                converter.convertRawLines(reinterpret_cast<const char *>(raw.constData()), frame, lines, 0, lines);
+                converter.fixMatrixJoint(frame, lines, 0, lines);
+            });
+        }
+
+        return results;
+    }
+
+    QJsonObject toJson(const Result &result)
+    {
+        QJsonObject object;
+        object.insert(QStringLiteral("name"), result.name);
+        object.insert(QStringLiteral("width"), result.width);
+        object.insert(QStringLiteral("lines"), result.lines);
+        object.insert(QStringLiteral("iterations"), result.iterations);
+        object.insert(QStringLiteral("min_ms"), result.minNs / 1e6);
+        object.insert(QStringLiteral("median_ms"), result.medianNs / 1e6);
+        object.insert(QStringLiteral("mpix_per_s"), result.mpixPerSec);
+        object.insert(QStringLiteral("baseline_rss_kb"), static_cast<double>(result.baselineRssKb));
+        object.insert(QStringLiteral("peak_rss_kb"), static_cast<double>(result.peakRssKb));
+        return object;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures Device library image processing throughput"));
+    parser.addHelpOption();
+
+    const QCommandLineOption widthsOption(QStringLiteral("widths"), QStringLiteral("Frame widths."),
+                                          QStringLiteral("list"), QStringLiteral("2304,4096,4608"));
+    const QCommandLineOption linesOption(QStringLiteral("lines"), QStringLiteral("Frame lines."),
+                                         QStringLiteral("list"), QStringLiteral("2000,6000"));
+    const QCommandLineOption iterationsOption(QStringLiteral("iterations"), QStringLiteral("Runs of every benchmark."),
+                                              QStringLiteral("count"), QStringLiteral("5"));
+    const QCommandLineOption filterOption(QStringLiteral("filter"), QStringLiteral("Runs benchmarks containing text only."),
+                                          QStringLiteral("text"));
+    const QCommandLineOption formatOption(QStringLiteral("format"), QStringLiteral("Output format: tsv or json."),
+                                          QStringLiteral("format"), QStringLiteral("tsv"));
+    const QCommandLineOption outputOption(QStringLiteral("output"), QStringLiteral("Output file, stdout by default."),
+                                          QStringLiteral("file"));
+
+    parser.addOptions({widthsOption, linesOption, iterationsOption, filterOption, formatOption, outputOption});
+    parser.process(app);
+
+    QTextStream err(stderr);
+
+    const auto widths = parseList(parser.value(widthsOption));
+    const auto linesList = parseList(parser.value(linesOption));
+    const int iterations = qMax(1, parser.value(iterationsOption).toInt());
+    const QString format = parser.value(formatOption);
+
+    if (widths.isEmpty() || linesList.isEmpty()) {
+        err << "Widths and lines must be positive numbers" << '\n';
+        return 1;
+    }
+
+    if (format != QLatin1String("tsv") && format != QLatin1String("json")) {
+        err << "Unknown format: " << format << '\n';
+        return 1;
+    }
+
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        err << "Failed to create temporary directory" << '\n';
+        return 1;
+    }
+
+    QVector<Result> results;
+    for (int width : widths) {
+        for (int lines : linesList) {
+            err << "Running " << width << "x" << lines << '\n';
+            err.flush();
+            results << runGeometry(width, lines, iterations, parser.value(filterOption), directory);
+        }
+    }
+
+    QFile output;
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            err << "Failed to open " << output.fileName() << ": " << output.errorString() << '\n';
+            return 1;
+        }
+    } else if (!output.open(stdout, QIODevice::WriteOnly | QIODevice::Text)) {
+        return 1;
+    }
+
+    QTextStream out(&output);
+
+    if (format == QLatin1String("json")) {
+        QJsonArray array;
+        for (const auto &result : qAsConst(results)) {
+            array.append(toJson(result));
+        }
+
+        QJsonObject root;
+        root.insert(QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+        root.insert(QStringLiteral("host"), QSysInfo::machineHostName());
+        root.insert(QStringLiteral("cpu_architecture"), QSysInfo::currentCpuArchitecture());
+        root.insert(QStringLiteral("threads"), QThread::idealThreadCount());
+        root.insert(QStringLiteral("qt_version"), QString::fromLatin1(qVersion()));
+        root.insert(QStringLiteral("results"), array);
+
+        out << QJsonDocument(root).toJson(QJsonDocument::Indented);
+    } else {
+        out << "name\twidth\tlines\titerations\tmin_ms\tmedian_ms\tmpix_per_s\tbaseline_rss_kb\tpeak_rss_kb" << '\n';
+        for (const auto &result : qAsConst(results)) {
+            out << result.name << '\t'
+                << result.width << '\t'
+                << result.lines << '\t'
+                << result.iterations << '\t'
+                << result.minNs / 1e6 << '\t'
+                << result.medianNs / 1e6 << '\t'
+                << result.mpixPerSec << '\t'
+                << result.baselineRssKb << '\t'
+                << result.peakRssKb << '\n';
+        }
+    }
+
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <QThread>
 #include <QElapsedTimer>
 
+#include <Device/DeviceLogging.h>
 #include <Device/NpFrame.h>
 
 const QString RACK_MOVING = QStringLiteral("main/rack_moving");
@@ -388,7 +389,8 @@ void BkuHardware::doRefreshState(QMap<Door, DoorState> &doors, RackState &rack)
     RackState rackState = RackStateUnknown;
 
     NpFrame getStateCommand(0x25, 0x4D, 0x00, 0x00, 0xFF);
-    NpFrame currentState = m_accessor->writeAndRead(getStateCommand);
+    const QByteArray reply = m_accessor->writeAndRead(getStateCommand);
+    NpFrame currentState = reply;
     if (currentState.isValid() && currentState.cmd() == 0x5D) {
         {
             bool firstDoorIsClosed = ((currentState.reg1() & (1 << 2)) &&
@@ -430,6 +432,9 @@ void BkuHardware::doRefreshState(QMap<Door, DoorState> &doors, RackState &rack)
                 rackState = RackStateBottom;
             }
         }
+    } else {
+        warnDevice << "Refresh state:"
+                   << "Response is invalid:" << reply.toHex();
     }
 
     doors.insert(DoorFirst, firstDoorState);
@@ -1,21 +1,96 @@
 #include "EmptyDetector.h"
 
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
 #include <QThread>
+#include <QtMath>
 #include <random>
 
 #include <Device/DeviceLogging.h>
+#include <Device/ParallelFor.h>
+#include <Device/PixelConversion.h>
 
 const qreal DEFAULT_PIXEL_SIZE = 0.2;
 const int DEFAULT_WIDTH = 576;
 const qreal DEFAULT_CHARGE_TIME = 3;
+const bool DEFAULT_NO_SLEEP = false;
+const qreal DEFAULT_SIGNAL = 30000;
+const qreal DEFAULT_OFFSET = 1000;
+const qreal DEFAULT_DARK_CURRENT = 20;
+const qreal DEFAULT_GAIN_SPREAD = 0.05;
+const qreal DEFAULT_DEAD_PIXELS = 0.002;
+const int DEFAULT_MATRIX_PIXELS = 64;
+const qreal DEFAULT_JOINT_GAIN = 0.6;
+const int DEFAULT_SEED = 1;
+const qreal DEFAULT_TEMPERATURE = 30;
 
 const QString DETECTOR_WIDTH = QStringLiteral("main/width");
 const QString DETECTOR_CHARGE_TIME = QStringLiteral("main/charge_time");
 const QString DETECTOR_PIXEL_SIZE = QStringLiteral("main/pixel_size");
+const QString SIMULATION_NO_SLEEP = QStringLiteral("simulation/no_sleep");
+const QString SIMULATION_SIGNAL = QStringLiteral("simulation/signal");
+const QString SIMULATION_OFFSET = QStringLiteral("simulation/offset");
+const QString SIMULATION_DARK_CURRENT = QStringLiteral("simulation/dark_current");
+const QString SIMULATION_GAIN_SPREAD = QStringLiteral("simulation/gain_spread");
+const QString SIMULATION_DEAD_PIXELS = QStringLiteral("simulation/dead_pixels");
+const QString SIMULATION_MATRIX_PIXELS = QStringLiteral("simulation/matrix_pixels");
+const QString SIMULATION_JOINT_GAIN = QStringLiteral("simulation/joint_gain");
+const QString SIMULATION_SEED = QStringLiteral("simulation/seed");
+const QString SIMULATION_TEMPERATURE = QStringLiteral("simulation/temperature");
+const QString SIMULATION_REPLAY_DIRECTORY = QStringLiteral("simulation/replay_directory");
 
-EmptyDetector::EmptyDetector(QObject *parent) : Detector(parent)
+namespace {
+    // Noise is looked up by hash of pixel position, so lines
+    // are generated in any order and inner loops have no state
+    const int NORMAL_TABLE_SIZE = 1 << 16;
+    const quint32 NORMAL_TABLE_MASK = NORMAL_TABLE_SIZE - 1;
+    const int MIN_LINES_PER_BLOCK = 16;
+    const float MAX_PIXEL_VALUE = 65535.f;
+    // Body shaped phantom in the middle of exposed frame
+    const float PHANTOM_TRANSMISSION = 0.35f;
+    const float PHANTOM_WIDTH = 0.7f;
+    const float PHANTOM_HEIGHT = 0.9f;
+
+    inline quint32 pixelHash(quint32 seed, quint32 pixel)
+    {
+        quint32 h = (seed + pixel) * 0x9E3779B1u;
+        h ^= h >> 15;
+        h *= 0x85EBCA77u;
+        h ^= h >> 13;
+        return h;
+    }
+}
+
+struct EmptyDetector::PImpl
 {
+    bool noSleep;
+    float signal;
+    qreal temperature;
+    quint32 captureSeed;
 
+    // Dark level and exposed gain of every column,
+    // dead pixels have both zero
+    QVector<float> darkLevel;
+    QVector<float> gain;
+    QVector<float> normalTable;
+
+    QStringList replayFiles;
+    int replayIndex;
+    // Replayed frame of current capture and count of its lines
+    QByteArray replayFrame;
+    int replayFrameLines;
+};
+
+EmptyDetector::EmptyDetector(QObject *parent) : Detector(parent),
+    m_pimpl(new PImpl)
+{
+    m_pimpl->noSleep = DEFAULT_NO_SLEEP;
+    m_pimpl->signal = DEFAULT_SIGNAL;
+    m_pimpl->temperature = DEFAULT_TEMPERATURE;
+    m_pimpl->captureSeed = 0;
+    m_pimpl->replayIndex = 0;
+    m_pimpl->replayFrameLines = 0;
 }
 
 EmptyDetector::~EmptyDetector()
@@ -28,19 +103,88 @@ bool EmptyDetector::doTestConnection()
     return true;
 }
 
-Detector::Frame EmptyDetector::makeFrame(quint32 lines, float value)
+void EmptyDetector::makeLines(Frame &frame, int firstLine, int count, int linesCount, bool exposed)
 {
-    auto props = properties();
+    const int width = properties().width;
+    const float signal = exposed ? m_pimpl->signal : 0.f;
+    const float *darkLevel = m_pimpl->darkLevel.constData();
+    const float *gain = m_pimpl->gain.constData();
+    const float *normalTable = m_pimpl->normalTable.constData();
+    const quint32 seed = m_pimpl->captureSeed;
+    float *pixels = frame.data();
+
+    ParallelFor::run(count, MIN_LINES_PER_BLOCK, [=](int, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const int line = firstLine + i;
+            float *dst = pixels + line * width;
 
-    Frame result(props.width * lines);
-    std::default_random_engine generator;
-    std::poisson_distribution<ushort> distribution(value);
-    for (int i = 0; i < result.size(); i++) {
-        result[i] = distribution(generator);
+            // Columns [phantomBegin, phantomEnd) of line are behind phantom
+            const float dy = (line + 0.5f - linesCount * 0.5f) / (linesCount * PHANTOM_HEIGHT * 0.5f);
+            const float halfWidth = dy * dy < 1.f ? width * PHANTOM_WIDTH * 0.5f * std::sqrt(1.f - dy * dy) : 0.f;
+            const int phantomBegin = qRound(width * 0.5f - halfWidth);
+            const int phantomEnd = qRound(width * 0.5f + halfWidth);
+            const quint32 lineSeed = seed ^ (static_cast<quint32>(line) * 0x27D4EB2Fu);
+
+            for (int x = 0; x < width; ++x) {
+                const float transmission = x >= phantomBegin && x < phantomEnd ? PHANTOM_TRANSMISSION : 1.f;
+                const float mean = darkLevel[x] + signal * gain[x] * transmission;
+                const float noise = normalTable[pixelHash(lineSeed, static_cast<quint32>(x)) & NORMAL_TABLE_MASK];
+                // Poisson noise approximated by normal one of the same variance
+                dst[x] = qBound(0.f, mean + noise * std::sqrt(mean), MAX_PIXEL_VALUE);
+            }
+        }
+    });
+}
+
+void EmptyDetector::loadReplayFrame()
+{
+    m_pimpl->replayFrame.clear();
+    m_pimpl->replayFrameLines = 0;
+
+    if (m_pimpl->replayFiles.isEmpty()) {
+        return;
     }
-    QThread::msleep(static_cast<unsigned int>(props.chargeTimeMsec * lines));
-    return result;
 
+    const int width = properties().width;
+    const QString filename = m_pimpl->replayFiles.at(m_pimpl->replayIndex);
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        warnDevice << "Failed to open replayed frame" << filename << file.errorString();
+        return;
+    }
+
+    QByteArray raw = file.readAll();
+    const int fileLines = raw.size() / static_cast<int>(width * sizeof(quint16));
+    if (fileLines < 1) {
+        warnDevice << "Replayed frame" << filename << "is shorter than line";
+        return;
+    }
+
+    m_pimpl->replayFrame.swap(raw);
+    m_pimpl->replayFrameLines = fileLines;
+}
+
+bool EmptyDetector::replayLines(Frame &frame, int firstLine, int count)
+{
+    if (m_pimpl->replayFrameLines < 1) {
+        return false;
+    }
+
+    const int width = properties().width;
+    const int fileLines = m_pimpl->replayFrameLines;
+
+    // Recorded frame is repeated if it is shorter than requested one
+    const auto src = reinterpret_cast<const quint16 *>(m_pimpl->replayFrame.constData());
+    float *dst = frame.data();
+    ParallelFor::run(count, MIN_LINES_PER_BLOCK, [=](int, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            const int line = firstLine + i;
+            PixelConversion::toFloat(src + (line % fileLines) * width, dst + line * width, width);
+        }
+    });
+
+    return true;
 }
 
 bool EmptyDetector::doOpen()
@@ -73,12 +217,64 @@ bool EmptyDetector::doOpen()
 
     setProperties(props);
 
+    m_pimpl->noSleep = cfg.value(SIMULATION_NO_SLEEP).toBool();
+    m_pimpl->signal = static_cast<float>(cfg.value(SIMULATION_SIGNAL).toReal());
+    m_pimpl->temperature = cfg.value(SIMULATION_TEMPERATURE).toReal();
+
+    const qreal offset = cfg.value(SIMULATION_OFFSET).toReal();
+    const qreal darkCurrent = cfg.value(SIMULATION_DARK_CURRENT).toReal();
+    const qreal gainSpread = qMax<qreal>(0, cfg.value(SIMULATION_GAIN_SPREAD).toReal());
+    const qreal deadPixels = cfg.value(SIMULATION_DEAD_PIXELS).toReal();
+    const int matrixPixels = cfg.value(SIMULATION_MATRIX_PIXELS).toInt();
+    const qreal jointGain = cfg.value(SIMULATION_JOINT_GAIN).toReal();
+
+    // The same seed gives the same detector after every open
+    std::mt19937 generator(cfg.value(SIMULATION_SEED).toUInt());
+    std::normal_distribution<float> normal;
+    std::uniform_real_distribution<qreal> uniform;
+
+    m_pimpl->darkLevel.resize(props.width);
+    m_pimpl->gain.resize(props.width);
+    for (int x = 0; x < props.width; ++x) {
+        const bool dead = uniform(generator) < deadPixels;
+        const bool joint = matrixPixels > 0 && (x % matrixPixels == 0 || x % matrixPixels == matrixPixels - 1);
+
+        const qreal level = offset * (1 + gainSpread * normal(generator)) +
+                            darkCurrent * props.chargeTimeMsec * (1 + gainSpread * normal(generator));
+        const qreal gain = (1 + gainSpread * normal(generator)) * (joint ? jointGain : 1);
+
+        m_pimpl->darkLevel[x] = dead ? 0.f : static_cast<float>(qMax<qreal>(0, level));
+        m_pimpl->gain[x] = dead ? 0.f : static_cast<float>(qMax<qreal>(0, gain));
+    }
+
+    m_pimpl->normalTable.resize(NORMAL_TABLE_SIZE);
+    for (auto &value : m_pimpl->normalTable) {
+        value = normal(generator);
+    }
+
+    m_pimpl->replayFiles.clear();
+    m_pimpl->replayIndex = 0;
+
+    const QString replayDirectory = cfg.value(SIMULATION_REPLAY_DIRECTORY).toString();
+    if (!replayDirectory.isEmpty()) {
+        const QDir dir(replayDirectory);
+        for (const auto &name : dir.entryList({QStringLiteral("*.raw")}, QDir::Files, QDir::Name)) {
+            m_pimpl->replayFiles.append(dir.filePath(name));
+        }
+
+        if (m_pimpl->replayFiles.isEmpty()) {
+            warnDevice << "No raw frames to replay in" << replayDirectory;
+        }
+    }
+
     return true;
 }
 
 void EmptyDetector::doClose()
 {
-
+    m_pimpl->replayFiles.clear();
+    m_pimpl->replayFrame.clear();
+    m_pimpl->replayFrameLines = 0;
 }
 
 bool EmptyDetector::doPrepare()
@@ -88,7 +284,64 @@ bool EmptyDetector::doPrepare()
 
 bool EmptyDetector::doCapture()
 {
-    setLastCapturedFrame(makeFrame(currentLines(), 65535));
+    const auto props = properties();
+    const int linesCount = static_cast<int>(currentLines());
+    const int blockLines = streamBlockLines() ? static_cast<int>(streamBlockLines()) : linesCount;
+
+    Frame frame = framePool().acquire(props.width * linesCount);
+    ++m_pimpl->captureSeed;
+
+    bool replayed = false;
+    // File is read once on first exposed block, not for every block
+    bool replayLoaded = false;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int firstLine = 0; firstLine < linesCount; firstLine += blockLines) {
+        const int lines = qMin(blockLines, linesCount - firstLine);
+
+        // Lines are charged before they are read out
+        if (!m_pimpl->noSleep) {
+            const qint64 readyMs = qCeil((firstLine + lines) * props.chargeTimeMsec);
+            const qint64 elapsedMs = timer.elapsed();
+            if (readyMs > elapsedMs) {
+                QThread::msleep(static_cast<unsigned long>(readyMs - elapsedMs));
+            }
+        }
+
+        const bool exposed = isXrayOn();
+        if (exposed && !replayLoaded) {
+            loadReplayFrame();
+            replayLoaded = true;
+        }
+
+        if (!exposed || !replayLines(frame, firstLine, lines)) {
+            makeLines(frame, firstLine, lines, linesCount, exposed);
+        } else {
+            replayed = true;
+        }
+
+        if (streamBlockLines()) {
+            setCapturedLines(static_cast<quint32>(firstLine),
+                             frame.mid(firstLine * props.width, lines * props.width));
+        }
+    }
+
+    if (replayed && !m_pimpl->replayFiles.isEmpty()) {
+        m_pimpl->replayIndex = (m_pimpl->replayIndex + 1) % m_pimpl->replayFiles.size();
+    }
+
+    m_pimpl->replayFrame.clear();
+    m_pimpl->replayFrameLines = 0;
+
+    setLastCapturedFrame(frame);
+    return true;
+}
+
+bool EmptyDetector::doReadTemperature(qreal &celsius)
+{
+    celsius = m_pimpl->temperature;
     return true;
 }
 
@@ -98,5 +351,16 @@ DeviceConfiguration EmptyDetector::defaultConfiguration() const
     conf.insert(DETECTOR_WIDTH, DEFAULT_WIDTH, tr("Ширина, пиксели [>0]"));
     conf.insert(DETECTOR_CHARGE_TIME, DEFAULT_CHARGE_TIME, tr("Время накопления, мс [>0.0]"));
     conf.insert(DETECTOR_PIXEL_SIZE, DEFAULT_PIXEL_SIZE, tr("Размер пикселя, мм [>0.0]"));
+    conf.insert(SIMULATION_NO_SLEEP, DEFAULT_NO_SLEEP, tr("Без ожидания накопления"));
+    conf.insert(SIMULATION_SIGNAL, DEFAULT_SIGNAL, tr("Уровень сигнала при включенном РПУ [>0.0]"));
+    conf.insert(SIMULATION_OFFSET, DEFAULT_OFFSET, tr("Смещение нуля [>=0.0]"));
+    conf.insert(SIMULATION_DARK_CURRENT, DEFAULT_DARK_CURRENT, tr("Темновой ток, отсчеты на мс [>=0.0]"));
+    conf.insert(SIMULATION_GAIN_SPREAD, DEFAULT_GAIN_SPREAD, tr("Разброс усиления пикселей [>=0.0]"));
+    conf.insert(SIMULATION_DEAD_PIXELS, DEFAULT_DEAD_PIXELS, tr("Доля битых пикселей [0.0-1.0]"));
+    conf.insert(SIMULATION_MATRIX_PIXELS, DEFAULT_MATRIX_PIXELS, tr("Кол-во пикселей в матрице [>=0]"));
+    conf.insert(SIMULATION_JOINT_GAIN, DEFAULT_JOINT_GAIN, tr("Усиление пикселей на стыках матриц [>=0.0]"));
+    conf.insert(SIMULATION_SEED, DEFAULT_SEED, tr("Зерно генератора детектора"));
+    conf.insert(SIMULATION_TEMPERATURE, DEFAULT_TEMPERATURE, tr("Температура, °C"));
+    conf.insert(SIMULATION_REPLAY_DIRECTORY, QString(), tr("Каталог записанных кадров *.raw (uint16)"));
     return conf;
 }
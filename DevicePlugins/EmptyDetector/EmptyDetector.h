@@ -1,8 +1,16 @@
 #ifndef EMPTYDETECTOR_H
 #define EMPTYDETECTOR_H
 
+#include <QScopedPointer>
+
 #include <Device/Detector.h>
 
+/**
+ * Simulated line detector. Lines have per column offset, gain
+ * and dark current, dead pixels and weak matrix joints, and are
+ * exposed only while scanner X-ray is on. Exposed frames can be
+ * replayed from recorded raw files instead
+ **/
 class EmptyDetector : public Detector
 {
     Q_OBJECT
@@ -17,8 +25,14 @@ protected:
     bool doTestConnection() override;
     bool doPrepare() override;
     bool doCapture() override;
+    bool doReadTemperature(qreal &celsius) override;
 private:
-    Frame makeFrame(quint32 lines, float value);
+    void makeLines(Frame &frame, int firstLine, int count, int linesCount, bool exposed);
+    void loadReplayFrame();
+    bool replayLines(Frame &frame, int firstLine, int count);
+
+    struct PImpl;
+    QScopedPointer<PImpl> m_pimpl;
 };
 
 
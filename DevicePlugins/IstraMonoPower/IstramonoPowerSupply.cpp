@@ -90,6 +90,9 @@ bool IstramonoPowerSupply::doOpen()
         return false;
     }
 
+    m_accessor->setPriority(Dispatcher::Priority_Control);
+    m_accessor->setDeadlineMs(Dispatcher::controlDeadlineMs);
+
     return true;
 }
 
@@ -102,10 +105,11 @@ bool IstramonoPowerSupply::doTestConnection()
 {
     NpFrame pingRequest(0x10, 0x1, 0x55, 0x55, 0x55);
     NpFrame pingRightResponse(0x10, 0x2, 0xAA, 0xAA, 0xAA);
-    NpFrame pingResponse = m_accessor->writeAndRead(pingRequest);
+    const QByteArray pingReply = m_accessor->writeAndRead(pingRequest);
+    NpFrame pingResponse = pingReply;
     if (pingResponse != pingRightResponse) {
         errDevice << "Test connection:"
-                  << "Ping response:" << pingResponse.toHex()
+                  << "Ping response:" << pingReply.toHex()
                   << "Expected first" << NpFrame::size << "bytes:" << pingRightResponse.toHex();
         setLastError(tr("Ответ на команду тест связи отсутствует или неверный"));
         return false;
@@ -149,43 +153,44 @@ bool IstramonoPowerSupply::doPrepare()
     NpFrame setExposureRequest(0x10, 0x8,
                                static_cast<quint8>(exposure & 0xFF),
                                static_cast<quint8>(exposure >> 8), 0);
-    if (!m_accessor->write(setExposureRequest)) {
-        errDevice << "Prepare:"
-                  << "Failed to send set exposure command";
-        return false;
-    }
-
     NpFrame setParamsRequest(0x10, 0xAC, voltage, amperage);
     NpFrame setParamsRightResponse(0x10, 0xAB, voltage, amperage);
-    NpFrame setParamsResponse = m_accessor->writeAndRead(setParamsRequest);
+    const auto setParamsReplies = m_accessor->transaction({Dispatcher::Request(setExposureRequest, false),
+                                                           Dispatcher::Request(setParamsRequest)});
+    NpFrame setParamsResponse = setParamsReplies.at(1);
 
     if (setParamsResponse != setParamsRightResponse) {
         errDevice << "Prepare:"
-                  << "Response is invalid:" << setParamsResponse.toHex();
+                  << "Response is invalid:" << setParamsReplies.at(1).toHex();
         setLastError(tr("Ответ на команду установки параметров неверный или отсутствует"));
         return false;
     }
 
     NpFrame prepareRightResponse(0x10, 0xAE);
     const int timeoutPrepareResponse = 8000;
-    NpFrame prepareResponse;
+    QByteArray prepareReply;
     if (currentConfiguration().value(USE_PHYSICAL_BUTTONS_PARAM).toBool()) {
-        prepareResponse = m_accessor->read(timeoutPrepareResponse);
+        prepareReply = m_accessor->read(timeoutPrepareResponse);
     } else {
         NpFrame pressButtonPrepare(0x10, 0x7B, 1);
-        m_accessor->write(pressButtonPrepare);
         NpFrame pressButtonScan(0x10, 0x7A, 1);
-        prepareResponse = m_accessor->writeAndRead(pressButtonScan, timeoutPrepareResponse);
+        prepareReply = m_accessor->transaction({Dispatcher::Request(pressButtonPrepare, false),
+                                                Dispatcher::Request(pressButtonScan, true,
+                                                                    timeoutPrepareResponse)}).at(1);
     }
 
+    const NpFrame prepareResponse = prepareReply;
+
     if (!prepareResponse.isValid()) {
+        errDevice << "Prepare:"
+                  << "Response is invalid:" << prepareReply.toHex();
         setLastError(tr("Превышено время ожидания ответа на команду подготовки"));
         return false;
     }
 
     if (prepareResponse != prepareRightResponse) {
         errDevice << "Prepare:"
-                  << "Response:" << prepareResponse.toHex()
+                  << "Response:" << prepareReply.toHex()
                   << "Expected:" << prepareRightResponse.toHex();
 
         const auto address = prepareResponse.addr();
@@ -216,13 +221,13 @@ bool IstramonoPowerSupply::doOn()
 
 bool IstramonoPowerSupply::doWaitForError()
 {
-    QByteArray statusResponse = m_accessor->read(currentParams().exposureMs);
+    // Status burst ends with error frame, which may come in the next chunk
+    QByteArray statusResponse = m_accessor->read(currentParams().exposureMs, Dispatcher::Read_Burst);
     if (statusResponse.isEmpty()) {
-        statusResponse = m_accessor->writeAndRead(NpFrame(0x10, 0x70));
+        statusResponse = m_accessor->writeAndRead(NpFrame(0x10, 0x70), 1000, Dispatcher::Read_Burst);
     }
 
-    QVector<NpFrame> frames = NpFrame::splitFrames(statusResponse);
-    const NpFrame statusResponseFrame = !frames.isEmpty() ? frames.last() : NpFrame();
+    const NpFrame statusResponseFrame = NpFrameReader(statusResponse).last();
 
     if (statusResponseFrame.isValid()) {
         const auto address = statusResponseFrame.addr();
@@ -245,6 +250,8 @@ bool IstramonoPowerSupply::doWaitForError()
         }
     }
 
+    errDevice << "Wait for error:"
+              << "Unknown status response:" << statusResponse.toHex();
     setLastError(tr("Неизвестная ошибка"));
     return true;
 }
@@ -276,23 +283,37 @@ bool IstramonoPowerSupply::doOff()
 
 bool IstramonoPowerSupply::doGetResults(Results &results)
 {
-    NpFrame measureRequest(0x10, 0x77);
-    const NpFrame measureResponse = m_accessor->writeAndRead(measureRequest);
+    const bool fetchExposure = currentConfiguration().value(FETCH_EXPOSURE_PARAM).toBool();
+
+    // Exposure is not queried after invalid measure reply
+    Dispatcher::Request measureRequest(NpFrame(0x10, 0x77));
+    measureRequest.validator = [](const QByteArray &reply) {
+        const NpFrame response(reply);
+        return response.isValid() && response.addr() == 0x10 && response.cmd() == 0x78;
+    };
+
+    QVector<Dispatcher::Request> requests{measureRequest};
+    if (fetchExposure) {
+        requests.append(Dispatcher::Request(NpFrame(0x10, 0x73)));
+    }
+
+    const auto replies = m_accessor->transaction(requests);
+
+    const NpFrame measureResponse = replies.at(0);
     if (!measureResponse.isValid()
         || measureResponse.addr() != 0x10
         || measureResponse.cmd() != 0x78) {
-        errDevice << "Received response for measured params is invalid:" << measureResponse.toHex();
+        errDevice << "Received response for measured params is invalid:" << replies.at(0).toHex();
         setLastError(tr("Ответ на команду получения измеренных результатов отсутствует или неверный"));
         return false;
     }
 
-    if (currentConfiguration().value(FETCH_EXPOSURE_PARAM).toBool()) {
-        NpFrame exposureRequest(0x10, 0x73);
-        const NpFrame exposureResponse = m_accessor->writeAndRead(exposureRequest);
+    if (fetchExposure) {
+        const NpFrame exposureResponse = replies.at(1);
         if (!exposureResponse.isValid()
             || exposureResponse.addr() != 0x10
             || exposureResponse.cmd() != 0x74) {
-            errDevice << "Received response for exposure param is invalid:" << exposureResponse.toHex();
+            errDevice << "Received response for exposure param is invalid:" << replies.at(1).toHex();
             setLastError(tr("Ответ на команду измеренного времени экспозиции отсутствует или неверный"));
             return false;
         }
@@ -10,5 +10,6 @@ const QString NAME_FIELD_IS_SUCCESS = QStringLiteral("flagIsSuccess");
 const QString NAME_FIELD_TEXT_ERROR = QStringLiteral("textError");
 const QString NAME_FIELD_WIDTH_DETECTOR = QStringLiteral("widthDetectorPx");
 const QString NAME_FIELD_FRAME = QStringLiteral("frame");
+const QString NAME_FIELD_FRAME_SIZE = QStringLiteral("frameSizePx");
 
 #endif // MICDETECTOR_COMMON_H
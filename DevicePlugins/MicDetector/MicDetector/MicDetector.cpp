@@ -1,11 +1,14 @@
 #include "MicDetector.h"
+#include <QCoreApplication>
 #include <QDataStream>
 #include <QProcess>
 
 #include <Device/DeviceLogging.h>
+#include <Device/PixelConversion.h>
 #include <json_rpc_debug_logger.h>
 
 #include "../Common.h"
+#include "../MicFrameChannel.h"
 
 using namespace jcon;
 
@@ -17,6 +20,7 @@ const int DEFAULT_SERVICE_PORT = 11555;
 const QString DETECTOR_CHARGE_TIME = QStringLiteral("main/chargeTime");
 const QString DETECTOR_PIXEL_SIZE = QStringLiteral("main/pixel_size");
 const QString SERVICE_PORT = QStringLiteral("main/service_port");
+const QString SHARED_MEMORY_FRAME = QStringLiteral("main/shared_memory_frame");
 
 const QString LOAD_MIC_LIBRARY_COMMAND = QStringLiteral("loadMicLibrary");
 const QString HARDWARE_INIT_COMMAND = QStringLiteral("hardwareInit");
@@ -24,17 +28,22 @@ const QString HARDWARE_SHUTDOWN_COMMAND = QStringLiteral("hardwareShutdown");
 const QString PREPARE_READING_COMMAND = QStringLiteral("prepareReading");
 const QString READ_HARDWAREINFO_COMMAND = QStringLiteral("readHardwareInfo");
 const QString READ_DATA_COMMAND = QStringLiteral("readData");
+const QString READ_DATA_SHARED_COMMAND = QStringLiteral("readDataShared");
 
 struct MicDetector::PImpl
 {
     QProcess *serviceProcess = nullptr;
     JsonRpcTcpClient *jconClient = nullptr;
+    MicFrameChannel frameChannel;
+    int frameChannelGeneration = 0;
 
     bool startService(QObject* parent, int servicePort);
     void stopService();
 
     bool connectToService(QObject* parent, int servicePort);
     void disconnectFromService();
+
+    bool reserveFrameChannel(int pixels);
 };
 
 bool MicDetector::PImpl::startService(QObject* parent, int servicePort)
@@ -95,14 +104,70 @@ void MicDetector::PImpl::disconnectFromService()
     }
 }
 
+bool MicDetector::PImpl::reserveFrameChannel(int pixels)
+{
+    if (frameChannel.capacity() >= pixels) {
+        return true;
+    }
+
+    // Service stays attached to the old segment, so grown one gets new key
+    const QString key = QStringLiteral("MicDetectorFrame_%1_%2").arg(QCoreApplication::applicationPid())
+                                                               .arg(++frameChannelGeneration);
+    if (!frameChannel.create(key, pixels)) {
+        errDevice << "Failed to create shared memory for frame:" << frameChannel.lastError();
+        return false;
+    }
+
+    return true;
+}
+
 bool MicDetector::prepareDetector(int linesCount, qreal chargeTime)
 {
+    if (currentConfiguration().value(SHARED_MEMORY_FRAME).toBool() &&
+        !m_pimpl->reserveFrameChannel(linesCount * properties().width)) {
+        setLastError(tr("Не удалось выделить разделяемую память для снимка"));
+        return false;
+    }
+
     QVariantMap data;
     return callFunctionDetector(PREPARE_READING_COMMAND, data, linesCount, chargeTime);
 }
 
+bool MicDetector::readSharedFrameDetector(Frame &frame)
+{
+    QVariantMap responseData;
+    if (!callFunctionDetector(READ_DATA_SHARED_COMMAND, responseData, m_pimpl->frameChannel.key())) {
+        return false;
+    }
+
+    int pixels = 0;
+    const ushort *data = m_pimpl->frameChannel.beginRead(pixels);
+    if (!data) {
+        errDevice << "Failed to read frame from shared memory:" << m_pimpl->frameChannel.lastError();
+        return false;
+    }
+
+    infoDevice << "Frame size" << pixels;
+
+    if (pixels != responseData.value(NAME_FIELD_FRAME_SIZE).toInt()) {
+        errDevice << "Frame size mismatch";
+        m_pimpl->frameChannel.endRead();
+        return false;
+    }
+
+    frame = framePool().acquire(pixels);
+    PixelConversion::toFloat(data, frame.data(), pixels);
+    m_pimpl->frameChannel.endRead();
+
+    return !frame.isEmpty();
+}
+
 bool MicDetector::readFrameDetector(Frame &frame)
 {
+    if (currentConfiguration().value(SHARED_MEMORY_FRAME).toBool()) {
+        return readSharedFrameDetector(frame);
+    }
+
     QVariantMap responseData;
     if (callFunctionDetector(READ_DATA_COMMAND, responseData)) {
         QByteArray stringScan = responseData.value(NAME_FIELD_FRAME).toByteArray();
@@ -245,6 +310,7 @@ void MicDetector::doClose()
 
     m_pimpl->disconnectFromService();
     m_pimpl->stopService();
+    m_pimpl->frameChannel.detach();
 }
 
 bool MicDetector::doPrepare()
@@ -279,5 +345,7 @@ DeviceConfiguration MicDetector::defaultConfiguration() const
     conf.insert(DETECTOR_PIXEL_SIZE, DEFAULT_PIXEL_SIZE, tr("Размер пикселя, мм [>0.0]"));
     conf.insert(SERVICE_PORT, DEFAULT_SERVICE_PORT, tr("Номер порта, который используется для связи "
                                                        "с сервисом детектора"));
+    conf.insert(SHARED_MEMORY_FRAME, false, tr("Передача снимка от сервиса детектора "
+                                              "через разделяемую память"));
     return conf;
 }
@@ -28,6 +28,7 @@ private:
     bool callFunctionDetector(QString nameCommand);
     bool prepareDetector(int linesCount, qreal chargeTime);
     bool readFrameDetector(Frame &frame);
+    bool readSharedFrameDetector(Frame &frame);
     bool processResponse(std::shared_ptr<jcon::JsonRpcResult> response,
                             QString nameCommand,
                             QVariantMap &data);
@@ -5,10 +5,12 @@ TARGET = $$qtLibraryTarget(MicDetector)
 QT += network
 
 HEADERS += \
+    ../MicFrameChannel.h \
     MicDetector.h \
     MicDetectorPlugin.h
 
 SOURCES += \
+    ../MicFrameChannel.cpp \
     MicDetector.cpp \
     MicDetectorPlugin.cpp
 
@@ -50,6 +50,29 @@ QVariantMap DetectorService::readData()
     return map;
 }
 
+QVariantMap DetectorService::readDataShared(QString key)
+{
+    // Channel stays attached until plugin grows segment under new key
+    if (!m_frameChannel.attach(key)) {
+        qCritical() << "Failed to attach shared memory" << key << m_frameChannel.lastError();
+        QVariantMap map;
+        map[NAME_FIELD_IS_SUCCESS] = false;
+        map[NAME_FIELD_TEXT_ERROR] = tr("Не удалось подключиться к разделяемой памяти снимка");
+        return map;
+    }
+
+    bool isSuccess = m_detector->readData(m_frameChannel);
+    QVariantMap map = prepareAnswer(isSuccess);
+    if (isSuccess) {
+        int pixels = 0;
+        if (m_frameChannel.beginRead(pixels)) {
+            m_frameChannel.endRead();
+        }
+        map[NAME_FIELD_FRAME_SIZE] = pixels;
+    }
+    return map;
+}
+
 QVariantMap DetectorService::hardwareShutdown()
 {
     return prepareAnswer(m_detector->hardwareShutdown());
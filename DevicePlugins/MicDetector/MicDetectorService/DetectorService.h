@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QVariantMap>
 #include "MicDetectorWrapper.h"
+#include "../MicFrameChannel.h"
 
 class DetectorService : public QObject
 {
@@ -15,9 +16,15 @@ public:
     Q_INVOKABLE QVariantMap prepareReading(int linesCount, qreal chargeTime);
     Q_INVOKABLE QVariantMap readHardwareInfo();
     Q_INVOKABLE QVariantMap readData();
+    /**
+     * Frame is written into shared memory segment created
+     * by plugin, only its size is returned
+     **/
+    Q_INVOKABLE QVariantMap readDataShared(QString key);
     Q_INVOKABLE QVariantMap hardwareShutdown();
 private:
     MicDetectorWrapper *m_detector;
+    MicFrameChannel m_frameChannel;
     QVariantMap prepareAnswer(bool isSuccess) const;
 };
 
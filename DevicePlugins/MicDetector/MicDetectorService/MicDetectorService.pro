@@ -8,11 +8,13 @@ CONFIG += console
 TARGET = MicDetectorService/$$qtLibraryTarget(MicDetectorService)
 
 SOURCES += \
+    ../MicFrameChannel.cpp \
     DetectorService.cpp \
     MicDetectorWrapper.cpp \
     main.cpp
 
 HEADERS += \
+    ../MicFrameChannel.h \
     DetectorService.h \
     MicDetectorWrapper.h \
     mic.h
@@ -4,6 +4,7 @@
 #include <QDebug>
 
 #include "mic.h"
+#include "../MicFrameChannel.h"
 
 namespace {
     typedef WORD (*HardwareInit_)(char*, WORD);
@@ -44,6 +45,7 @@ struct MicDetectorWrapper::PImpl
     }
 
     bool checkInitDetector();
+    bool readData(WORD *buffer, ushort &realReadLines);
 };
 
 MicDetectorWrapper::MicDetectorWrapper(QObject *parent): QObject(parent),
@@ -165,11 +167,8 @@ bool MicDetectorWrapper::readData(MicFrame &frame)
     }
 
     MicFrame buffFrame(m_pimpl->widthPx * m_pimpl->prepareLinesCount);
-    ushort realReadLines = m_pimpl->fReadData(buffFrame.data(), m_pimpl->widthPx, m_pimpl->prepareLinesCount);
-    bool isErrorClose = m_pimpl->fCloseReading(buffFrame.data(), m_pimpl->widthPx, realReadLines, true);
-    if (!isErrorClose || m_pimpl->prepareLinesCount < realReadLines || !realReadLines) {
-        m_pimpl->prepareLinesCount = 0;
-        m_pimpl->lastError = tr("Ошибка получения данных");
+    ushort realReadLines = 0;
+    if (!m_pimpl->readData(buffFrame.data(), realReadLines)) {
         return false;
     }
 
@@ -183,6 +182,33 @@ bool MicDetectorWrapper::readData(MicFrame &frame)
     return true;
 }
 
+bool MicDetectorWrapper::readData(MicFrameChannel &channel)
+{
+    if (!m_pimpl->checkInitDetector()) {
+        return false;
+    }
+
+    if (!m_pimpl->prepareLinesCount) {
+        m_pimpl->lastError = tr("Высота снимка равна 0 строк");
+        return false;
+    }
+
+    ushort *buffer = channel.beginWrite(m_pimpl->widthPx * m_pimpl->prepareLinesCount);
+    if (!buffer) {
+        qCritical() << "Failed to write frame to shared memory:" << channel.lastError();
+        m_pimpl->prepareLinesCount = 0;
+        m_pimpl->lastError = tr("Ошибка записи снимка в разделяемую память");
+        return false;
+    }
+
+    ushort realReadLines = 0;
+    const bool success = m_pimpl->readData(buffer, realReadLines);
+    channel.endWrite(success ? realReadLines * m_pimpl->widthPx : 0);
+
+    m_pimpl->prepareLinesCount = 0;
+    return success;
+}
+
 QString MicDetectorWrapper::lastError()
 {
     return m_pimpl->lastError;
@@ -196,3 +222,16 @@ bool MicDetectorWrapper::PImpl::checkInitDetector()
     }
     return true;
 }
+
+bool MicDetectorWrapper::PImpl::readData(WORD *buffer, ushort &realReadLines)
+{
+    realReadLines = fReadData(buffer, widthPx, prepareLinesCount);
+    bool isErrorClose = fCloseReading(buffer, widthPx, realReadLines, true);
+    if (!isErrorClose || prepareLinesCount < realReadLines || !realReadLines) {
+        prepareLinesCount = 0;
+        lastError = MicDetectorWrapper::tr("Ошибка получения данных");
+        return false;
+    }
+
+    return true;
+}
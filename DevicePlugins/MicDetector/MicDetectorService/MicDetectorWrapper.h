@@ -5,6 +5,8 @@
 
 #include "../Common.h"
 
+class MicFrameChannel;
+
 class MicDetectorWrapper: public QObject
 {
     Q_OBJECT
@@ -21,6 +23,10 @@ public:
     bool hardwareShutdown();
     bool prepareReading(const ushort linesCount, const float chargeTimeMs);
     bool readData(MicFrame &frame);
+    /**
+     * Reads frame right into shared memory of channel
+     **/
+    bool readData(MicFrameChannel &channel);
     QString lastError();
 private:
     struct PImpl;
@@ -0,0 +1,131 @@
+#include "MicFrameChannel.h"
+
+MicFrameChannel::MicFrameChannel()
+{
+
+}
+
+MicFrameChannel::~MicFrameChannel()
+{
+    detach();
+}
+
+bool MicFrameChannel::create(const QString &key, int pixels)
+{
+    detach();
+
+    const int size = static_cast<int>(sizeof(Header)) + pixels * static_cast<int>(sizeof(ushort));
+
+    m_memory.setKey(key);
+    if (!m_memory.create(size)) {
+        m_lastError = m_memory.errorString();
+        return false;
+    }
+
+    header()->pixels = 0;
+    header()->reserved = 0;
+
+    return true;
+}
+
+bool MicFrameChannel::attach(const QString &key)
+{
+    if (m_memory.isAttached() && m_memory.key() == key) {
+        return true;
+    }
+
+    detach();
+
+    m_memory.setKey(key);
+    if (!m_memory.attach()) {
+        m_lastError = m_memory.errorString();
+        return false;
+    }
+
+    if (m_memory.size() < static_cast<int>(sizeof(Header))) {
+        m_lastError = QStringLiteral("Shared memory segment is too small");
+        detach();
+        return false;
+    }
+
+    return true;
+}
+
+void MicFrameChannel::detach()
+{
+    if (m_memory.isAttached()) {
+        m_memory.detach();
+    }
+}
+
+QString MicFrameChannel::key() const
+{
+    return m_memory.key();
+}
+
+int MicFrameChannel::capacity() const
+{
+    if (!m_memory.isAttached()) {
+        return 0;
+    }
+
+    return (m_memory.size() - static_cast<int>(sizeof(Header))) / static_cast<int>(sizeof(ushort));
+}
+
+QString MicFrameChannel::lastError() const
+{
+    return m_lastError;
+}
+
+ushort *MicFrameChannel::beginWrite(int pixels)
+{
+    if (pixels > capacity()) {
+        m_lastError = QStringLiteral("Frame of %1 pixels does not fit shared memory").arg(pixels);
+        return nullptr;
+    }
+
+    if (!m_memory.lock()) {
+        m_lastError = m_memory.errorString();
+        return nullptr;
+    }
+
+    header()->pixels = 0;
+    return data();
+}
+
+void MicFrameChannel::endWrite(int pixels)
+{
+    header()->pixels = static_cast<quint32>(qBound(0, pixels, capacity()));
+    m_memory.unlock();
+}
+
+const ushort *MicFrameChannel::beginRead(int &pixels)
+{
+    if (!m_memory.isAttached()) {
+        m_lastError = QStringLiteral("Shared memory is not attached");
+        return nullptr;
+    }
+
+    if (!m_memory.lock()) {
+        m_lastError = m_memory.errorString();
+        return nullptr;
+    }
+
+    pixels = qMin(static_cast<int>(header()->pixels), capacity());
+    return data();
+}
+
+void MicFrameChannel::endRead()
+{
+    m_memory.unlock();
+}
+
+MicFrameChannel::Header *MicFrameChannel::header() const
+{
+    return static_cast<Header *>(const_cast<void *>(m_memory.constData()));
+}
+
+ushort *MicFrameChannel::data() const
+{
+    return reinterpret_cast<ushort *>(header() + 1);
+}
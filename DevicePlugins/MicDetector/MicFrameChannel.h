@@ -0,0 +1,49 @@
+#ifndef MICDETECTOR_MICFRAMECHANNEL_H
+#define MICDETECTOR_MICFRAMECHANNEL_H
+
+#include <QSharedMemory>
+#include <QString>
+
+/**
+ * Frame transfer from MicDetectorService to MicDetector plugin through
+ * shared memory segment. Segment is created by plugin, service attaches
+ * to it by key and detector library writes pixels right into it
+ **/
+class MicFrameChannel
+{
+    Q_DISABLE_COPY(MicFrameChannel)
+public:
+    MicFrameChannel();
+    ~MicFrameChannel();
+
+    bool create(const QString &key, int pixels);
+    bool attach(const QString &key);
+    void detach();
+
+    QString key() const;
+    int capacity() const;
+    QString lastError() const;
+
+    /**
+     * Segment stays locked between begin and end calls.
+     * Null is returned on error
+     **/
+    ushort *beginWrite(int pixels);
+    void endWrite(int pixels);
+    const ushort *beginRead(int &pixels);
+    void endRead();
+private:
+    struct Header
+    {
+        quint32 pixels;
+        quint32 reserved;
+    };
+
+    Header *header() const;
+    ushort *data() const;
+
+    QSharedMemory m_memory;
+    QString m_lastError;
+};
+
+#endif // MICDETECTOR_MICFRAMECHANNEL_H
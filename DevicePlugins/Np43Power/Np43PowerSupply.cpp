@@ -166,6 +166,9 @@ bool Np43PowerSupply::doOpen()
         return false;
     }
 
+    m_pimpl->m_accessorPower->setPriority(Dispatcher::Priority_Control);
+    m_pimpl->m_accessorPower->setDeadlineMs(Dispatcher::controlDeadlineMs);
+
     QString path = currentConfiguration().value(PATH_FILE_WITH_TABLE_CURRENT_FILAMENT_TUBE).toString();
     if (!QFile::exists(path)) {
         path = QStringLiteral(":/rentgen.wrd");
@@ -193,10 +196,11 @@ bool Np43PowerSupply::doTestConnection()
     QElapsedTimer timer;
     timer.start();
     while (TIMEOUT_TEST_CONNECTION >= timer.elapsed()) {
-        const NpFrame pingResponse = m_pimpl->m_accessorPower->writeAndRead(pingRequest);
+        const QByteArray pingReply = m_pimpl->m_accessorPower->writeAndRead(pingRequest);
+        const NpFrame pingResponse = pingReply;
         if (pingResponse != pingRightResponse) {
             errDevice << "Test connection:"
-                      << "Ping response:" << pingResponse.toHex()
+                      << "Ping response:" << pingReply.toHex()
                       << "Expected first" << NpFrame::size << "bytes:" << pingRightResponse.toHex();
         } else {
             return true;
@@ -256,7 +260,20 @@ bool Np43PowerSupply::doPrepare()
     NpFrame pushPrepareButton(0x25, 0xAD);
     NpFrame prepareRightResponse(0x10, 0xAE);
     m_pimpl->m_accessorBku->write(pushPrepareButton);
-    const NpFrame pushPrepareResponse = m_pimpl->m_accessorPower->read(MAX_TIME_PREPARE_MS);
+
+    // Prepare response is sent by power supply after BKU button press, state
+    // is queried in the same bus hold so other devices don't delay it,
+    // but only after right prepare response
+    Dispatcher::Request prepareRequest(QByteArray(), true, MAX_TIME_PREPARE_MS);
+    prepareRequest.validator = [prepareRightResponse](const QByteArray &reply) {
+        return NpFrame(reply) == prepareRightResponse;
+    };
+
+    NpFrame stateCommand(0x10, 0x4D);
+    const auto prepareReplies = m_pimpl->m_accessorPower->transaction({prepareRequest,
+                                                                       Dispatcher::Request(stateCommand)});
+
+    const NpFrame pushPrepareResponse = prepareReplies.at(0);
     if (pushPrepareResponse != prepareRightResponse) {
         QString error;
         if (pushPrepareResponse.isValid() &&
@@ -264,19 +281,18 @@ bool Np43PowerSupply::doPrepare()
             setLastError(error);
         } else {
             errDevice << "Prepare:"
-                      << "Response is invalid:" << pushPrepareResponse.toHex();
+                      << "Response is invalid:" << prepareReplies.at(0).toHex();
             setLastError(tr("Ответ на команду установки параметров неверный или отсутствует"));
         }
         return false;
     }
 
-    NpFrame stateCommand(0x10, 0x4D);
-    const NpFrame stateResponse = m_pimpl->m_accessorPower->writeAndRead(stateCommand);
+    const NpFrame stateResponse = prepareReplies.at(1);
     if (!stateResponse.isValid()
         || stateResponse.addr() != 0x10
         || stateResponse.cmd() != 0x5D) {
         errDevice << "Prepare:"
-                  << "Response is invalid:" << stateResponse.toHex();
+                  << "Response is invalid:" << prepareReplies.at(1).toHex();
         setLastError(tr("Ответ на запрос состояния РПУ неверный или отсутствует"));
         return false;
     }
@@ -308,11 +324,13 @@ bool Np43PowerSupply::doWaitForError()
     int timeout = MAX_TIME_WAIT_RESULT_SCAN_MS + currentParams().exposureMs;
     while (timeout >= timer.elapsed()) {
         NpFrame stateAnswer(0x10, 0x4D);
-        const auto stateResponse = m_pimpl->m_accessorPower->writeAndRead(stateAnswer);
-        for (const auto &response: NpFrame::splitFrames(stateResponse)) {
+        const auto stateResponse = m_pimpl->m_accessorPower->writeAndRead(stateAnswer, 1000, Dispatcher::Read_Burst);
+        NpFrameReader reader(stateResponse);
+        while (reader.hasNext()) {
+            const NpFrame response = reader.next();
             if (!response.isValid()) {
                 errDevice << "Wait for error:"
-                          << "Response is invalid:" << response.toHex();
+                          << "Response is invalid:" << stateResponse.toHex();
                 setLastError(tr("Ответ на команду запроса состояния неверная или отсуствует"));
                 return true;
             }
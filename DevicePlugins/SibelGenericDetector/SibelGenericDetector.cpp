@@ -78,6 +78,10 @@ bool SibelGenericDetector::doOpen()
     }
 
     m_pimpl.reset(tmp.take());
+    m_pimpl->setBufferPools(&framePool(), &rawBufferPool());
+
+    connect(m_pimpl.data(), &SibelGenericDetectorPrivate::linesDecoded,
+            this, &SibelGenericDetector::setCapturedLines, Qt::DirectConnection);
 
     if (!m_pimpl->open()) {
         setLastError(m_pimpl->lastError());
@@ -118,6 +122,11 @@ bool SibelGenericDetector::doTestConnection()
 
 bool SibelGenericDetector::doPrepare()
 {
+    // Geometry correction moves pixels between lines
+    // so streamed lines would differ from the frame
+    const bool correction = currentConfiguration().value(CORRECTION).toInt();
+    m_pimpl->setStreamBlockLines(correction ? 0 : static_cast<int>(streamBlockLines()));
+
     if (!m_pimpl->prepare(currentLines())) {
         setLastError(m_pimpl->lastError());
         return false;
@@ -175,12 +184,12 @@ bool SibelGenericDetector::doCapture()
                     }
                 }
 
-                data = data.mid(width * (batches - 1));
+                data.remove(0, width * (batches - 1));
             }
         }
     }
 
-    setLastCapturedFrame(Frame(data));
+    setLastCapturedFrame(data);
     return true;
 }
 
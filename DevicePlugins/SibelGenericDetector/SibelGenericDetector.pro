@@ -5,12 +5,14 @@ TARGET = $$qtLibraryTarget(SibelGenericDetector)
 HEADERS += \
     SibelGenericDetector.h \
     SibelGenericDetectorPlugin.h \
-    SibelGenericDetectorPrivate.h
+    SibelGenericDetectorPrivate.h \
+    SibelLineDecoder.h
 
 SOURCES += \
     SibelGenericDetector.cpp \
     SibelGenericDetectorPlugin.cpp \
-    SibelGenericDetectorPrivate.cpp
+    SibelGenericDetectorPrivate.cpp \
+    SibelLineDecoder.cpp
 
 DISTFILES += \
     SibelGenericDetector.json
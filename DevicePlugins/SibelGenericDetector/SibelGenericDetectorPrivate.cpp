@@ -61,7 +61,11 @@ SibelGenericDetectorPrivate::SibelGenericDetectorPrivate(int width, int batches,
     m_bufferSize(defaultBufferSize),
     m_frequency(0),
     m_linesCount(0),
-    m_snapshotSize(0)
+    m_snapshotSize(0),
+    m_streamBlockLines(0),
+    m_decodedLines(0),
+    m_framePool(nullptr),
+    m_rawBufferPool(nullptr)
 {
 
 }
@@ -217,7 +221,15 @@ bool SibelGenericDetectorPrivate::prepare(int linesCount)
 
     m_linesCount = linesCount;
     m_snapshotSize = static_cast<uint>(m_linesCount * width() * depth());
-    m_snapshot.reset(new uchar[m_snapshotSize]);
+    Q_ASSERT(m_framePool && m_rawBufferPool);
+    if (m_snapshot.capacity() >= static_cast<int>(m_snapshotSize)) {
+        m_snapshot.resize(static_cast<int>(m_snapshotSize));
+    } else {
+        m_rawBufferPool->recycle(std::move(m_snapshot));
+        m_snapshot = m_rawBufferPool->acquire(static_cast<int>(m_snapshotSize));
+    }
+
+    m_decoder.setGeometry(width(), m_batches);
 
     return true;
 }
@@ -343,6 +355,9 @@ bool SibelGenericDetectorPrivate::takeSnapshot()
     uint emptyReadCounter = 0;
     uint totalReceivedBytes = 0;
 
+    m_frame = m_framePool->acquire(width() * m_linesCount);
+    m_decodedLines = 0;
+
     while (totalReceivedBytes < m_snapshotSize) {
         DWORD receivedBytes = 0;
         FtError e = FT_Read(m_handle, m_snapshot.data() + totalReceivedBytes,
@@ -354,6 +369,10 @@ bool SibelGenericDetectorPrivate::takeSnapshot()
 
         totalReceivedBytes += receivedBytes;
 
+        if (m_streamBlockLines > 0) {
+            decodeStreamBlocks(totalReceivedBytes);
+        }
+
         if (!receivedBytes) {            
             if (++emptyReadCounter >= maxEmptyFtRead) {
                 break;
@@ -372,25 +391,54 @@ bool SibelGenericDetectorPrivate::takeSnapshot()
     return true;
 }
 
-QVector<float> SibelGenericDetectorPrivate::decodeSnapshot() const
+QVector<float> SibelGenericDetectorPrivate::decodeSnapshot()
 {
-    const int width = this->width();
-
-    QVector<float> output;
-    output.reserve(width * m_linesCount);
+    m_frame.resize(width() * m_linesCount);
 
-    auto pixels = reinterpret_cast<const ushort *>(m_snapshot.data());
-    for (int i = m_linesCount - 1; i >= 0; --i) {
-        for (int j = 0; j < m_batches; ++j) {
-            for (int k = 0, matrixSize = width / m_batches; k < matrixSize; ++k) {
-                output.append(pixels[width * i + k * m_batches + j]);
-            }
-        }
+    if (m_decodedLines < m_linesCount) {
+        decodeLines(m_decodedLines, m_linesCount - m_decodedLines, m_frame.data());
     }
 
+    m_decodedLines = 0;
+
+    QVector<float> output;
+    output.swap(m_frame);
     return output;
 }
 
+void SibelGenericDetectorPrivate::setStreamBlockLines(int lines)
+{
+    m_streamBlockLines = qMax(0, lines);
+}
+
+void SibelGenericDetectorPrivate::setBufferPools(BufferPool<float> *framePool,
+                                                 BufferPool<uchar> *rawBufferPool)
+{
+    m_framePool = framePool;
+    m_rawBufferPool = rawBufferPool;
+}
+
+void SibelGenericDetectorPrivate::decodeLines(int firstRawLine, int rawLines, float *output)
+{
+    m_decoder.decode(m_snapshot.constData(), m_linesCount, firstRawLine, rawLines, output);
+}
+
+void SibelGenericDetectorPrivate::decodeStreamBlocks(uint receivedBytes)
+{
+    const int width = this->width();
+    const int receivedLines = static_cast<int>(receivedBytes / static_cast<uint>(width * depth()));
+
+    while (receivedLines - m_decodedLines >= m_streamBlockLines ||
+           (receivedLines == m_linesCount && m_decodedLines < m_linesCount)) {
+        const int lines = qMin(m_streamBlockLines, receivedLines - m_decodedLines);
+        decodeLines(m_decodedLines, lines, m_frame.data());
+        m_decodedLines += lines;
+
+        const int firstLine = m_linesCount - m_decodedLines;
+        emit linesDecoded(firstLine, m_frame.mid(firstLine * width, lines * width));
+    }
+}
+
 bool SibelGenericDetectorPrivate::setLatency(int value)
 {
     if (value < minLatency || value > maxLatency) {
@@ -6,8 +6,11 @@
 #include <QScopedArrayPointer>
 #include <QObject>
 
+#include <Device/BufferPool.h>
 #include <ftdi/ftd2xx.h>
 
+#include "SibelLineDecoder.h"
+
 class SibelGenericDetectorPrivate: public QObject
 {
     Q_OBJECT
@@ -36,8 +39,14 @@ public:
     bool testConnection();
 
     bool prepare(int linesCount);
+    /**
+     * If stream block lines is set, lines are decoded by blocks
+     * while snapshot is received and linesDecoded() is emitted
+     **/
     bool takeSnapshot();
-    virtual QVector<float> decodeSnapshot() const;
+    QVector<float> decodeSnapshot();
+    void setStreamBlockLines(int lines);
+    void setBufferPools(BufferPool<float> *framePool, BufferPool<uchar> *rawBufferPool);
 
     virtual int width() const { return m_width; }
     virtual int batches() const { return m_batches; }
@@ -50,6 +59,8 @@ public:
     bool setConfiguration(const Configuration &conf);
     bool setLatency(int value);
     bool setBufferSize(int value);
+signals:
+    void linesDecoded(int firstLine, QVector<float> lines);
 protected:
     explicit SibelGenericDetectorPrivate(int width, int batches, int depth, int bitsForLinesCount,
                                          const QSizeF &pixelSize, QObject *parent = nullptr);
@@ -57,13 +68,15 @@ protected:
     const Configuration &configuration() const;
     qreal frequency() const;
     int linesCount() const { return m_linesCount; }
-    const uchar *snapshot() const { return m_snapshot.data(); }
+    const uchar *snapshot() const { return m_snapshot.constData(); }
 private:
     void setLastError(const QString &error) { m_lastError = error; }
     bool writeBytes(uchar *buffer, uint size);
     bool setLinesCount(int lines);
     bool startFrame();
     bool serialNumberDetector(QString&);
+    void decodeLines(int firstRawLine, int rawLines, float *output);
+    void decodeStreamBlocks(uint receivedBytes);
 
     int m_width;
     int m_batches;
@@ -77,8 +90,14 @@ private:
     int m_bufferSize;
     float m_frequency;
     int m_linesCount;
-    QScopedArrayPointer<uchar> m_snapshot;
+    QVector<uchar> m_snapshot;
     uint m_snapshotSize;
+    SibelLineDecoder m_decoder;
+    int m_streamBlockLines;
+    QVector<float> m_frame;
+    BufferPool<float> *m_framePool;
+    BufferPool<uchar> *m_rawBufferPool;
+    int m_decodedLines;
     QString m_lastError;
 };
 
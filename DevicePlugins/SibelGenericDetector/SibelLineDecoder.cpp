@@ -0,0 +1,52 @@
+#include "SibelLineDecoder.h"
+
+#include <algorithm>
+
+#include <Device/PixelConversion.h>
+
+SibelLineDecoder::SibelLineDecoder() :
+    m_width(0)
+{
+
+}
+
+void SibelLineDecoder::setGeometry(int width, int batches)
+{
+    m_width = width;
+
+    const int matrixSize = width / batches;
+    m_permutation.resize(batches * matrixSize);
+    for (int j = 0; j < batches; ++j) {
+        for (int k = 0; k < matrixSize; ++k) {
+            m_permutation[j * matrixSize + k] = k * batches + j;
+        }
+    }
+    m_line.resize(m_permutation.size());
+}
+
+int SibelLineDecoder::width() const
+{
+    return m_width;
+}
+
+void SibelLineDecoder::decode(const uchar *snapshot, int linesCount, int firstRawLine, int rawLines, float *frame)
+{
+    const int lineSize = m_permutation.size();
+    const int *permutation = m_permutation.constData();
+    quint16 *line = m_line.data();
+
+    auto pixels = reinterpret_cast<const quint16 *>(snapshot);
+    for (int i = firstRawLine; i < firstRawLine + rawLines; ++i) {
+        const quint16 *raw = pixels + m_width * i;
+        for (int j = 0; j < lineSize; ++j) {
+            line[j] = raw[permutation[j]];
+        }
+
+        float *dst = frame + m_width * (linesCount - 1 - i);
+        PixelConversion::toFloat(line, dst, lineSize);
+
+        // Columns beyond whole batches have no pixels, pooled
+        // frame would keep them from the previous snapshot
+        std::fill(dst + lineSize, dst + m_width, 0.f);
+    }
+}
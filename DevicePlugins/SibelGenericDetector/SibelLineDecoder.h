@@ -0,0 +1,33 @@
+#ifndef SIBELLINEDECODER_H
+#define SIBELLINEDECODER_H
+
+#include <QVector>
+
+/**
+ * Raw snapshot lines of Sibel detector to frame lines.
+ * Doesn't depend on FTDI driver
+ **/
+class SibelLineDecoder final
+{
+public:
+    SibelLineDecoder();
+
+    /**
+     * Pixels of the raw line are interleaved by batches
+     **/
+    void setGeometry(int width, int batches);
+    int width() const;
+
+    /**
+     * Decodes raw lines [firstRawLine, firstRawLine + rawLines) of
+     * snapshot of linesCount lines. Lines are received from the last one.
+     * Columns beyond whole batches are zeroed
+     **/
+    void decode(const uchar *snapshot, int linesCount, int firstRawLine, int rawLines, float *frame);
+private:
+    int m_width;
+    QVector<int> m_permutation;
+    QVector<quint16> m_line;
+};
+
+#endif // SIBELLINEDECODER_H
@@ -8,6 +8,8 @@
 
 #include <Device/DeviceLogging.h>
 
+#include "SslLineConverter.h"
+
 #if defined(Q_OS_WIN32)
 const QString LIBRARY_FILENAME = QStringLiteral("p_dll_udp.dll");
 #elif defined(Q_OS_LINUX)
@@ -24,7 +26,7 @@ const QString MATRIX_COUNT = QStringLiteral("main/matrix_count");
 const QString PIXELS_PER_MATRIX = QStringLiteral("main/pixels_per_matrix");
 const QString JUNK_LINES = QStringLiteral("main/junk_lines");
 const QString FIX_MATRIX_JOINT = QStringLiteral("main/fix_matrix_joint");
-const int SIZE_JOINT_PIXELS = 2;
+const QString STREAM_LINES = QStringLiteral("main/stream_lines");
 
 struct SslDetector::PImpl
 {
@@ -64,20 +66,12 @@ public:
     PutGaneMtrFunc putGaneMtr;
     GetGaneMtrFunc getGaneMtr;
 
-    ushort hardwareWidth;
-    int matrixCount;
-    int pixelsPerMatrix;
-    bool fixesMatrixJoint;
+    SslLineConverter converter;
+    bool streamsLines;
 
     bool loadLibrary();
     void unloadLibrary();
 
-    void convertRawToVector(const char *raw, QVector<float>& vector,
-                            const ushort linesCount) const;
-    ulong calcBufferSize(uint lines) const;
-    int calcResultFrameWidth() const;
-    void fixMatrixJoint(Frame &frame, int linesCount) const;
-
     template <typename T>
     bool resolveFunction(T &ptr, const char *symbol)
     {
@@ -99,55 +93,6 @@ SslDetector::SslDetector(QObject *parent) :
 
 }
 
-ulong SslDetector::PImpl::calcBufferSize(uint lines) const
-{
-    return lines * hardwareWidth * 2;
-}
-
-int SslDetector::PImpl::calcResultFrameWidth() const
-{
-    return hardwareWidth + (fixesMatrixJoint ? SIZE_JOINT_PIXELS * (matrixCount - 1) : 0);
-}
-
-void SslDetector::PImpl::fixMatrixJoint(Frame &frame, int linesCount) const
-{
-    if (!fixesMatrixJoint) {
-        return;
-    }
-
-    int fixFrameWidth = calcResultFrameWidth();
-    Frame fixFrame(fixFrameWidth * linesCount, 0);
-    for (int i = 0; i < hardwareWidth; ++i) {
-        for (int j = 0; j < linesCount; ++j) {
-            int pos = j * fixFrameWidth + i + (i / pixelsPerMatrix) * SIZE_JOINT_PIXELS;
-            fixFrame[pos] = frame[j * hardwareWidth + i];
-        }
-    }
-
-    for (int i = pixelsPerMatrix; i < fixFrameWidth - 1; i += pixelsPerMatrix + SIZE_JOINT_PIXELS) {
-
-        fixFrame[i] = fixFrame[i - 1];
-        fixFrame[i + 1] = fixFrame[i + 2];
-        int lastPixel = (linesCount - 1) * fixFrameWidth + i;
-        fixFrame[lastPixel] = fixFrame[lastPixel - 1];
-        fixFrame[lastPixel + 1] = fixFrame[lastPixel + 2];
-
-        for (int j = 1; j < linesCount - 1; ++j) {
-            int pos = j * fixFrameWidth + i;
-            float count  = 3;
-            fixFrame[pos] = (fixFrame[pos - 1] +
-                             fixFrame[pos - fixFrameWidth - 1] +
-                             fixFrame[pos + fixFrameWidth - 1]) / count;
-            pos++;
-            fixFrame[pos] = (fixFrame[pos + 1] +
-                             fixFrame[pos - fixFrameWidth + 1] +
-                             fixFrame[pos + fixFrameWidth + 1]) / count;
-        }
-    }
-
-    frame = fixFrame;
-}
-
 SslDetector::~SslDetector()
 {
 
@@ -182,41 +127,18 @@ void SslDetector::PImpl::unloadLibrary()
     library.unload();
 }
 
-void SslDetector::PImpl::convertRawToVector(const char *raw, Frame &vector,
-                                            const ushort linesCount) const
-{
-    auto res16b = reinterpret_cast<const quint16 *>(raw);
-
-    vector.clear();
-    vector.reserve(linesCount * hardwareWidth);
-
-    for (int i = linesCount - 1; i >= 0; --i) {
-        for (int k = 0; k < matrixCount; ++k) {
-            for (int j = 0; j < pixelsPerMatrix; ++j) {
-                vector.append(*(res16b + i * hardwareWidth + matrixCount * (pixelsPerMatrix - 1 - j) + k));
-            }
-        }
-    }
-
-    //specifics of detector without checksums (last pixel broken)
-    if (vector.size() >= hardwareWidth) {
-        vector[vector.size() - pixelsPerMatrix] =
-                vector[vector.size() - pixelsPerMatrix - 1];
-    }
-}
-
 bool SslDetector::doOpen()
 {
     auto &cfg = currentConfiguration();
 
-    m_pimpl->matrixCount = cfg.value(MATRIX_COUNT).toInt();
-    if (m_pimpl->matrixCount < 1) {
+    m_pimpl->converter.matrixCount = cfg.value(MATRIX_COUNT).toInt();
+    if (m_pimpl->converter.matrixCount < 1) {
         setLastError(tr("Неподдерживаемое кол-во матриц"));
         return false;
     }
 
-    m_pimpl->pixelsPerMatrix = cfg.value(PIXELS_PER_MATRIX).toInt();
-    if (m_pimpl->pixelsPerMatrix < 1) {
+    m_pimpl->converter.pixelsPerMatrix = cfg.value(PIXELS_PER_MATRIX).toInt();
+    if (m_pimpl->converter.pixelsPerMatrix < 1) {
         setLastError(tr("Неподдерживаемое кол-во пикселей в матрице"));
         return false;
     }
@@ -248,13 +170,14 @@ bool SslDetector::doOpen()
     
     QThread::msleep(2000);
     m_pimpl->setModeRun(cfg.value(TEST_MODE).toBool() ? PImpl::TEST : PImpl::RUN);
-    m_pimpl->hardwareWidth = m_pimpl->getPixelPerString();
+    m_pimpl->converter.hardwareWidth = m_pimpl->getPixelPerString();
 
-    m_pimpl->fixesMatrixJoint = cfg.value(FIX_MATRIX_JOINT).toBool();
+    m_pimpl->converter.fixesMatrixJoint = cfg.value(FIX_MATRIX_JOINT).toBool();
+    m_pimpl->streamsLines = cfg.value(STREAM_LINES).toBool();
 
     Properties props;
     props.chargeTimeMsec = cfg.value(CHARGE_TIME).toReal();
-    props.width = m_pimpl->calcResultFrameWidth();
+    props.width = m_pimpl->converter.calcResultFrameWidth();
     props.pixelSizeMm.setWidth(cfg.value(PIXEL_WIDTH).toDouble());
     props.pixelSizeMm.setHeight(cfg.value(PIXEL_HEIGHT).toDouble());
     setProperties(props);
@@ -277,7 +200,7 @@ bool SslDetector::doPrepare()
 {
     if (auto junkLines = currentConfiguration().value(JUNK_LINES).toUInt()) {
         char *buffer = nullptr;
-        ulong requestedBufferSize = m_pimpl->calcBufferSize(junkLines);
+        ulong requestedBufferSize = m_pimpl->converter.calcBufferSize(junkLines);
         ulong actualBufferSize = m_pimpl->getBuff(&buffer, requestedBufferSize, true);
         if (actualBufferSize != requestedBufferSize) {
             setLastError(tr("Полученое кол-во байт (%1) меньше запрошенного (%2)").arg(actualBufferSize)
@@ -291,20 +214,41 @@ bool SslDetector::doPrepare()
 
 bool SslDetector::doCapture()
 {
-    auto linesCount = currentLines();
-
-    char *buffer = nullptr;
-    ulong requestedBufferSize = m_pimpl->calcBufferSize(linesCount);
-    ulong actualBufferSize = m_pimpl->getBuff(&buffer, requestedBufferSize, true);
-    if (actualBufferSize != requestedBufferSize) {
-        setLastError(tr("Полученое кол-во байт (%1) меньше запрошенного (%2)").arg(actualBufferSize)
-                                                                              .arg(requestedBufferSize));
-        return false;
+    const int linesCount = static_cast<int>(currentLines());
+    const int frameWidth = m_pimpl->converter.calcResultFrameWidth();
+    const bool streams = m_pimpl->streamsLines && streamBlockLines();
+    const int blockLines = streams ? static_cast<int>(streamBlockLines()) : linesCount;
+
+    Frame frame(frameWidth * linesCount, 0);
+    int fixedLine = linesCount;
+    for (int rawLine = 0; rawLine < linesCount; rawLine += blockLines) {
+        const int lines = qMin(blockLines, linesCount - rawLine);
+
+        char *buffer = nullptr;
+        ulong requestedBufferSize = m_pimpl->converter.calcBufferSize(static_cast<uint>(lines));
+        ulong actualBufferSize = m_pimpl->getBuff(&buffer, requestedBufferSize, true);
+        if (actualBufferSize != requestedBufferSize) {
+            setLastError(tr("Полученое кол-во байт (%1) меньше запрошенного (%2)").arg(actualBufferSize)
+                                                                                  .arg(requestedBufferSize));
+            return false;
+        }
+
+        m_pimpl->converter.convertRawLines(buffer, frame, linesCount, rawLine, lines);
+
+        // The first converted line waits for the next block to fix matrix joints
+        const int convertedLine = linesCount - rawLine - lines;
+        const int firstLine = convertedLine > 0 && m_pimpl->converter.fixesMatrixJoint ? convertedLine + 1
+                                                                             : convertedLine;
+        m_pimpl->converter.fixMatrixJoint(frame, linesCount, firstLine, fixedLine - firstLine);
+
+        if (streams && firstLine < fixedLine) {
+            setCapturedLines(static_cast<quint32>(firstLine),
+                             frame.mid(firstLine * frameWidth, (fixedLine - firstLine) * frameWidth));
+        }
+
+        fixedLine = firstLine;
     }
 
-    Frame frame;
-    m_pimpl->convertRawToVector(buffer, frame, linesCount);
-    m_pimpl->fixMatrixJoint(frame, linesCount);
     setLastCapturedFrame(frame);
     return true;
 }
@@ -321,5 +265,6 @@ DeviceConfiguration SslDetector::defaultConfiguration() const
     conf.insert(MATRIX_COUNT, 8, tr("Кол-во матриц [>0"));
     conf.insert(PIXELS_PER_MATRIX, 256, tr("Кол-во пикселей в матрице [>0]"));
     conf.insert(FIX_MATRIX_JOINT, true, tr("Коррекция стыков матриц в детекторе"));
+    conf.insert(STREAM_LINES, false, tr("Чтение строк блоками во время съемки"));
     return conf;
 }
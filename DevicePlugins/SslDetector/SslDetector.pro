@@ -3,11 +3,13 @@ TARGET = $$qtLibraryTarget(SslDetector)
 
 HEADERS += \
     SslDetector.h \
-    SslDetectorPlugin.h
+    SslDetectorPlugin.h \
+    SslLineConverter.h
 
 SOURCES += \
     SslDetector.cpp \
-    SslDetectorPlugin.cpp
+    SslDetectorPlugin.cpp \
+    SslLineConverter.cpp
 
 DISTFILES += \
     SslDetector.json
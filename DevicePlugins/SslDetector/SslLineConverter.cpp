@@ -0,0 +1,81 @@
+#include "SslLineConverter.h"
+
+const int SIZE_JOINT_PIXELS = 2;
+
+SslLineConverter::SslLineConverter() :
+    hardwareWidth(0),
+    matrixCount(1),
+    pixelsPerMatrix(1),
+    fixesMatrixJoint(false)
+{
+
+}
+
+ulong SslLineConverter::calcBufferSize(uint lines) const
+{
+    return lines * hardwareWidth * 2;
+}
+
+int SslLineConverter::calcResultFrameWidth() const
+{
+    return hardwareWidth + (fixesMatrixJoint ? SIZE_JOINT_PIXELS * (matrixCount - 1) : 0);
+}
+
+int SslLineConverter::calcResultColumn(int hardwareColumn) const
+{
+    return hardwareColumn + (fixesMatrixJoint ? (hardwareColumn / pixelsPerMatrix) * SIZE_JOINT_PIXELS : 0);
+}
+
+void SslLineConverter::fixMatrixJoint(QVector<float> &frame, int linesCount, int firstLine, int lines) const
+{
+    if (!fixesMatrixJoint) {
+        return;
+    }
+
+    // Frame lines next to the fixed ones have to be converted
+    const int fixFrameWidth = calcResultFrameWidth();
+    for (int i = pixelsPerMatrix; i < fixFrameWidth - 1; i += pixelsPerMatrix + SIZE_JOINT_PIXELS) {
+        for (int j = firstLine; j < firstLine + lines; ++j) {
+            int pos = j * fixFrameWidth + i;
+            if (j == 0 || j == linesCount - 1) {
+                frame[pos] = frame[pos - 1];
+                frame[pos + 1] = frame[pos + 2];
+                continue;
+            }
+
+            float count  = 3;
+            frame[pos] = (frame[pos - 1] +
+                          frame[pos - fixFrameWidth - 1] +
+                          frame[pos + fixFrameWidth - 1]) / count;
+            pos++;
+            frame[pos] = (frame[pos + 1] +
+                          frame[pos - fixFrameWidth + 1] +
+                          frame[pos + fixFrameWidth + 1]) / count;
+        }
+    }
+}
+
+void SslLineConverter::convertRawLines(const char *raw, QVector<float> &frame, int linesCount,
+                                       int firstRawLine, int rawLines) const
+{
+    auto res16b = reinterpret_cast<const quint16 *>(raw);
+    const int frameWidth = calcResultFrameWidth();
+
+    // Lines are received from the last one
+    for (int i = 0; i < rawLines; ++i) {
+        float *line = frame.data() + (linesCount - 1 - firstRawLine - i) * frameWidth;
+        for (int k = 0; k < matrixCount; ++k) {
+            float *matrix = line + calcResultColumn(k * pixelsPerMatrix);
+            for (int j = 0; j < pixelsPerMatrix; ++j) {
+                matrix[j] = res16b[i * hardwareWidth + matrixCount * (pixelsPerMatrix - 1 - j) + k];
+            }
+        }
+    }
+
+    //specifics of detector without checksums (last pixel broken)
+    if (firstRawLine == 0 && rawLines > 0) {
+        float *line = frame.data() + (linesCount - 1) * frameWidth;
+        line[calcResultColumn(hardwareWidth - pixelsPerMatrix)] =
+                line[calcResultColumn(hardwareWidth - pixelsPerMatrix - 1)];
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef SSLLINECONVERTER_H
+#define SSLLINECONVERTER_H
+
+#include <QVector>
+
+/**
+ * Raw lines of SSL detector to frame lines with optional
+ * gaps at matrix joints. Doesn't depend on vendor library
+ **/
+struct SslLineConverter
+{
+    SslLineConverter();
+
+    ushort hardwareWidth;
+    int matrixCount;
+    int pixelsPerMatrix;
+    bool fixesMatrixJoint;
+
+    void convertRawLines(const char *raw, QVector<float> &frame, int linesCount,
+                         int firstRawLine, int rawLines) const;
+    ulong calcBufferSize(uint lines) const;
+    int calcResultFrameWidth() const;
+    int calcResultColumn(int hardwareColumn) const;
+    void fixMatrixJoint(QVector<float> &frame, int linesCount, int firstLine, int lines) const;
+};
+
+#endif // SSLLINECONVERTER_H
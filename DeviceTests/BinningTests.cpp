@@ -0,0 +1,80 @@
+#include "BinningTests.h"
+
+#include <QtTest>
+
+#include <Device/Binning.h>
+
+#include "TestFrames.h"
+
+namespace {
+    /**
+     * Flipped line is binned from its right edge
+     **/
+    QVector<float> binReference(const QVector<float> &src, int width, int height, int binX, int binY,
+                                bool sum, bool flip)
+    {
+        const int binnedWidth = Binning::binnedSize(width, binX);
+        const int binnedHeight = Binning::binnedSize(height, binY);
+
+        QVector<float> dst(binnedWidth * binnedHeight);
+        for (int by = 0; by < binnedHeight; ++by) {
+            for (int bx = 0; bx < binnedWidth; ++bx) {
+                double value = 0;
+                int count = 0;
+                for (int y = by * binY; y < qMin((by + 1) * binY, height); ++y) {
+                    for (int x = bx * binX; x < qMin((bx + 1) * binX, width); ++x) {
+                        value += src.at(y * width + (flip ? width - 1 - x : x));
+                        ++count;
+                    }
+                }
+                dst[by * binnedWidth + bx] = static_cast<float>(sum ? value : value / count);
+            }
+        }
+
+        return dst;
+    }
+}
+
+void BinningTests::matchesReference_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<int>("binX");
+    QTest::addColumn<int>("binY");
+    QTest::addColumn<bool>("sum");
+    QTest::addColumn<bool>("flip");
+
+    // Factors up to 4 have own kernels, 5 takes generic one
+    const QVector<QPair<int, int>> sizes = {{1, 1}, {7, 5}, {33, 3}, {37, 9}};
+    for (const auto &size : sizes) {
+        for (int binX = 1; binX <= 5; ++binX) {
+            for (int binY = 1; binY <= 3; ++binY) {
+                for (const bool sum : {false, true}) {
+                    for (const bool flip : {false, true}) {
+                        QTest::addRow("%dx%d bin %dx%d%s%s", size.first, size.second, binX, binY,
+                                      sum ? " sum" : "", flip ? " flip" : "")
+                                << size.first << size.second << binX << binY << sum << flip;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void BinningTests::matchesReference()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(int, binX);
+    QFETCH(int, binY);
+    QFETCH(bool, sum);
+    QFETCH(bool, flip);
+
+    const QVector<float> src = TestFrames::make(width, height, 3);
+    QVector<float> dst(Binning::binnedSize(width, binX) * Binning::binnedSize(height, binY));
+    Binning::bin(src.constData(), width, height, binX, binY, sum, flip, dst.data());
+
+    const QByteArray error = TestFrames::mismatch(dst, binReference(src, width, height, binX, binY, sum, flip),
+                                                  TestFrames::tolerance * binX * binY);
+    QVERIFY2(error.isEmpty(), error.constData());
+}
@@ -0,0 +1,18 @@
+#ifndef DEVICETESTS_BINNINGTESTS_H
+#define DEVICETESTS_BINNINGTESTS_H
+
+#include <QObject>
+
+/**
+ * Binning compared with straightforward reference
+ * on sizes leaving partial bins
+ **/
+class BinningTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void matchesReference_data();
+    void matchesReference();
+};
+
+#endif // DEVICETESTS_BINNINGTESTS_H
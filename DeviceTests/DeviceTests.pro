@@ -0,0 +1,38 @@
+QT       -= gui
+QT       += core testlib
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+TEMPLATE  = app
+TARGET    = DeviceTests
+
+include($$PWD/../Global.pri)
+include($$PWD/../Device/Device.pri)
+# Resampler is compared with cv::resize, Device itself doesn't use OpenCV
+include($$PWD/../3rd-party/OpenCV.pri)
+
+HEADERS += \
+    BinningTests.h \
+    DispatcherTests.h \
+    FlatFieldCorrectionTests.h \
+    FrameGeometryTests.h \
+    GainsFileTests.h \
+    LatencyHistogramTests.h \
+    NpFrameTests.h \
+    ResamplerTests.h \
+    StepGraphTests.h \
+    TestFrames.h \
+    TraceTests.h
+
+SOURCES += \
+    BinningTests.cpp \
+    DispatcherTests.cpp \
+    FlatFieldCorrectionTests.cpp \
+    FrameGeometryTests.cpp \
+    GainsFileTests.cpp \
+    LatencyHistogramTests.cpp \
+    NpFrameTests.cpp \
+    ResamplerTests.cpp \
+    StepGraphTests.cpp \
+    TestFrames.cpp \
+    TraceTests.cpp \
+    main.cpp
@@ -0,0 +1,253 @@
+#include "DispatcherTests.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtTest>
+
+#include <NpToolbox/Invoker.h>
+#include <Device/Dispatcher.h>
+#include <Device/NpFrame.h>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+using namespace Nauchpribor;
+
+namespace {
+    const quint8 ADDR = 0x10;
+    const quint8 OTHER_ADDR = 0x20;
+    const quint8 FRAME_INTERVAL_MS = 50;
+    // Reader is in read mode long before first chunk
+    const unsigned long FIRST_CHUNK_DELAY_MS = 200;
+    // Gap between chunks is shorter than frame interval
+    const unsigned long CHUNK_GAP_MS = 10;
+    // Device never replies, so request runs until canceled
+    const quint32 SILENT_REPLY_TIMEOUT_MS = 10000;
+    const qint64 CLOSE_TIMEOUT_MS = 2000;
+    // Single frame reply must not wait for it
+    const quint8 SLOW_FRAME_INTERVAL_MS = 200;
+
+    Dispatcher::Request pingRequest(quint8 addr)
+    {
+        return Dispatcher::Request(NpFrame(addr, 0x01).toByteArray());
+    }
+}
+
+void DispatcherTests::canceledTokenCancelsSubmit()
+{
+    Dispatcher dispatcher;
+    auto accessor = dispatcher.getAccessor(ADDR);
+
+    // Request is dropped before it touches the bus
+    CancelationTokenSource source;
+    source.cancel();
+    QFuture<QByteArray> reply = accessor->submit(pingRequest(ADDR), source.token());
+
+    reply.waitForFinished();
+    QVERIFY(reply.isFinished());
+    QVERIFY(reply.isCanceled());
+}
+
+void DispatcherTests::submitToClosedDispatcherReturnsEmptyReply()
+{
+    Dispatcher dispatcher;
+    auto accessor = dispatcher.getAccessor(ADDR);
+    auto controlAccessor = dispatcher.getAccessor(OTHER_ADDR);
+    controlAccessor->setPriority(Dispatcher::Priority_Control);
+
+    dispatcher.close();
+
+    const QVector<QFuture<QByteArray>> replies = {
+        accessor->submit(pingRequest(ADDR)),
+        controlAccessor->submit(pingRequest(OTHER_ADDR)),
+        accessor->submit(Dispatcher::Request(pingRequest(ADDR).bytes, false))
+    };
+
+    for (auto reply : replies) {
+        reply.waitForFinished();
+        QVERIFY(!reply.isCanceled());
+        QVERIFY(reply.result().isEmpty());
+    }
+}
+
+void DispatcherTests::burstSplitAcrossChunksIsReadWhole()
+{
+#ifdef Q_OS_UNIX
+    const int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    QVERIFY(masterFd >= 0);
+    QVERIFY(grantpt(masterFd) == 0 && unlockpt(masterFd) == 0);
+
+    termios attributes;
+    if (tcgetattr(masterFd, &attributes) == 0) {
+        cfmakeraw(&attributes);
+        tcsetattr(masterFd, TCSANOW, &attributes);
+    }
+
+    QThread dispatcherThread;
+    auto dispatcher = new Dispatcher;
+    dispatcher->moveToThread(&dispatcherThread);
+    QObject::connect(&dispatcherThread, &QThread::finished, dispatcher, &QObject::deleteLater);
+    dispatcherThread.start();
+
+    Dispatcher::Params params;
+    params.portName = QString::fromLocal8Bit(ptsname(masterFd));
+    params.softwareLineControl = true;
+    params.frameIntervalMs = FRAME_INTERVAL_MS;
+    params.statisticsLogIntervalMs = 0;
+
+    auto accessor = dispatcher->getAccessor(ADDR);
+    const bool opened = Toolbox::Invoker::run(dispatcher, &Dispatcher::open, params).result();
+
+    // Status burst ends with error frame which follows in the next read chunk
+    const NpFrame statusFrame(ADDR, 0x1E, 0x10, 0x20);
+    const NpFrame errorFrame(ADDR, 0x71, 0x00);
+
+    QByteArray reply;
+    if (opened) {
+        QScopedPointer<QThread> device(QThread::create([masterFd, statusFrame, errorFrame] {
+            QThread::msleep(FIRST_CHUNK_DELAY_MS);
+            ::write(masterFd, statusFrame.toByteArray().constData(), NpFrame::size);
+            QThread::msleep(CHUNK_GAP_MS);
+            ::write(masterFd, errorFrame.toByteArray().constData(), NpFrame::size);
+        }));
+        device->start();
+
+        reply = accessor->read(1000, Dispatcher::Read_Burst);
+        device->wait();
+    }
+
+    Toolbox::Invoker::run(dispatcher, &Dispatcher::close).waitForFinished();
+    dispatcherThread.quit();
+    dispatcherThread.wait();
+    ::close(masterFd);
+
+    QVERIFY(opened);
+    QCOMPARE(reply, statusFrame.toByteArray() + errorFrame.toByteArray());
+    QCOMPARE(NpFrameReader(reply).last(), errorFrame);
+#else
+    QSKIP("Pseudo-terminal is required");
+#endif
+}
+
+void DispatcherTests::closeCancelsRunningRequest()
+{
+#ifdef Q_OS_UNIX
+    const int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    QVERIFY(masterFd >= 0);
+    QVERIFY(grantpt(masterFd) == 0 && unlockpt(masterFd) == 0);
+
+    QThread dispatcherThread;
+    auto dispatcher = new Dispatcher;
+    dispatcher->moveToThread(&dispatcherThread);
+    QObject::connect(&dispatcherThread, &QThread::finished, dispatcher, &QObject::deleteLater);
+    dispatcherThread.start();
+
+    Dispatcher::Params params;
+    params.portName = QString::fromLocal8Bit(ptsname(masterFd));
+    params.softwareLineControl = true;
+    params.statisticsLogIntervalMs = 0;
+
+    auto accessor = dispatcher->getAccessor(ADDR);
+    const bool opened = Toolbox::Invoker::run(dispatcher, &Dispatcher::open, params).result();
+
+    QFuture<QByteArray> reply;
+    qint64 closeMs = 0;
+    if (opened) {
+        reply = accessor->submit(Dispatcher::Request(pingRequest(ADDR).bytes, true, SILENT_REPLY_TIMEOUT_MS));
+        QThread::msleep(FIRST_CHUNK_DELAY_MS);
+
+        // Close waits for running request without dispatcher thread event loop
+        QElapsedTimer timer;
+        timer.start();
+        Toolbox::Invoker::run(dispatcher, &Dispatcher::close).waitForFinished();
+        closeMs = timer.elapsed();
+        reply.waitForFinished();
+    }
+
+    dispatcherThread.quit();
+    dispatcherThread.wait();
+    ::close(masterFd);
+
+    QVERIFY(opened);
+    QVERIFY(closeMs < CLOSE_TIMEOUT_MS);
+    QVERIFY(reply.result().isEmpty());
+#else
+    QSKIP("Pseudo-terminal is required");
+#endif
+}
+
+void DispatcherTests::singleFrameReplyDoesNotWaitForSilence()
+{
+#ifdef Q_OS_UNIX
+    const int masterFd = posix_openpt(O_RDWR | O_NOCTTY);
+    QVERIFY(masterFd >= 0);
+    QVERIFY(grantpt(masterFd) == 0 && unlockpt(masterFd) == 0);
+
+    termios attributes;
+    if (tcgetattr(masterFd, &attributes) == 0) {
+        cfmakeraw(&attributes);
+        tcsetattr(masterFd, TCSANOW, &attributes);
+    }
+
+    QThread dispatcherThread;
+    auto dispatcher = new Dispatcher;
+    dispatcher->moveToThread(&dispatcherThread);
+    QObject::connect(&dispatcherThread, &QThread::finished, dispatcher, &QObject::deleteLater);
+    dispatcherThread.start();
+
+    Dispatcher::Params params;
+    params.portName = QString::fromLocal8Bit(ptsname(masterFd));
+    params.softwareLineControl = true;
+    params.writeDelayMs = 0;
+    params.writePauseMs = 0;
+    params.modeSwitchDelayMs = 0;
+    params.frameIntervalMs = SLOW_FRAME_INTERVAL_MS;
+    params.statisticsLogIntervalMs = 0;
+
+    auto accessor = dispatcher->getAccessor(ADDR);
+    const bool opened = Toolbox::Invoker::run(dispatcher, &Dispatcher::open, params).result();
+
+    const NpFrame request(ADDR, 0x01);
+    const NpFrame answer(ADDR, 0x01, 0x55);
+
+    QByteArray reply;
+    qint64 replyMs = 0;
+    if (opened) {
+        // Device answers as soon as request is read
+        QScopedPointer<QThread> device(QThread::create([masterFd, answer] {
+            char bytes[NpFrame::size];
+            qint64 received = 0;
+            while (received < NpFrame::size) {
+                const ssize_t count = ::read(masterFd, bytes + received, static_cast<size_t>(NpFrame::size - received));
+                if (count <= 0) {
+                    return;
+                }
+                received += count;
+            }
+            ::write(masterFd, answer.toByteArray().constData(), NpFrame::size);
+        }));
+        device->start();
+
+        QElapsedTimer timer;
+        timer.start();
+        reply = accessor->writeAndRead(request, 1000);
+        replyMs = timer.elapsed();
+        device->wait();
+    }
+
+    Toolbox::Invoker::run(dispatcher, &Dispatcher::close).waitForFinished();
+    dispatcherThread.quit();
+    dispatcherThread.wait();
+    ::close(masterFd);
+
+    QVERIFY(opened);
+    QCOMPARE(reply, answer.toByteArray());
+    QVERIFY(replyMs < SLOW_FRAME_INTERVAL_MS);
+#else
+    QSKIP("Pseudo-terminal is required");
+#endif
+}
@@ -0,0 +1,21 @@
+#ifndef DEVICETESTS_DISPATCHERTESTS_H
+#define DEVICETESTS_DISPATCHERTESTS_H
+
+#include <QObject>
+
+/**
+ * Submitted requests which finish without serial port
+ * and replies read from pseudo-terminal
+ **/
+class DispatcherTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void canceledTokenCancelsSubmit();
+    void submitToClosedDispatcherReturnsEmptyReply();
+    void burstSplitAcrossChunksIsReadWhole();
+    void closeCancelsRunningRequest();
+    void singleFrameReplyDoesNotWaitForSilence();
+};
+
+#endif // DEVICETESTS_DISPATCHERTESTS_H
@@ -0,0 +1,87 @@
+#include "FlatFieldCorrectionTests.h"
+
+#include <QtTest>
+
+#include <cmath>
+#include <limits>
+
+#include <Device/FlatFieldCorrection.h>
+
+#include "TestFrames.h"
+
+namespace {
+    // Single block of dark rows, so rates are summed in reference order
+    const int DARK_ROWS = 4;
+    const int ROWS = 3;
+
+    QVector<float> correctReference(const QVector<float> &img, const QVector<float> &dark,
+                                    int width, const QVector<float> &reciprocalGains)
+    {
+        QVector<float> rates(width);
+        for (int i = 0; i < width; ++i) {
+            double sum = 0;
+            for (int j = 0; j < DARK_ROWS; ++j) {
+                sum += static_cast<double>(dark.at(j * width + i));
+            }
+            rates[i] = static_cast<float>(sum / DARK_ROWS);
+        }
+
+        QVector<float> dst(img.size());
+        float min = 0;
+        for (int p = 0; p < img.size(); ++p) {
+            const int i = p % width;
+            dst[p] = std::ceil((img.at(p) - rates.at(i)) * reciprocalGains.at(i));
+            min = std::min(min, dst.at(p));
+        }
+
+        if (min < 0) {
+            for (auto &value : dst) {
+                value -= min;
+            }
+        }
+
+        return dst;
+    }
+}
+
+void FlatFieldCorrectionTests::correctMatchesReference_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<bool>("badGain");
+
+    // Widths cover AVX2 and SSE4.1 loops with every tail length
+    for (int width = 1; width <= 40; ++width) {
+        QTest::addRow("width %d", width) << width << false;
+        QTest::addRow("width %d bad gain", width) << width << true;
+    }
+}
+
+void FlatFieldCorrectionTests::correctMatchesReference()
+{
+    QFETCH(int, width);
+    QFETCH(bool, badGain);
+
+    const QVector<float> src = TestFrames::make(width, ROWS, 6);
+
+    // Dark rates above some pixels make corrected minimum negative
+    QVector<float> dark = TestFrames::make(width, DARK_ROWS, 7);
+    for (auto &value : dark) {
+        value *= 0.2f;
+    }
+
+    QVector<float> reciprocalGains = TestFrames::make(width, 1, 8);
+    for (auto &value : reciprocalGains) {
+        value = 1.f / (0.5f + value / TestFrames::maxPixelValue);
+    }
+
+    // NaN of bad gain lands in vector lane and must not become minimum
+    if (badGain) {
+        reciprocalGains[width / 2] = std::numeric_limits<float>::quiet_NaN();
+    }
+
+    QVector<float> img(src);
+    QVERIFY(FlatFieldCorrection::correct(img, dark, width, reciprocalGains));
+
+    const QByteArray error = TestFrames::mismatch(img, correctReference(src, dark, width, reciprocalGains), 0);
+    QVERIFY2(error.isEmpty(), error.constData());
+}
@@ -0,0 +1,18 @@
+#ifndef DEVICETESTS_FLATFIELDCORRECTIONTESTS_H
+#define DEVICETESTS_FLATFIELDCORRECTIONTESTS_H
+
+#include <QObject>
+
+/**
+ * Vectorized correction compared with scalar reference doing
+ * the same float operations, so results are bit-identical
+ **/
+class FlatFieldCorrectionTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void correctMatchesReference_data();
+    void correctMatchesReference();
+};
+
+#endif // DEVICETESTS_FLATFIELDCORRECTIONTESTS_H
@@ -0,0 +1,117 @@
+#include "FrameGeometryTests.h"
+
+#include <QtTest>
+
+#include <algorithm>
+
+#include <Device/FrameGeometry.h>
+
+#include "TestFrames.h"
+
+namespace {
+    /**
+     * Flips are applied first, then frame is rotated clockwise
+     **/
+    QVector<float> transformReference(const QVector<float> &src, int width, int height, bool flipHorizontal,
+                                      bool flipVertical, FrameGeometry::Rotation rotation)
+    {
+        const auto at = [&](int y, int x) {
+            return src.at((flipVertical ? height - 1 - y : y) * width + (flipHorizontal ? width - 1 - x : x));
+        };
+
+        const bool swapped = FrameGeometry::swapsSides(rotation);
+        const int dstWidth = swapped ? height : width;
+        const int dstHeight = swapped ? width : height;
+
+        QVector<float> dst(dstWidth * dstHeight);
+        for (int r = 0; r < dstHeight; ++r) {
+            for (int c = 0; c < dstWidth; ++c) {
+                float value = 0;
+                switch (rotation) {
+                case FrameGeometry::Rotate90: value = at(height - 1 - c, r); break;
+                case FrameGeometry::Rotate180: value = at(height - 1 - r, width - 1 - c); break;
+                case FrameGeometry::Rotate270: value = at(c, width - 1 - r); break;
+                default: value = at(r, c); break;
+                }
+                dst[r * dstWidth + c] = value;
+            }
+        }
+
+        return dst;
+    }
+}
+
+void FrameGeometryTests::reverseMatchesReference()
+{
+    // Counts cover AVX2 and SSE4.1 loops with every tail length
+    for (int count = 0; count <= 40; ++count) {
+        const QVector<float> src = TestFrames::make(count, 1, 4);
+        QVector<float> expected(src);
+        std::reverse(expected.begin(), expected.end());
+
+        QVector<float> dst(count);
+        FrameGeometry::reverse(src.constData(), dst.data(), count);
+        QCOMPARE(dst, expected);
+
+        QVector<float> inPlace(src);
+        FrameGeometry::reverse(inPlace.constData(), inPlace.data(), count);
+        QCOMPARE(inPlace, expected);
+    }
+}
+
+void FrameGeometryTests::transformMatchesReference_data()
+{
+    QTest::addColumn<int>("width");
+    QTest::addColumn<int>("height");
+    QTest::addColumn<bool>("flipHorizontal");
+    QTest::addColumn<bool>("flipVertical");
+    QTest::addColumn<int>("rotation");
+
+    // Sides over 32 pixels span several transposed tiles with tails
+    const QVector<QPair<int, int>> sizes = {{1, 1}, {1, 7}, {7, 1}, {3, 5}, {37, 33}, {70, 37}, {37, 70}};
+    for (const auto &size : sizes) {
+        for (const int rotation : {0, 90, 180, 270}) {
+            for (const bool flipHorizontal : {false, true}) {
+                for (const bool flipVertical : {false, true}) {
+                    QTest::addRow("%dx%d rotate %d%s%s", size.first, size.second, rotation,
+                                  flipHorizontal ? " flip h" : "", flipVertical ? " flip v" : "")
+                            << size.first << size.second << flipHorizontal << flipVertical << rotation;
+                }
+            }
+        }
+    }
+}
+
+void FrameGeometryTests::transformMatchesReference()
+{
+    QFETCH(int, width);
+    QFETCH(int, height);
+    QFETCH(bool, flipHorizontal);
+    QFETCH(bool, flipVertical);
+    QFETCH(int, rotation);
+
+    const auto frameRotation = FrameGeometry::rotationFromDegrees(rotation);
+    const QVector<float> src = TestFrames::make(width, height, 5);
+    const QVector<float> expected = transformReference(src, width, height, flipHorizontal,
+                                                       flipVertical, frameRotation);
+
+    QVector<float> dst(width * height);
+    FrameGeometry::transform(src.constData(), width, height, flipHorizontal, flipVertical,
+                             frameRotation, dst.data());
+    QCOMPARE(dst, expected);
+
+    if (FrameGeometry::swapsSides(frameRotation)) {
+        return;
+    }
+
+    QVector<float> inPlace(src);
+    FrameGeometry::transform(inPlace.constData(), width, height, flipHorizontal, flipVertical,
+                             frameRotation, inPlace.data());
+    QCOMPARE(inPlace, expected);
+
+    if (frameRotation == FrameGeometry::Rotate0) {
+        QVector<float> flipped(src);
+        FrameGeometry::flip(flipped.data(), width, height, flipHorizontal, flipVertical);
+        QCOMPARE(flipped, expected);
+    }
+}
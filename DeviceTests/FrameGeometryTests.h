@@ -0,0 +1,19 @@
+#ifndef DEVICETESTS_FRAMEGEOMETRYTESTS_H
+#define DEVICETESTS_FRAMEGEOMETRYTESTS_H
+
+#include <QObject>
+
+/**
+ * FrameGeometry flips and rotations compared with straightforward
+ * reference. Sides leave tails of vectorized loops and transpose tiles
+ **/
+class FrameGeometryTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void reverseMatchesReference();
+    void transformMatchesReference_data();
+    void transformMatchesReference();
+};
+
+#endif // DEVICETESTS_FRAMEGEOMETRYTESTS_H
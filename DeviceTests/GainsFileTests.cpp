@@ -0,0 +1,151 @@
+#include "GainsFileTests.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <Device/FlatFieldCorrection.h>
+
+namespace {
+    const QString GAINS_FILENAME = QStringLiteral("gains.bin");
+    const QString MODE_UUID = QStringLiteral("{3f2b8a61-5c1e-4d7a-9b0e-2a6c4e8d1f37}");
+    const QString OTHER_MODE_UUID = QStringLiteral("{a0d4e9c2-71b3-4f58-8e26-c5b1f7039d4a}");
+
+    const QByteArray GAINS_FILE_MAGIC("NPGAINS\0", 8);
+    const int GAINS_FILE_HEADER_SIZE = 48;
+
+    QByteArray readFile(const QString &filename)
+    {
+        QFile f(filename);
+        return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+    }
+
+    bool writeFile(const QString &filename, const QByteArray &data)
+    {
+        QFile f(filename);
+        return f.open(QIODevice::WriteOnly | QIODevice::Truncate) && f.write(data) == data.size();
+    }
+
+    /**
+     * Returns calibration date stored in header
+     **/
+    QDateTime saveGains(const QString &filename, const QString &scanningModeUuid)
+    {
+        FlatFieldCorrection ffc(filename, scanningModeUuid);
+        ffc.setCalibration({1.f, 2.f, -4.f, 0.5f});
+        return ffc.lastCalibrationDateTime();
+    }
+}
+
+void GainsFileTests::savedGainsAreLoaded()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath(GAINS_FILENAME);
+
+    const QDateTime calibration = saveGains(filename, MODE_UUID);
+
+    const QByteArray data = readFile(filename);
+    QCOMPARE(data.size(), GAINS_FILE_HEADER_SIZE + 4 * static_cast<int>(sizeof(float)));
+    QVERIFY(data.startsWith(GAINS_FILE_MAGIC));
+
+    // Date is read from header without loading gains
+    FlatFieldCorrection ffc(filename, MODE_UUID);
+    ffc.loadLastCalibrationDateTime();
+    QCOMPARE(ffc.lastCalibrationDateTime(), calibration);
+    QVERIFY(!ffc.isLoaded());
+
+    QVERIFY(ffc.load());
+    QCOMPARE(ffc.width(), 4);
+    QCOMPARE(ffc.reciprocalGains(), QVector<float>({1.f, 0.5f, 0.25f, 2.f}));
+}
+
+void GainsFileTests::legacyGainsAreMigrated()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath(GAINS_FILENAME);
+    QVERIFY(writeFile(filename, "3\n2\n4\n8\n"));
+
+    FlatFieldCorrection legacy(filename);
+    QVERIFY(legacy.load());
+    QCOMPARE(legacy.reciprocalGains(), QVector<float>({0.5f, 0.25f, 0.125f}));
+    QVERIFY(legacy.lastCalibrationDateTime().isValid());
+
+    const QByteArray data = readFile(filename);
+    QCOMPARE(data.size(), GAINS_FILE_HEADER_SIZE + 3 * static_cast<int>(sizeof(float)));
+    QVERIFY(data.startsWith(GAINS_FILE_MAGIC));
+
+    // Migrated file keeps gains and date of legacy calibration
+    FlatFieldCorrection migrated(filename);
+    QVERIFY(migrated.load());
+    QCOMPARE(migrated.reciprocalGains(), legacy.reciprocalGains());
+    QCOMPARE(migrated.lastCalibrationDateTime(), legacy.lastCalibrationDateTime());
+}
+
+void GainsFileTests::brokenLegacyGainsAreRejected()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath(GAINS_FILENAME);
+    const QByteArray legacyData("4\n2\n4\n8\n");
+    QVERIFY(writeFile(filename, legacyData));
+
+    FlatFieldCorrection ffc(filename);
+    QVERIFY(!ffc.load());
+    QVERIFY(!ffc.isLoaded());
+
+    // Broken file is not migrated
+    QCOMPARE(readFile(filename), legacyData);
+}
+
+void GainsFileTests::corruptedGainsAreRejected()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath(GAINS_FILENAME);
+    saveGains(filename, MODE_UUID);
+
+    QByteArray data = readFile(filename);
+    QVERIFY(data.size() > GAINS_FILE_HEADER_SIZE);
+    data[GAINS_FILE_HEADER_SIZE] = static_cast<char>(data.at(GAINS_FILE_HEADER_SIZE) ^ 0x01);
+    QVERIFY(writeFile(filename, data));
+
+    FlatFieldCorrection corrupted(filename, MODE_UUID);
+    corrupted.loadLastCalibrationDateTime();
+    QVERIFY(!corrupted.lastCalibrationDateTime().isValid());
+    QVERIFY(!corrupted.load());
+
+    data.chop(1);
+    QVERIFY(writeFile(filename, data));
+
+    FlatFieldCorrection truncated(filename, MODE_UUID);
+    QVERIFY(!truncated.load());
+}
+
+void GainsFileTests::foreignGainsAreRejected()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath(GAINS_FILENAME);
+    saveGains(filename, MODE_UUID);
+
+    FlatFieldCorrection foreign(filename, OTHER_MODE_UUID);
+    QVERIFY(!foreign.load());
+
+    // Mode is not checked if caller doesn't know it
+    FlatFieldCorrection unknown(filename);
+    QVERIFY(unknown.load());
+}
+
+void GainsFileTests::unsavedGainsAreReported()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Gains file can't be created in missing directory
+    FlatFieldCorrection ffc(dir.filePath(QStringLiteral("missing/") + GAINS_FILENAME), MODE_UUID);
+    QVERIFY(!ffc.setCalibration({1.f, 2.f, -4.f, 0.5f}));
+    QVERIFY(ffc.hasUnsavedGains());
+    QCOMPARE(ffc.width(), 4);
+}
@@ -0,0 +1,22 @@
+#ifndef DEVICETESTS_GAINSFILETESTS_H
+#define DEVICETESTS_GAINSFILETESTS_H
+
+#include <QObject>
+
+/**
+ * Binary gains file round trip, legacy text migration
+ * and rejection of broken or foreign files
+ **/
+class GainsFileTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void savedGainsAreLoaded();
+    void legacyGainsAreMigrated();
+    void brokenLegacyGainsAreRejected();
+    void corruptedGainsAreRejected();
+    void foreignGainsAreRejected();
+    void unsavedGainsAreReported();
+};
+
+#endif // DEVICETESTS_GAINSFILETESTS_H
@@ -0,0 +1,121 @@
+#include "LatencyHistogramTests.h"
+
+#include <QRunnable>
+#include <QThreadPool>
+#include <QtTest>
+
+#include <Device/LatencyHistogram.h>
+
+namespace {
+    const int RECORDING_THREADS = 4;
+    const int RECORDS_PER_THREAD = 1000;
+    const qint64 RECORD_STEP_US = 100;
+
+    class Recorder : public QRunnable
+    {
+    public:
+        explicit Recorder(LatencyHistogram &histogram) :
+            m_histogram(histogram)
+        {
+
+        }
+
+        void run() override
+        {
+            for (int i = 1; i <= RECORDS_PER_THREAD; ++i) {
+                m_histogram.record(i * RECORD_STEP_US);
+            }
+        }
+    private:
+        LatencyHistogram &m_histogram;
+    };
+}
+
+void LatencyHistogramTests::bucketIndex_data()
+{
+    QTest::addColumn<qint64>("us");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("zero") << qint64(0) << 0;
+    QTest::newRow("below first bound") << qint64(15) << 0;
+    QTest::newRow("first bound") << qint64(16) << 1;
+    QTest::newRow("below second bound") << qint64(31) << 1;
+    QTest::newRow("second bound") << qint64(32) << 2;
+    QTest::newRow("millisecond") << qint64(1000) << 6;
+    QTest::newRow("beyond last bound") << (qint64(1) << 40) << LatencyHistogram::bucketsCount - 1;
+}
+
+void LatencyHistogramTests::bucketIndex()
+{
+    QFETCH(qint64, us);
+    QFETCH(int, expected);
+
+    QCOMPARE(LatencyHistogram::bucketIndex(us), expected);
+}
+
+void LatencyHistogramTests::bucketBoundsAreContiguous()
+{
+    for (int bucket = 0; bucket < LatencyHistogram::bucketsCount - 1; ++bucket) {
+        const qint64 bound = LatencyHistogram::bucketUpperBoundUs(bucket);
+        QCOMPARE(LatencyHistogram::bucketIndex(bound - 1), bucket);
+        QCOMPARE(LatencyHistogram::bucketIndex(bound), bucket + 1);
+    }
+}
+
+void LatencyHistogramTests::snapshotSummarizesRecords()
+{
+    LatencyHistogram histogram;
+    for (qint64 us : {10, 20, 40, 1000, 5000}) {
+        histogram.record(us);
+    }
+    // Negative duration of clock going back is counted as zero
+    histogram.record(-5);
+
+    const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+    QCOMPARE(snapshot.count, quint64(6));
+    QCOMPARE(snapshot.totalUs, qint64(6070));
+    QCOMPARE(snapshot.maxUs, qint64(5000));
+    QCOMPARE(snapshot.meanUs(), qint64(1011));
+    QCOMPARE(snapshot.buckets.at(0), quint32(2));
+
+    // Percentile is reported as upper bound of its bucket, but never above max
+    QCOMPARE(snapshot.percentileUs(50), LatencyHistogram::bucketUpperBoundUs(1));
+    QCOMPARE(snapshot.percentileUs(100), qint64(5000));
+}
+
+void LatencyHistogramTests::concurrentRecordsAreCounted()
+{
+    LatencyHistogram histogram;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(RECORDING_THREADS);
+    for (int i = 0; i < RECORDING_THREADS; ++i) {
+        pool.start(new Recorder(histogram));
+    }
+    pool.waitForDone();
+
+    const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+    const quint64 count = RECORDING_THREADS * RECORDS_PER_THREAD;
+    QCOMPARE(snapshot.count, count);
+    QCOMPARE(snapshot.maxUs, RECORDS_PER_THREAD * RECORD_STEP_US);
+    QCOMPARE(snapshot.meanUs(), (RECORDS_PER_THREAD + 1) * RECORD_STEP_US / 2);
+
+    quint64 bucketsSum = 0;
+    for (quint32 bucket : snapshot.buckets) {
+        bucketsSum += bucket;
+    }
+    QCOMPARE(bucketsSum, count);
+}
+
+void LatencyHistogramTests::resetClearsRecords()
+{
+    LatencyHistogram histogram;
+    histogram.record(100);
+    histogram.reset();
+
+    const LatencyHistogram::Snapshot snapshot = histogram.snapshot();
+    QCOMPARE(snapshot.count, quint64(0));
+    QCOMPARE(snapshot.maxUs, qint64(0));
+    QCOMPARE(snapshot.meanUs(), qint64(0));
+    QCOMPARE(snapshot.percentileUs(99), qint64(0));
+}
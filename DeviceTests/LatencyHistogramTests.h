@@ -0,0 +1,21 @@
+#ifndef DEVICETESTS_LATENCYHISTOGRAMTESTS_H
+#define DEVICETESTS_LATENCYHISTOGRAMTESTS_H
+
+#include <QObject>
+
+/**
+ * Bucket bounds and snapshot statistics of LatencyHistogram
+ **/
+class LatencyHistogramTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void bucketIndex_data();
+    void bucketIndex();
+    void bucketBoundsAreContiguous();
+    void snapshotSummarizesRecords();
+    void concurrentRecordsAreCounted();
+    void resetClearsRecords();
+};
+
+#endif // DEVICETESTS_LATENCYHISTOGRAMTESTS_H
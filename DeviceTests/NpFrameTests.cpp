@@ -0,0 +1,125 @@
+#include "NpFrameTests.h"
+
+#include <QtTest>
+
+#include <Device/NpFrame.h>
+
+namespace {
+    // Test data takes values by reference, so class constant is copied
+    const int FRAME_SIZE = NpFrame::size;
+
+    const quint8 KNOWN_ADDR = 0x10;
+    const quint8 OTHER_KNOWN_ADDR = 0x20;
+    const quint8 UNKNOWN_ADDR = 0x30;
+
+    QByteArray frame(quint8 addr)
+    {
+        return NpFrame(addr, 0x78, 0x01, 0x02, 0x03).toByteArray();
+    }
+
+    QByteArray brokenFrame(quint8 addr)
+    {
+        QByteArray bytes = frame(addr);
+        bytes[FRAME_SIZE - 1] = static_cast<char>(bytes.at(FRAME_SIZE - 1) ^ 0x01);
+        return bytes;
+    }
+}
+
+void NpFrameTests::builtFrameIsValid()
+{
+    const NpFrame built(KNOWN_ADDR, 0x78, 0x01, 0x02, 0x03);
+    QVERIFY(built.isValid());
+
+    const QByteArray bytes = built.toByteArray();
+    QCOMPARE(bytes.size(), FRAME_SIZE);
+    QCOMPARE(static_cast<quint8>(bytes.at(FRAME_SIZE - 1)), quint8(KNOWN_ADDR ^ 0x78 ^ 0x01 ^ 0x02 ^ 0x03));
+
+    const NpFrame parsed(bytes);
+    QVERIFY(parsed.isValid());
+    QVERIFY(parsed == built);
+    QVERIFY(bytes == built);
+    QVERIFY(built == bytes);
+    QCOMPARE(parsed.addr(), KNOWN_ADDR);
+    QCOMPARE(parsed.reg3(), quint8(0x03));
+    QVERIFY(NpFrame::fromRawData(bytes.constData()) == built);
+}
+
+void NpFrameTests::invalidFrames_data()
+{
+    QTest::addColumn<QByteArray>("bytes");
+
+    const QByteArray known = frame(KNOWN_ADDR);
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("partial") << known.left(FRAME_SIZE - 1);
+    QTest::newRow("broken") << brokenFrame(KNOWN_ADDR);
+    QTest::newRow("too long") << known + known.left(1);
+}
+
+void NpFrameTests::invalidFrames()
+{
+    QFETCH(QByteArray, bytes);
+
+    const NpFrame parsed(bytes);
+    QVERIFY(!parsed.isValid());
+
+    // Too long bytes keep only frame size, but don't equal exact frame
+    QVERIFY(parsed != frame(KNOWN_ADDR));
+    QVERIFY(bytes != NpFrame(KNOWN_ADDR, 0x78, 0x01, 0x02, 0x03));
+    QVERIFY(parsed.toByteArray().size() <= FRAME_SIZE);
+}
+
+void NpFrameTests::readerWalksFrames()
+{
+    const QByteArray known = frame(KNOWN_ADDR);
+    const QByteArray otherKnown = frame(OTHER_KNOWN_ADDR);
+    const QByteArray bytes = known + otherKnown + known.left(2);
+
+    NpFrameReader reader(bytes);
+    QVERIFY(reader.hasNext());
+    QVERIFY(reader.next() == known);
+    QVERIFY(reader.next() == otherKnown);
+    QVERIFY(reader.hasNext());
+
+    const NpFrame trailing = reader.next();
+    QVERIFY(!trailing.isValid());
+    QCOMPARE(trailing.toByteArray(), known.left(2));
+    QVERIFY(!reader.hasNext());
+
+    QCOMPARE(NpFrameReader(bytes).last().toByteArray(), known.left(2));
+    QVERIFY(NpFrameReader(known + otherKnown).last() == otherKnown);
+    QVERIFY(!NpFrameReader(QByteArray()).last().isValid());
+
+    const QVector<NpFrame> frames = NpFrame::splitFrames(bytes);
+    QCOMPARE(frames.size(), 3);
+    QVERIFY(frames.at(1) == otherKnown);
+}
+
+void NpFrameTests::completeFramesSize_data()
+{
+    QTest::addColumn<QByteArray>("bytes");
+    QTest::addColumn<int>("expected");
+
+    const QByteArray known = frame(KNOWN_ADDR);
+
+    QTest::newRow("empty") << QByteArray() << 0;
+    QTest::newRow("partial") << known.left(FRAME_SIZE - 1) << 0;
+    QTest::newRow("frame") << known << FRAME_SIZE;
+    QTest::newRow("frame and partial") << known + known.left(2) << FRAME_SIZE;
+    QTest::newRow("coalesced") << known + frame(OTHER_KNOWN_ADDR) << 2 * FRAME_SIZE;
+    QTest::newRow("broken") << brokenFrame(KNOWN_ADDR) << 0;
+    QTest::newRow("unknown address") << frame(UNKNOWN_ADDR) << 0;
+    QTest::newRow("frame and broken") << known + brokenFrame(KNOWN_ADDR) + known << FRAME_SIZE;
+    QTest::newRow("frame and unknown address") << known + frame(UNKNOWN_ADDR) << FRAME_SIZE;
+}
+
+void NpFrameTests::completeFramesSize()
+{
+    QFETCH(QByteArray, bytes);
+    QFETCH(int, expected);
+
+    const int size = NpFrame::completeFramesSize(bytes, [](quint8 addr) {
+        return addr == KNOWN_ADDR || addr == OTHER_KNOWN_ADDR;
+    });
+    QCOMPARE(size, expected);
+}
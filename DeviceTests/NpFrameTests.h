@@ -0,0 +1,22 @@
+#ifndef DEVICETESTS_NPFRAMETESTS_H
+#define DEVICETESTS_NPFRAMETESTS_H
+
+#include <QObject>
+
+/**
+ * Frame validation, walking frames of buffer and
+ * recognition of complete frames in read buffer
+ **/
+class NpFrameTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void builtFrameIsValid();
+    void invalidFrames_data();
+    void invalidFrames();
+    void readerWalksFrames();
+    void completeFramesSize_data();
+    void completeFramesSize();
+};
+
+#endif // DEVICETESTS_NPFRAMETESTS_H
@@ -0,0 +1,146 @@
+#include "ResamplerTests.h"
+
+#include <QtTest>
+
+#include <opencv2/imgproc.hpp>
+
+#include <cmath>
+
+#include <Device/LineResampler.h>
+
+#include "TestFrames.h"
+
+namespace {
+    const int RESAMPLED_ROWS = 5;
+
+    double cubicReference(double x)
+    {
+        const double a = -0.75;
+        x = std::fabs(x);
+        if (x < 1) {
+            return (a + 2) * x * x * x - (a + 3) * x * x + 1;
+        }
+
+        if (x < 2) {
+            return a * x * x * x - 5 * a * x * x + 8 * a * x - 4 * a;
+        }
+
+        return 0;
+    }
+
+    double lanczosReference(double x)
+    {
+        const double pi = 3.14159265358979323846;
+        x = std::fabs(x);
+        if (x < 1e-9) {
+            return 1;
+        }
+
+        return x < 3 ? 3 * std::sin(pi * x) * std::sin(pi * x / 3) / (pi * pi * x * x) : 0;
+    }
+
+    /**
+     * Normalized kernel over line extended by edge pixels
+     **/
+    QVector<float> resampleReference(const QVector<float> &src, int srcWidth, int rows, int dstWidth,
+                                     LineResampler::Filter filter)
+    {
+        const double scale = static_cast<double>(srcWidth) / dstWidth;
+        const double stretch = filter == LineResampler::Lanczos3 ? qMax(1.0, scale) : 1.0;
+        const double support = (filter == LineResampler::Lanczos3 ? 3 : 2) * stretch;
+
+        QVector<float> dst(dstWidth * rows);
+        for (int row = 0; row < rows; ++row) {
+            for (int x = 0; x < dstWidth; ++x) {
+                const double center = (x + 0.5) * scale - 0.5;
+                double value = 0;
+                double sum = 0;
+                for (int i = qFloor(center - support); i <= qCeil(center + support); ++i) {
+                    const double distance = (i - center) / stretch;
+                    const double weight = filter == LineResampler::Lanczos3 ? lanczosReference(distance)
+                                                                            : cubicReference(distance);
+                    value += weight * src.at(row * srcWidth + qBound(0, i, srcWidth - 1));
+                    sum += weight;
+                }
+                dst[row * dstWidth + x] = static_cast<float>(value / sum);
+            }
+        }
+
+        return dst;
+    }
+}
+
+void ResamplerTests::matchesOpenCv_data()
+{
+    QTest::addColumn<int>("srcWidth");
+    QTest::addColumn<int>("dstWidth");
+
+    const QVector<QPair<int, int>> widths = {{64, 32}, {64, 100}, {37, 11}, {11, 37},
+                                             {5, 17}, {3, 8}, {130, 67}, {1001, 333}};
+    for (const auto &pair : widths) {
+        QTest::addRow("%d->%d", pair.first, pair.second) << pair.first << pair.second;
+    }
+}
+
+void ResamplerTests::matchesOpenCv()
+{
+    QFETCH(int, srcWidth);
+    QFETCH(int, dstWidth);
+
+    QVector<float> src = TestFrames::make(srcWidth, RESAMPLED_ROWS, 1);
+    QVector<float> dst(dstWidth * RESAMPLED_ROWS);
+
+    LineResampler resampler;
+    resampler.setGeometry(srcWidth, dstWidth, LineResampler::Cubic);
+    resampler.resample(src.constData(), RESAMPLED_ROWS, dst.data());
+
+    // Rows count is kept, so OpenCV filter is identity along columns
+    const cv::Mat srcMat(RESAMPLED_ROWS, srcWidth, CV_32FC1, src.data());
+    QVector<float> expected(dstWidth * RESAMPLED_ROWS);
+    cv::Mat dstMat(RESAMPLED_ROWS, dstWidth, CV_32FC1, expected.data());
+    cv::resize(srcMat, dstMat, dstMat.size(), 0, 0, cv::INTER_CUBIC);
+
+    const QByteArray error = TestFrames::mismatch(dst, expected, TestFrames::tolerance);
+    QVERIFY2(error.isEmpty(), error.constData());
+}
+
+void ResamplerTests::matchesReference_data()
+{
+    QTest::addColumn<int>("filter");
+    QTest::addColumn<int>("srcWidth");
+    QTest::addColumn<int>("dstWidth");
+
+    const QVector<QPair<int, int>> widths = {{1, 5}, {5, 1}, {7, 3}, {3, 7}, {37, 11},
+                                             {11, 37}, {130, 67}, {67, 130}};
+    for (const int filter : {LineResampler::Cubic, LineResampler::Lanczos3}) {
+        for (const auto &pair : widths) {
+            QTest::addRow("%s %d->%d", filter == LineResampler::Cubic ? "cubic" : "lanczos3",
+                          pair.first, pair.second) << filter << pair.first << pair.second;
+        }
+    }
+}
+
+void ResamplerTests::matchesReference()
+{
+    QFETCH(int, filter);
+    QFETCH(int, srcWidth);
+    QFETCH(int, dstWidth);
+
+    const auto resamplerFilter = static_cast<LineResampler::Filter>(filter);
+    const QVector<float> src = TestFrames::make(srcWidth, RESAMPLED_ROWS, 2);
+    QVector<float> dst(dstWidth * RESAMPLED_ROWS);
+
+    LineResampler resampler;
+    resampler.setGeometry(srcWidth, dstWidth, resamplerFilter);
+    resampler.resample(src.constData(), RESAMPLED_ROWS, dst.data());
+
+    const QVector<float> expected = resampleReference(src, srcWidth, RESAMPLED_ROWS, dstWidth, resamplerFilter);
+    QByteArray error = TestFrames::mismatch(dst, expected, TestFrames::tolerance);
+    QVERIFY2(error.isEmpty(), error.constData());
+
+    // Replicated edges keep constant line constant up to its ends
+    const QVector<float> flat(srcWidth * RESAMPLED_ROWS, TestFrames::maxPixelValue);
+    resampler.resample(flat.constData(), RESAMPLED_ROWS, dst.data());
+    error = TestFrames::mismatch(dst, QVector<float>(dst.size(), TestFrames::maxPixelValue), TestFrames::tolerance);
+    QVERIFY2(error.isEmpty(), error.constData());
+}
@@ -0,0 +1,20 @@
+#ifndef DEVICETESTS_RESAMPLERTESTS_H
+#define DEVICETESTS_RESAMPLERTESTS_H
+
+#include <QObject>
+
+/**
+ * LineResampler compared with OpenCV and with double precision
+ * reference. Widths are odd, so vectorized loops leave tails
+ **/
+class ResamplerTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void matchesOpenCv_data();
+    void matchesOpenCv();
+    void matchesReference_data();
+    void matchesReference();
+};
+
+#endif // DEVICETESTS_RESAMPLERTESTS_H
@@ -0,0 +1,147 @@
+#include "StepGraphTests.h"
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QThread>
+#include <QtTest>
+
+#include <Device/StepGraph.h>
+
+namespace {
+    // Steps waiting for each other fail instead of hanging the test
+    const int STEP_TIMEOUT_MS = 5000;
+    // Gives steps started too early time to see unfinished dependencies
+    const int STEP_DURATION_MS = 20;
+    // Deadline of hung step, far below the time it hangs for
+    const int HUNG_STEP_TIMEOUT_MS = 100;
+
+    StepGraph::ErrorFunc errorText(const QString &text)
+    {
+        return [text] { return text; };
+    }
+}
+
+void StepGraphTests::dependenciesFinishFirst()
+{
+    QAtomicInt finished[4];
+    QAtomicInt orderViolations;
+
+    const auto step = [&](int id, const QVector<int> &dependencies) {
+        return [&finished, &orderViolations, id, dependencies] {
+            for (int dependency : dependencies) {
+                if (!finished[dependency].loadRelaxed()) {
+                    orderViolations.fetchAndAddRelaxed(1);
+                }
+            }
+            QThread::msleep(STEP_DURATION_MS);
+            finished[id].storeRelaxed(1);
+            return true;
+        };
+    };
+
+    StepGraph graph;
+    const int first = graph.addStep(QStringLiteral("first"), step(0, {}), StepGraph::ErrorFunc());
+    const int left = graph.addStep(QStringLiteral("left"), step(1, {0}), StepGraph::ErrorFunc(), {first});
+    const int right = graph.addStep(QStringLiteral("right"), step(2, {0}), StepGraph::ErrorFunc(), {first});
+    graph.addStep(QStringLiteral("last"), step(3, {1, 2}), StepGraph::ErrorFunc(), {left, right});
+
+    QVERIFY(graph.run());
+    QVERIFY(graph.lastError().isEmpty());
+    QCOMPARE(orderViolations.loadRelaxed(), 0);
+    for (const auto &stepFinished : finished) {
+        QCOMPARE(stepFinished.loadRelaxed(), 1);
+    }
+}
+
+void StepGraphTests::independentStepsRunInParallel()
+{
+    QSemaphore leftStarted;
+    QSemaphore rightStarted;
+
+    // Each step waits for the other one, so both succeed only in parallel
+    StepGraph graph;
+    graph.addStep(QStringLiteral("left"), [&] {
+        leftStarted.release();
+        return rightStarted.tryAcquire(1, STEP_TIMEOUT_MS);
+    }, StepGraph::ErrorFunc());
+    graph.addStep(QStringLiteral("right"), [&] {
+        rightStarted.release();
+        return leftStarted.tryAcquire(1, STEP_TIMEOUT_MS);
+    }, StepGraph::ErrorFunc());
+
+    QVERIFY(graph.run());
+}
+
+void StepGraphTests::failureSkipsDependents()
+{
+    QAtomicInt dependentStarted;
+
+    StepGraph graph;
+    const int failing = graph.addStep(QStringLiteral("failing"), [] { return false; },
+                                      errorText(QStringLiteral("failing error")));
+    graph.addStep(QStringLiteral("dependent"), [&] {
+        dependentStarted.storeRelaxed(1);
+        return true;
+    }, StepGraph::ErrorFunc(), {failing});
+
+    QVERIFY(!graph.run());
+    QCOMPARE(graph.lastError(), QStringLiteral("failing error"));
+    QCOMPARE(dependentStarted.loadRelaxed(), 0);
+}
+
+void StepGraphTests::firstAddedErrorIsReported()
+{
+    QSemaphore laterFailed;
+    QAtomicInt firstFinished;
+
+    // Later step fails first, running first step is still waited for
+    StepGraph graph;
+    graph.addStep(QStringLiteral("first"), [&] {
+        laterFailed.tryAcquire(1, STEP_TIMEOUT_MS);
+        firstFinished.storeRelaxed(1);
+        return false;
+    }, errorText(QStringLiteral("first error")));
+    graph.addStep(QStringLiteral("later"), [&] {
+        laterFailed.release();
+        return false;
+    }, errorText(QStringLiteral("later error")));
+
+    QVERIFY(!graph.run());
+    QCOMPARE(graph.lastError(), QStringLiteral("first error"));
+    QCOMPARE(firstFinished.loadRelaxed(), 1);
+
+    // Step name is reported if there is no error function
+    StepGraph unnamed;
+    unnamed.addStep(QStringLiteral("unnamed"), [] { return false; }, StepGraph::ErrorFunc());
+    QVERIFY(!unnamed.run());
+    QCOMPARE(unnamed.lastError(), QStringLiteral("unnamed"));
+}
+
+void StepGraphTests::hungStepTimesOut()
+{
+    // Hung step outlives run(), so it owns what it waits on
+    const QSharedPointer<QSemaphore> release(new QSemaphore);
+    QAtomicInt dependentStarted;
+
+    StepGraph graph;
+    const int hung = graph.addStep(QStringLiteral("hung"), [release] {
+        return release->tryAcquire(1, STEP_TIMEOUT_MS);
+    }, errorText(QStringLiteral("hung error")), {}, HUNG_STEP_TIMEOUT_MS);
+    graph.addStep(QStringLiteral("dependent"), [&] {
+        dependentStarted.storeRelaxed(1);
+        return true;
+    }, StepGraph::ErrorFunc(), {hung});
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(!graph.run());
+    QVERIFY(timer.elapsed() < STEP_TIMEOUT_MS);
+    QVERIFY(graph.lastError().contains(QStringLiteral("hung")));
+    QVERIFY(graph.lastError().contains(QStringLiteral("hung error")));
+    QCOMPARE(dependentStarted.loadRelaxed(), 0);
+
+    // Abandoned step finishes once device call returns
+    release->release();
+}
@@ -0,0 +1,20 @@
+#ifndef DEVICETESTS_STEPGRAPHTESTS_H
+#define DEVICETESTS_STEPGRAPHTESTS_H
+
+#include <QObject>
+
+/**
+ * Order of steps and error reporting of StepGraph
+ **/
+class StepGraphTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void dependenciesFinishFirst();
+    void independentStepsRunInParallel();
+    void failureSkipsDependents();
+    void firstAddedErrorIsReported();
+    void hungStepTimesOut();
+};
+
+#endif // DEVICETESTS_STEPGRAPHTESTS_H
@@ -0,0 +1,38 @@
+#include "TestFrames.h"
+
+#include <cmath>
+
+constexpr float TestFrames::maxPixelValue;
+constexpr float TestFrames::tolerance;
+
+QVector<float> TestFrames::make(int width, int height, quint32 seed)
+{
+    QVector<float> frame(width * height);
+    quint32 state = seed;
+    for (auto &pixel : frame) {
+        state = state * 1664525u + 1013904223u;
+        pixel = maxPixelValue * (state >> 8) / 16777216.f;
+    }
+    return frame;
+}
+
+QByteArray TestFrames::mismatch(const QVector<float> &actual, const QVector<float> &expected, float tolerance)
+{
+    if (actual.size() != expected.size()) {
+        return QByteArray("size ") + QByteArray::number(actual.size()) +
+               " != " + QByteArray::number(expected.size());
+    }
+
+    for (int i = 0; i < actual.size(); ++i) {
+        if (std::isnan(actual.at(i)) && std::isnan(expected.at(i))) {
+            continue;
+        }
+
+        if (!(std::fabs(actual.at(i) - expected.at(i)) <= tolerance)) {
+            return QByteArray("pixel ") + QByteArray::number(i) + ": " +
+                   QByteArray::number(actual.at(i)) + " != " + QByteArray::number(expected.at(i));
+        }
+    }
+
+    return QByteArray();
+}
@@ -0,0 +1,28 @@
+#ifndef DEVICETESTS_TESTFRAMES_H
+#define DEVICETESTS_TESTFRAMES_H
+
+#include <QByteArray>
+#include <QVector>
+
+class TestFrames final
+{
+public:
+    static constexpr float maxPixelValue = 1000.f;
+    // Float sums of pixels up to maxPixelValue
+    static constexpr float tolerance = 1e-2f;
+
+    /**
+     * Deterministic frame, so failures are reproducible
+     **/
+    static QVector<float> make(int width, int height, quint32 seed);
+
+    /**
+     * Describes first pixel differing more than tolerance,
+     * empty string if there is none. NaN matches only NaN
+     **/
+    static QByteArray mismatch(const QVector<float> &actual, const QVector<float> &expected, float tolerance);
+private:
+    TestFrames() = delete;
+};
+
+#endif // DEVICETESTS_TESTFRAMES_H
@@ -0,0 +1,155 @@
+#include "TraceTests.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QWeakPointer>
+#include <QtTest>
+
+#include <Device/Trace.h>
+
+namespace {
+    const QString TRACE_NAME = QStringLiteral("Scan");
+    const QString COMPLETE_PHASE = QStringLiteral("X");
+    const QString METADATA_PHASE = QStringLiteral("M");
+    // Cyrillic "Step" in quotes, so span name needs escaping and UTF-8
+    const QString ESCAPED_SPAN_NAME = QString::fromUtf8("\xd0\xa8\xd0\xb0\xd0\xb3 \"1\"");
+
+    /**
+     * Empty array if JSON is malformed
+     **/
+    QJsonArray traceEvents(const Trace &trace)
+    {
+        QJsonParseError error;
+        const QJsonDocument document = QJsonDocument::fromJson(trace.toChromeJson(), &error);
+        if (error.error != QJsonParseError::NoError || !document.isObject()) {
+            return QJsonArray();
+        }
+
+        return document.object().value(QStringLiteral("traceEvents")).toArray();
+    }
+
+    QVector<QJsonObject> eventsOfPhase(const QJsonArray &events, const QString &phase)
+    {
+        QVector<QJsonObject> result;
+        for (const auto &event : events) {
+            if (event.toObject().value(QStringLiteral("ph")).toString() == phase) {
+                result.append(event.toObject());
+            }
+        }
+
+        return result;
+    }
+
+    class SpanRecorder : public QRunnable
+    {
+    public:
+        void run() override
+        {
+            Trace::Span span("pooled");
+        }
+    };
+}
+
+void TraceTests::cleanup()
+{
+    Trace::setCurrent(QSharedPointer<Trace>());
+}
+
+void TraceTests::spansAreExportedAsCompleteEvents()
+{
+    const auto trace = QSharedPointer<Trace>::create(TRACE_NAME);
+    Trace::setCurrent(trace);
+    {
+        Trace::Span outer("outer");
+        Trace::Span inner(ESCAPED_SPAN_NAME, "step");
+    }
+
+    const QJsonArray events = traceEvents(*trace);
+    QVERIFY(!events.isEmpty());
+
+    const QVector<QJsonObject> spans = eventsOfPhase(events, COMPLETE_PHASE);
+    QCOMPARE(spans.size(), 2);
+
+    // Inner span ends first, so it is recorded first
+    const QJsonObject inner = spans.at(0);
+    const QJsonObject outer = spans.at(1);
+    QCOMPARE(inner.value(QStringLiteral("name")).toString(), ESCAPED_SPAN_NAME);
+    QCOMPARE(inner.value(QStringLiteral("cat")).toString(), QStringLiteral("step"));
+    QCOMPARE(outer.value(QStringLiteral("name")).toString(), QStringLiteral("outer"));
+    QCOMPARE(outer.value(QStringLiteral("cat")).toString(), QStringLiteral("device"));
+
+    const double outerStart = outer.value(QStringLiteral("ts")).toDouble();
+    const double innerStart = inner.value(QStringLiteral("ts")).toDouble();
+    QVERIFY(outerStart <= innerStart);
+    QVERIFY(innerStart + inner.value(QStringLiteral("dur")).toDouble() <=
+            outerStart + outer.value(QStringLiteral("dur")).toDouble());
+    QCOMPARE(inner.value(QStringLiteral("tid")).toInt(), outer.value(QStringLiteral("tid")).toInt());
+
+    const QVector<QJsonObject> metadata = eventsOfPhase(events, METADATA_PHASE);
+    QVERIFY(!metadata.isEmpty());
+    QCOMPARE(metadata.at(0).value(QStringLiteral("name")).toString(), QStringLiteral("process_name"));
+    QCOMPARE(metadata.at(0).value(QStringLiteral("args")).toObject().value(QStringLiteral("name")).toString(),
+             TRACE_NAME);
+}
+
+void TraceTests::threadsAreNamed()
+{
+    const auto trace = QSharedPointer<Trace>::create(TRACE_NAME);
+    Trace::setCurrent(trace);
+    {
+        Trace::Span span("main");
+    }
+
+    QThreadPool pool;
+    pool.start(new SpanRecorder);
+    pool.waitForDone();
+
+    const QJsonArray events = traceEvents(*trace);
+    const QVector<QJsonObject> spans = eventsOfPhase(events, COMPLETE_PHASE);
+    QCOMPARE(spans.size(), 2);
+
+    const int mainThread = spans.at(0).value(QStringLiteral("tid")).toInt();
+    const int pooledThread = spans.at(1).value(QStringLiteral("tid")).toInt();
+    QVERIFY(mainThread != pooledThread);
+
+    QSet<int> namedThreads;
+    for (const auto &event : eventsOfPhase(events, METADATA_PHASE)) {
+        if (event.value(QStringLiteral("name")).toString() == QStringLiteral("thread_name") &&
+            !event.value(QStringLiteral("args")).toObject().value(QStringLiteral("name")).toString().isEmpty()) {
+            namedThreads.insert(event.value(QStringLiteral("tid")).toInt());
+        }
+    }
+    QCOMPARE(namedThreads, QSet<int>({mainThread, pooledThread}));
+}
+
+void TraceTests::spansWithoutCurrentTraceAreDropped()
+{
+    const auto trace = QSharedPointer<Trace>::create(TRACE_NAME);
+    {
+        Trace::Span span("dropped");
+    }
+
+    QVERIFY(eventsOfPhase(traceEvents(*trace), COMPLETE_PHASE).isEmpty());
+}
+
+void TraceTests::spanKeepsTraceAlive()
+{
+    auto trace = QSharedPointer<Trace>::create(TRACE_NAME);
+    const QWeakPointer<Trace> weakTrace = trace;
+    Trace::setCurrent(trace);
+
+    {
+        Trace::Span span("open");
+
+        // Trace finished while span of other thread is still open
+        Trace::setCurrent(QSharedPointer<Trace>());
+        trace.clear();
+        QVERIFY(!weakTrace.isNull());
+    }
+
+    QVERIFY(weakTrace.isNull());
+}
@@ -0,0 +1,21 @@
+#ifndef DEVICETESTS_TRACETESTS_H
+#define DEVICETESTS_TRACETESTS_H
+
+#include <QObject>
+
+/**
+ * Recording of spans and their Chrome trace event JSON
+ **/
+class TraceTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanup();
+
+    void spansAreExportedAsCompleteEvents();
+    void threadsAreNamed();
+    void spansWithoutCurrentTraceAreDropped();
+    void spanKeepsTraceAlive();
+};
+
+#endif // DEVICETESTS_TRACETESTS_H
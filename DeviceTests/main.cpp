@@ -0,0 +1,105 @@
+#include <QCoreApplication>
+#include <QProcess>
+#include <QtTest>
+
+#include <Device/CpuFeatures.h>
+
+#include "BinningTests.h"
+#include "DispatcherTests.h"
+#include "FlatFieldCorrectionTests.h"
+#include "FrameGeometryTests.h"
+#include "GainsFileTests.h"
+#include "LatencyHistogramTests.h"
+#include "NpFrameTests.h"
+#include "ResamplerTests.h"
+#include "StepGraphTests.h"
+#include "TraceTests.h"
+
+namespace {
+    const QString CPU_LEVEL_OPTION = QStringLiteral("--cpu-level");
+    const QString CPU_LEVEL_SCALAR = QStringLiteral("scalar");
+    const QString CPU_LEVEL_SSE41 = QStringLiteral("sse41");
+
+    /**
+     * Tests of kernels selected by instruction set
+     **/
+    int runKernelTests(const QStringList &arguments)
+    {
+        int failed = 0;
+
+        ResamplerTests resamplerTests;
+        failed += QTest::qExec(&resamplerTests, arguments);
+
+        FrameGeometryTests frameGeometryTests;
+        failed += QTest::qExec(&frameGeometryTests, arguments);
+
+        FlatFieldCorrectionTests flatFieldCorrectionTests;
+        failed += QTest::qExec(&flatFieldCorrectionTests, arguments);
+
+        return failed;
+    }
+
+    /**
+     * Tests run once at highest instruction set level
+     **/
+    int runTests(const QStringList &arguments)
+    {
+        int failed = 0;
+
+        BinningTests binningTests;
+        failed += QTest::qExec(&binningTests, arguments);
+
+        DispatcherTests dispatcherTests;
+        failed += QTest::qExec(&dispatcherTests, arguments);
+
+        GainsFileTests gainsFileTests;
+        failed += QTest::qExec(&gainsFileTests, arguments);
+
+        LatencyHistogramTests latencyHistogramTests;
+        failed += QTest::qExec(&latencyHistogramTests, arguments);
+
+        NpFrameTests npFrameTests;
+        failed += QTest::qExec(&npFrameTests, arguments);
+
+        StepGraphTests stepGraphTests;
+        failed += QTest::qExec(&stepGraphTests, arguments);
+
+        TraceTests traceTests;
+        failed += QTest::qExec(&traceTests, arguments);
+
+        return failed;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList arguments = app.arguments();
+
+    // Kernels are selected once per process, so lower instruction set
+    // levels are tested in child processes against the same references
+    const int levelIndex = arguments.indexOf(CPU_LEVEL_OPTION);
+    if (levelIndex > 0 && levelIndex + 1 < arguments.size()) {
+        const QString level = arguments.at(levelIndex + 1);
+        arguments.erase(arguments.begin() + levelIndex, arguments.begin() + levelIndex + 2);
+
+        CpuFeatures::setLimit(level == CPU_LEVEL_SCALAR ? CpuFeatures::Scalar : CpuFeatures::Sse41);
+        return runKernelTests(arguments);
+    }
+
+    int failed = runKernelTests(arguments) + runTests(arguments);
+
+    for (const auto &level : {CPU_LEVEL_SCALAR, CPU_LEVEL_SSE41}) {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedChannels);
+        process.start(QCoreApplication::applicationFilePath(),
+                      QStringList{CPU_LEVEL_OPTION, level} + arguments.mid(1));
+        if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit ||
+            process.exitCode() != 0) {
+            qWarning() << "Tests failed with CPU level" << level;
+            ++failed;
+        }
+    }
+
+    return failed;
+}
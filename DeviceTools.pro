@@ -0,0 +1,5 @@
+# Development tools built against Device library
+TEMPLATE = subdirs
+SUBDIRS += BusSimulator \
+    DeviceBenchmarks \
+    DeviceTests